@@ -0,0 +1,121 @@
+/**
+ * @file AllocationCounter.h
+ *
+ * @brief This file contains a heap allocation counter used to check that hot paths do not allocate.
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace dmlfs {
+
+namespace detail {
+
+inline std::atomic<std::size_t> g_allocation_count{0};
+inline std::atomic<bool> g_allocation_counting{false};
+
+inline void record_allocation() {
+  if (g_allocation_counting.load(std::memory_order_relaxed)) {
+    g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief RAII scope counting every heap allocation made while it is alive.
+ *
+ * Counting works by interposing the C allocation functions, which catches both
+ * `operator new` and Eigen's aligned allocations. The interposers are only
+ * defined in the single translation unit that defines
+ * `DMLFS_ALLOCATION_COUNTER_IMPLEMENTATION` before including this header,
+ * typically a test's main file. Without it, `count()` always returns zero.
+ *
+ * Scopes do not nest: creating one resets the global count. The interposers
+ * bypass sanitizer allocators, so do not enable them in sanitized builds.
+ *
+ * Example:
+ *
+ * @code
+ * #define DMLFS_ALLOCATION_COUNTER_IMPLEMENTATION
+ * #include "AllocationCounter.h"
+ *
+ * std::size_t allocations;
+ * {
+ *   AllocationCounter counter;
+ *   network.forward(input);
+ *   allocations = counter.count();
+ * }
+ * REQUIRE(allocations == 0);
+ * @endcode
+ */
+class AllocationCounter {
+public:
+  AllocationCounter() {
+    detail::g_allocation_count.store(0, std::memory_order_relaxed);
+    detail::g_allocation_counting.store(true, std::memory_order_relaxed);
+  }
+
+  ~AllocationCounter() {
+    detail::g_allocation_counting.store(false, std::memory_order_relaxed);
+  }
+
+  AllocationCounter(const AllocationCounter&) = delete;
+  AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+  /**
+   * @brief Number of allocations recorded since the scope was opened
+   */
+  std::size_t count() const {
+    return detail::g_allocation_count.load(std::memory_order_relaxed);
+  }
+};
+
+}  // namespace dmlfs
+
+#if defined(DMLFS_ALLOCATION_COUNTER_IMPLEMENTATION) && defined(__GLIBC__)
+
+#include <cerrno>
+#include <cstdlib>
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+void* malloc(std::size_t size) noexcept {
+  dmlfs::detail::record_allocation();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept {
+  dmlfs::detail::record_allocation();
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept {
+  dmlfs::detail::record_allocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+  dmlfs::detail::record_allocation();
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, std::size_t alignment, std::size_t size) noexcept {
+  dmlfs::detail::record_allocation();
+  *ptr = __libc_memalign(alignment, size);
+  return *ptr ? 0 : ENOMEM;
+}
+
+}  // extern "C"
+
+#endif /* DMLFS_ALLOCATION_COUNTER_IMPLEMENTATION */
+
+#endif /* ALLOCATIONCOUNTER_H */
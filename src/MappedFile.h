@@ -0,0 +1,134 @@
+/**
+ * @file MappedFile.h
+ *
+ * @brief This file contains an RAII wrapper around a memory-mapped file.
+ */
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dmlfs {
+
+/**
+ * @brief Whole file mapped into memory for as long as the object lives
+ *
+ * The mapping is private and copy-on-write: pages that are only read stay
+ * backed by the page cache, so every process mapping the same file shares
+ * them, while writes stay local to the process and never reach the file.
+ *
+ * Throws `std::runtime_error` if the file cannot be opened or mapped.
+ */
+class MappedFile {
+public:
+  /**
+   * @brief Map a file
+   * @param path Path of the file to map
+   */
+  explicit MappedFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat info{};
+    if (::fstat(fd, &info) != 0) {
+      const int error = errno;
+      ::close(fd);
+      throw std::runtime_error("Cannot stat " + path + ": " + std::strerror(error));
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+
+    if (m_size > 0) {
+      void* data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot map " + path + ": " + std::strerror(error));
+      }
+      m_data = static_cast<std::byte*>(data);
+    }
+
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept:
+      m_data{std::exchange(other.m_data, nullptr)},
+      m_size{std::exchange(other.m_size, 0)}
+  {
+  }
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      m_data = std::exchange(other.m_data, nullptr);
+      m_size = std::exchange(other.m_size, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Unmap the file
+   */
+  ~MappedFile() {
+    unmap();
+  }
+
+  /**
+   * @brief Start of the mapping, aligned to a page
+   */
+  std::byte* data() {
+    return m_data;
+  }
+
+  /**
+   * @brief Start of the mapping, aligned to a page
+   */
+  const std::byte* data() const {
+    return m_data;
+  }
+
+  /**
+   * @brief Size of the file in bytes
+   */
+  std::size_t size() const {
+    return m_size;
+  }
+
+private:
+  void unmap() {
+    if (m_data != nullptr) {
+      ::munmap(m_data, m_size);
+      m_data = nullptr;
+    }
+  }
+
+  /**
+   * @brief Start of the mapping, null for an empty file
+   */
+  std::byte* m_data = nullptr;
+
+  /**
+   * @brief Size of the mapping in bytes
+   */
+  std::size_t m_size = 0;
+};
+
+}  // namespace dmlfs
+
+#endif /* MAPPEDFILE_H */
@@ -0,0 +1,114 @@
+/**
+ * @file bench_batching.cpp
+ *
+ * @brief Latency and throughput of the dynamic batching server under load.
+ *
+ * Usage: bench_batching [clients] [workers] [seconds]
+ *
+ * Serves a 784-512-256-10 ReLU MLP in `float`. Each of `clients` threads runs
+ * a closed loop: submit one sample, wait for its output, repeat. For each
+ * combination of maximum batch size and maximum wait, runs the load for
+ * `seconds` and prints the median and 99th percentile latency of a request,
+ * the throughput, and the average size of the batches actually run. The
+ * first line is the baseline where every client calls `Network::predict`
+ * on its own sample, without batching.
+ */
+
+#include "network/batching_server.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+using Scalar = float;
+using Clock = std::chrono::steady_clock;
+using Vector = Eigen::VectorX<Scalar>;
+
+constexpr int kPool = 256;
+
+struct Result {
+  double p50;         ///< Median latency, in microseconds
+  double p99;         ///< 99th percentile latency, in microseconds
+  double throughput;  ///< Requests per second
+};
+
+/**
+ * @brief Run `clients` closed-loop clients for `seconds`, each calling `request` with a sample index
+ */
+Result load(int clients, double seconds, const std::function<void(int, int)>& request) {
+  std::vector<std::vector<double>> latencies(static_cast<std::size_t>(clients));
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+
+  const auto start = Clock::now();
+  for (int c = 0; c < clients; ++c) {
+    threads.emplace_back([&, c]() {
+      for (int i = c; !stop.load(std::memory_order_relaxed); i += clients) {
+        const auto sent = Clock::now();
+        request(c, i % kPool);
+        latencies[c].push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent).count());
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> all;
+  for (const auto& l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  const auto percentile = [&](double p) {
+    return all[std::min(all.size() - 1, static_cast<std::size_t>(p * static_cast<double>(all.size())))];
+  };
+  return {percentile(0.50), percentile(0.99), static_cast<double>(all.size()) / elapsed};
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int clients = argc > 1 ? std::atoi(argv[1]) : 64;
+  const int workers = argc > 2 ? std::atoi(argv[2]) : 2;
+  const double seconds = argc > 3 ? std::atof(argv[3]) : 1.0;
+
+  const Network<Scalar> network = make_mlp<Scalar>({784, 512, 256, 10}, {Activation<>::Type::RELU, Activation<>::Type::RELU, Activation<>::Type::NONE});
+  const Eigen::MatrixX<Scalar> samples = Eigen::MatrixX<Scalar>::Random(784, kPool);
+
+  std::printf("%d clients, %d workers\n", clients, workers);
+  std::printf("%10s %10s %12s %12s %14s %12s\n", "max batch", "max wait", "p50 us", "p99 us", "requests/sec", "avg batch");
+
+  std::vector<InferenceContext<Scalar>> contexts(static_cast<std::size_t>(clients));
+  const Result direct = load(clients, seconds, [&](int c, int i) {
+    network.predict(samples.col(i), contexts[c]);
+  });
+  std::printf("%10s %10s %12.1f %12.1f %14.0f %12s\n", "direct", "-", direct.p50, direct.p99, direct.throughput, "1.0");
+
+  for (const Eigen::Index maxBatchSize : {8, 32, 128}) {
+    for (const int waitUs : {50, 200, 1000}) {
+      BatchingServer<Scalar> server(network, maxBatchSize, std::chrono::microseconds{waitUs}, workers);
+      const Result result = load(clients, seconds, [&](int, int i) {
+        server.submit(samples.col(i)).get();
+      });
+      std::printf("%10ld %8dus %12.1f %12.1f %14.0f %12.1f\n", static_cast<long>(maxBatchSize), waitUs,
+                  result.p50, result.p99, result.throughput,
+                  static_cast<double>(server.requests()) / static_cast<double>(std::max<std::uint64_t>(1, server.batches())));
+    }
+  }
+  return 0;
+}
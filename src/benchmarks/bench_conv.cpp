@@ -0,0 +1,110 @@
+/**
+ * @file bench_conv.cpp
+ *
+ * @brief Training throughput of the native `Conv2D` against libtorch on the `mnist_conv` convolutions.
+ *
+ * Usage: bench_conv [batch_size] [iterations]
+ *
+ * Runs forward and backward passes through the two convolutions of
+ * `tests/mnist_conv.cpp`: 1 to 10 channels with 5x5 kernels on 28x28 images,
+ * then 10 to 20 channels with 5x5 kernels on the 12x12 pooled maps. Prints
+ * the images per second of each layer. When built with `DMLFS_WITH_TORCH`,
+ * the same passes are timed through `torch::nn::Conv2d` for comparison.
+ */
+
+#include "network/conv2d.h"
+
+#include "Eigen/Dense"
+
+#ifdef DMLFS_WITH_TORCH
+#include <torch/torch.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace dmlfs;
+
+namespace {
+
+using Scalar = float;
+using Matrix = Eigen::MatrixX<Scalar>;
+using Clock = std::chrono::steady_clock;
+
+struct ConvShape {
+  const char* name;
+  int inChannels;
+  int size;
+  int outChannels;
+  int kernelSize;
+};
+
+constexpr ConvShape kShapes[] = {
+  {"conv1", 1, 28, 10, 5},
+  {"conv2", 10, 12, 20, 5},
+};
+
+double native_images_per_second(const ConvShape& shape, int batchSize, int iterations) {
+  Conv2D<Scalar> layer(shape.inChannels, shape.size, shape.size, shape.outChannels, shape.kernelSize, 1, 0,
+                       Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+  const Matrix input = Matrix::Random(layer.inputSize(), batchSize);
+  const Matrix dOutput = Matrix::Random(layer.outputSize(), batchSize);
+
+  // Warm-up pass sizes every workspace.
+  layer.forward(input);
+  layer.backward(dOutput);
+
+  const auto start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    layer.forward(input);
+    layer.backward(dOutput);
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return static_cast<double>(batchSize) * iterations / seconds;
+}
+
+#ifdef DMLFS_WITH_TORCH
+double torch_images_per_second(const ConvShape& shape, int batchSize, int iterations) {
+  torch::nn::Conv2d layer(torch::nn::Conv2dOptions(shape.inChannels, shape.outChannels, shape.kernelSize));
+  torch::Tensor input = torch::randn({batchSize, shape.inChannels, shape.size, shape.size}).requires_grad_(true);
+
+  auto step = [&]() {
+    torch::Tensor output = torch::relu(layer->forward(input));
+    output.backward(torch::ones_like(output));
+  };
+  step();
+
+  const auto start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    step();
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return static_cast<double>(batchSize) * iterations / seconds;
+}
+#endif
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int batchSize = argc > 1 ? std::atoi(argv[1]) : 64;
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 50;
+
+#ifdef DMLFS_WITH_TORCH
+  std::printf("%8s %16s %16s %10s\n", "layer", "native img/s", "torch img/s", "ratio");
+#else
+  std::printf("%8s %16s\n", "layer", "native img/s");
+#endif
+
+  for (const ConvShape& shape : kShapes) {
+    const double native = native_images_per_second(shape, batchSize, iterations);
+#ifdef DMLFS_WITH_TORCH
+    const double reference = torch_images_per_second(shape, batchSize, iterations);
+    std::printf("%8s %16.0f %16.0f %10.2f\n", shape.name, native, reference, reference / native);
+#else
+    std::printf("%8s %16.0f\n", shape.name, native);
+#endif
+  }
+
+  return 0;
+}
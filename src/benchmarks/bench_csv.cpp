@@ -0,0 +1,94 @@
+/**
+ * @file bench_csv.cpp
+ *
+ * @brief Throughput of the numeric CSV fast path against the generic `read_csv`.
+ *
+ * Usage: bench_csv [rows] [columns]
+ *
+ * Writes a random numeric CSV with a header and a label column to a temporary
+ * file, then loads it into a features x samples matrix both with `read_csv`
+ * followed by `std::stod`, and with `read_numeric_csv`. Prints the time and
+ * throughput of each.
+ */
+
+#include "datautils/csv.h"
+
+#include "Eigen/Dense"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+Eigen::MatrixXd read_with_getline(const std::string& path) {
+  auto rows = read_csv(path);
+  const Eigen::Index nSamples = static_cast<Eigen::Index>(rows.size()) - 1;
+  const Eigen::Index nFeatures = static_cast<Eigen::Index>(rows.front().size()) - 1;
+
+  Eigen::MatrixXd features(nFeatures, nSamples);
+  for (Eigen::Index j = 0; j < nSamples; ++j) {
+    for (Eigen::Index i = 0; i < nFeatures; ++i) {
+      features(i, j) = std::stod(rows[j + 1][i + 1]);
+    }
+  }
+  return features;
+}
+
+template <typename Function>
+double seconds(Function&& function) {
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int nRows = argc > 1 ? std::atoi(argv[1]) : 200000;
+  const int nColumns = argc > 2 ? std::atoi(argv[2]) : 32;
+
+  const std::string path = (std::filesystem::temp_directory_path() / "dmlfs_bench.csv").string();
+  {
+    std::ofstream file{path};
+    file << "label";
+    for (int c = 0; c < nColumns; ++c) {
+      file << ",f" << c;
+    }
+    file << '\n';
+
+    const Eigen::MatrixXd values = Eigen::MatrixXd::Random(nColumns, nRows);
+    char buffer[32];
+    for (int j = 0; j < nRows; ++j) {
+      file << (j % 10);
+      for (int c = 0; c < nColumns; ++c) {
+        std::snprintf(buffer, sizeof(buffer), ",%.9g", values(c, j));
+        file << buffer;
+      }
+      file << '\n';
+    }
+  }
+  const double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1 << 20);
+
+  Eigen::MatrixXd slow;
+  const double slowSeconds = seconds([&] { slow = read_with_getline(path); });
+
+  NumericCsv<double> fast;
+  const double fastSeconds = seconds([&] { fast = read_numeric_csv<double>(path, {0}); });
+
+  std::printf("%d rows x %d columns, %.1f MB\n", nRows, nColumns + 1, megabytes);
+  std::printf("%18s %10s %10s\n", "parser", "seconds", "MB/s");
+  std::printf("%18s %10.3f %10.1f\n", "read_csv + stod", slowSeconds, megabytes / slowSeconds);
+  std::printf("%18s %10.3f %10.1f\n", "read_numeric_csv", fastSeconds, megabytes / fastSeconds);
+  std::printf("speedup: %.1fx, results %s\n", slowSeconds / fastSeconds,
+              slow.isApprox(fast.features) ? "match" : "DIFFER");
+
+  std::filesystem::remove(path);
+  return 0;
+}
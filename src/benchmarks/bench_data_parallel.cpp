@@ -0,0 +1,81 @@
+/**
+ * @file bench_data_parallel.cpp
+ *
+ * @brief Scaling curve of data-parallel training throughput with the number of threads.
+ *
+ * Usage: bench_data_parallel [max_threads] [batch_size] [epochs]
+ *
+ * Trains a 784-512-256-10 MLP on random data for each thread count from 1 to
+ * `max_threads` (doubling, plus `max_threads` itself) and prints the
+ * throughput, the speedup over one thread and the parallel efficiency.
+ */
+
+#include "network/loss_functions.h"
+#include "network/trainer.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include <omp.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+using Scalar = float;
+using Matrix = Eigen::MatrixX<Scalar>;
+
+double samples_per_second(int nThreads, int batchSize, int nEpochs, const Matrix& features, const Matrix& labels) {
+  Network<Scalar> network = make_mlp<Scalar>({784, 512, 256, 10}, {Activation<>::Type::RELU, Activation<>::Type::RELU, Activation<>::Type::NONE});
+  SGD<Scalar> optimizer(1e-3f);
+  Trainer<Scalar> trainer(network, optimizer,
+                          meanSquaredError<Scalar>, meanSquaredErrorDerivative<Scalar>,
+                          batchSize, Trainer<Scalar>::Shuffle::BATCHES, 0);
+  trainer.setNumThreads(nThreads);
+
+  // Warm-up epoch sizes every workspace.
+  trainer.trainEpoch(features, labels);
+
+  double total = 0.0;
+  for (const EpochStats& stats : trainer.train(features, labels, nEpochs)) {
+    total += stats.samplesPerSecond;
+  }
+  return total / nEpochs;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int maxThreads = argc > 1 ? std::atoi(argv[1]) : omp_get_max_threads();
+  const int batchSize = argc > 2 ? std::atoi(argv[2]) : 512;
+  const int nEpochs = argc > 3 ? std::atoi(argv[3]) : 3;
+
+  // Each worker runs its own single-threaded GEMMs.
+  Eigen::setNbThreads(1);
+
+  const Matrix features = Matrix::Random(784, 16 * batchSize);
+  const Matrix labels = Matrix::Random(10, 16 * batchSize);
+
+  std::vector<int> threadCounts;
+  for (int t = 1; t < maxThreads; t *= 2) {
+    threadCounts.push_back(t);
+  }
+  threadCounts.push_back(maxThreads);
+
+  std::printf("%8s %16s %10s %12s\n", "threads", "samples/sec", "speedup", "efficiency");
+  double baseline = 0.0;
+  for (int nThreads : threadCounts) {
+    const double throughput = samples_per_second(nThreads, batchSize, nEpochs, features, labels);
+    if (nThreads == 1) {
+      baseline = throughput;
+    }
+    const double speedup = throughput / baseline;
+    std::printf("%8d %16.0f %10.2f %11.0f%%\n", nThreads, throughput, speedup, 100.0 * speedup / nThreads);
+  }
+
+  return 0;
+}
@@ -0,0 +1,313 @@
+/**
+ * @file bench_micro.cpp
+ *
+ * @brief Micro-benchmarks of the hot paths, reported as GFLOP/s and GB/s.
+ *
+ * Usage: bench_micro [Catch2 options, e.g. --benchmark-samples 20 "[layer]"]
+ *
+ * Times `Layer::forward` and `Layer::backward` over a grid of layer and batch
+ * sizes, every activation function and its derivative, every loss in
+ * `loss_functions.h`, the optimizers' updates, and the CSV readers, with
+ * Catch2's `BENCHMARK`. Each benchmark declares the floating point operations
+ * and the bytes of memory traffic of one call, from which the mean time gives
+ * the throughput. Transcendental functions count as one operation, and the
+ * traffic is the minimum one, each operand read or written once.
+ *
+ * Besides Catch2's own report, prints a throughput table and writes it as
+ * JSON to the file named by `DMLFS_BENCHMARK_JSON`, `benchmark_results.json`
+ * by default. `compare_benchmarks.py` checks such a file against a baseline.
+ */
+
+#include "datautils/csv.h"
+#include "network/activation.h"
+#include "network/loss_functions.h"
+#include "network/optimizer.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/benchmark/catch_benchmark.hpp"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/reporters/catch_reporter_event_listener.hpp"
+#include "catch2/reporters/catch_reporter_registrars.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+using Scalar = float;
+using Matrix = Eigen::MatrixX<Scalar>;
+using Vector = Eigen::VectorX<Scalar>;
+
+/**
+ * @brief Cost of one call of a benchmark
+ */
+struct Work {
+  double flops;  ///< Floating point operations
+  double bytes;  ///< Bytes read and written
+};
+
+std::map<std::string, Work>& registry() {
+  static std::map<std::string, Work> works;
+  return works;
+}
+
+/**
+ * @brief Record the cost of a benchmark, and return its name for `BENCHMARK`
+ */
+std::string work(const std::string& name, double flops, double bytes) {
+  registry()[name] = {flops, bytes};
+  return name;
+}
+
+/**
+ * @brief Bytes taken by `count` scalars
+ */
+double bytes(double count) {
+  return count * sizeof(Scalar);
+}
+
+/**
+ * @brief Collects the mean time of every benchmark, then reports the throughputs
+ */
+class ThroughputListener: public Catch::EventListenerBase {
+public:
+  using Catch::EventListenerBase::EventListenerBase;
+
+  void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+    const auto found = registry().find(stats.info.name);
+    const Work cost = found != registry().end() ? found->second : Work{0, 0};
+    const double ns = stats.mean.point.count();
+    m_results.push_back({stats.info.name, ns, stats.standardDeviation.point.count(), cost.flops / ns, cost.bytes / ns});
+  }
+
+  void testRunEnded(const Catch::TestRunStats&) override {
+    if (m_results.empty()) {
+      return;
+    }
+
+    std::printf("\n%-48s %12s %10s %10s\n", "benchmark", "mean us", "GFLOP/s", "GB/s");
+    for (const auto& result : m_results) {
+      std::printf("%-48s %12.2f %10.2f %10.2f\n", result.name.c_str(), result.meanNs / 1e3, result.gflops, result.gbps);
+    }
+
+    const char* path = std::getenv("DMLFS_BENCHMARK_JSON");
+    const std::string output = path != nullptr ? path : "benchmark_results.json";
+    std::ofstream ofs{output};
+    ofs << "{\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < m_results.size(); ++i) {
+      const auto& result = m_results[i];
+      ofs << "    {\"name\": \"" << result.name << "\", \"mean_ns\": " << result.meanNs
+          << ", \"stddev_ns\": " << result.stddevNs << ", \"gflops\": " << result.gflops
+          << ", \"gbps\": " << result.gbps << "}" << (i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+    ofs << "  ]\n}\n";
+    std::printf("\nWrote %s\n", output.c_str());
+  }
+
+private:
+  struct Result {
+    std::string name;
+    double meanNs;
+    double stddevNs;
+    double gflops;  ///< Operations per nanosecond, i.e. GFLOP/s
+    double gbps;    ///< Bytes per nanosecond, i.e. GB/s
+  };
+
+  std::vector<Result> m_results;
+};
+
+/**
+ * @brief Operations per element of an activation function
+ */
+struct ActivationCost {
+  double forward;     ///< Of the function
+  double derivative;  ///< Of its derivative, from the pre-activations
+  double backward;    ///< Of the fused backward kernel, from the activations and incoming gradient
+};
+
+ActivationCost activation_cost(ActivationBase::Type type) {
+  switch (type) {
+    case ActivationBase::Type::RELU:
+      return {1, 1, 2};
+    case ActivationBase::Type::SIGMOID:
+      return {3, 5, 3};
+    case ActivationBase::Type::TANH:
+      return {1, 3, 3};
+    case ActivationBase::Type::NONE:
+    default:
+      return {0, 0, 0};
+  }
+}
+
+const char* activation_name(ActivationBase::Type type) {
+  switch (type) {
+    case ActivationBase::Type::RELU:
+      return "relu";
+    case ActivationBase::Type::SIGMOID:
+      return "sigmoid";
+    case ActivationBase::Type::TANH:
+      return "tanh";
+    case ActivationBase::Type::NONE:
+    default:
+      return "none";
+  }
+}
+
+}  // namespace
+
+CATCH_REGISTER_LISTENER(ThroughputListener)
+
+TEST_CASE("Dense layer forward and backward", "[benchmark][layer]") {
+  const std::pair<int, int> shapes[] = {{64, 64}, {256, 256}, {784, 512}, {1024, 1024}};
+  for (const auto& [inputs, outputs] : shapes) {
+    for (const int batch : {1, 32, 256}) {
+      Layer<Scalar> layer(inputs, outputs, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+      Layer<Scalar>::Workspace workspace;
+      const Matrix input = Matrix::Random(inputs, batch);
+      const Matrix dOutput = Matrix::Random(outputs, batch);
+      Vector gradients(layer.parameterCount());
+      layer.forward(input, workspace);
+
+      const std::string shape = std::to_string(inputs) + "x" + std::to_string(outputs) + " batch " + std::to_string(batch);
+      const double weights = static_cast<double>(inputs) * outputs;
+      const double in = static_cast<double>(inputs) * batch;
+      const double out = static_cast<double>(outputs) * batch;
+
+      BENCHMARK(work("Layer::forward " + shape, 2 * weights * batch + 2 * out, bytes(weights + outputs + in + out))) {
+        return layer.forward(input, workspace).data();
+      };
+      BENCHMARK(work("Layer::backward " + shape, 4 * weights * batch + 2 * out, bytes(2 * (weights + outputs) + 2 * in + 2 * out))) {
+        return layer.backward(dOutput, workspace, gradients).data();
+      };
+    }
+  }
+}
+
+TEST_CASE("Activation functions and derivatives", "[benchmark][activation]") {
+  const Matrix input = Matrix::Random(1024, 256);
+  const Matrix biases = Matrix::Random(1024, 1);
+  const double size = static_cast<double>(input.size());
+  Matrix output(input.rows(), input.cols());
+  Matrix z = input;
+  Matrix dZ(input.rows(), input.cols());
+
+  for (const auto type : {ActivationBase::Type::NONE, ActivationBase::Type::RELU,
+                          ActivationBase::Type::SIGMOID, ActivationBase::Type::TANH}) {
+    std::unique_ptr<Activation<Scalar>> activation;
+    Activation<Scalar>::set(type, activation);
+    const ActivationCost cost = activation_cost(type);
+    const std::string name = activation_name(type);
+
+    BENCHMARK(work("Activation " + name, cost.forward * size, bytes(2 * size))) {
+      (*activation)(input, output);
+      return output.data();
+    };
+    BENCHMARK(work("Activation " + name + " derivative", cost.derivative * size, bytes(2 * size))) {
+      activation->derivative(input, output);
+      return output.data();
+    };
+    BENCHMARK(work("FusedActivation::forward " + name, (cost.forward + 1) * size, bytes(2 * size))) {
+      FusedActivation<Scalar>::forward(type, z, biases);
+      return z.data();
+    };
+    BENCHMARK(work("FusedActivation::backward " + name, cost.backward * size, bytes(3 * size))) {
+      FusedActivation<Scalar>::backward(type, output, input, dZ);
+      return dZ.data();
+    };
+  }
+}
+
+TEST_CASE("Loss functions and derivatives", "[benchmark][loss]") {
+  const Matrix y = (Matrix::Random(10, 4096).array() > 0).cast<Scalar>();
+  const Matrix yHat = (Matrix::Random(10, 4096).array() * Scalar(0.45) + Scalar(0.5)).matrix();
+  const double size = static_cast<double>(y.size());
+  Matrix gradient(y.rows(), y.cols());
+
+  BENCHMARK(work("meanSquaredError", 3 * size, bytes(2 * size))) {
+    return meanSquaredError(y, yHat);
+  };
+  BENCHMARK(work("meanSquaredErrorDerivative", 2 * size, bytes(3 * size))) {
+    return meanSquaredErrorDerivative(y, yHat);
+  };
+  BENCHMARK(work("crossEntropy", 4 * size, bytes(2 * size))) {
+    return crossEntropy(y, yHat);
+  };
+  BENCHMARK(work("crossEntropyDerivative", 3 * size, bytes(3 * size))) {
+    return crossEntropyDerivative(y, yHat);
+  };
+  BENCHMARK(work("binaryCrossEntropy", 9 * size, bytes(2 * size))) {
+    return binaryCrossEntropy(y, yHat);
+  };
+  BENCHMARK(work("binaryCrossEntropyDerivative", 7 * size, bytes(3 * size))) {
+    return binaryCrossEntropyDerivative(y, yHat);
+  };
+  BENCHMARK(work("softmaxCrossEntropy", 8 * size, bytes(3 * size))) {
+    return softmaxCrossEntropy(y, yHat, gradient);
+  };
+}
+
+TEST_CASE("Optimizer updates", "[benchmark][optimizer]") {
+  Network<Scalar> network = make_mlp<Scalar>({784, 512, 256, 10}, {Activation<>::Type::RELU, Activation<>::Type::RELU, Activation<>::Type::NONE});
+  const double size = static_cast<double>(network.parameters().size());
+
+  SGD<Scalar> sgd(Scalar(1e-3));
+  BENCHMARK(work("SGD::update", 2 * size, bytes(3 * size))) {
+    sgd.update(network);
+    return network.parameters().data();
+  };
+
+  Momentum<Scalar> momentum(Scalar(1e-3), Scalar(0.9));
+  momentum.prepare(network);
+  BENCHMARK(work("Momentum::update", 4 * size, bytes(5 * size))) {
+    momentum.update(network);
+    return network.parameters().data();
+  };
+
+  Adam<Scalar> adam(Scalar(1e-3));
+  adam.prepare(network);
+  BENCHMARK(work("Adam::update", 14 * size, bytes(7 * size))) {
+    adam.update(network);
+    return network.parameters().data();
+  };
+}
+
+TEST_CASE("CSV readers", "[benchmark][csv]") {
+  const int nRows = 20000;
+  const int nColumns = 10;
+  const std::string path = (std::filesystem::temp_directory_path() / "dmlfs_bench_micro.csv").string();
+  {
+    std::ofstream ofs{path};
+    for (int c = 0; c < nColumns; ++c) {
+      ofs << "c" << c << (c + 1 < nColumns ? "," : "\n");
+    }
+    const Eigen::MatrixXd values = Eigen::MatrixXd::Random(nColumns, nRows);
+    char buffer[32];
+    for (int r = 0; r < nRows; ++r) {
+      for (int c = 0; c < nColumns; ++c) {
+        std::snprintf(buffer, sizeof(buffer), "%.6g", values(c, r));
+        ofs << buffer << (c + 1 < nColumns ? "," : "\n");
+      }
+    }
+  }
+  const double fileBytes = static_cast<double>(std::filesystem::file_size(path));
+  const double values = static_cast<double>(nRows) * nColumns;
+
+  BENCHMARK(work("read_csv", 0, fileBytes)) {
+    return read_csv(path).size();
+  };
+  BENCHMARK(work("read_numeric_csv", 0, fileBytes + values * sizeof(double))) {
+    return read_numeric_csv<double>(path, {nColumns - 1}).features.size();
+  };
+
+  std::filesystem::remove(path);
+}
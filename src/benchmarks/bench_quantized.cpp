@@ -0,0 +1,116 @@
+/**
+ * @file bench_quantized.cpp
+ *
+ * @brief Accuracy and speed of 8-bit inference against the floating point paths.
+ *
+ * Usage: bench_quantized [batch_size] [iterations]
+ *
+ * Builds a 784-1024-512-10 ReLU MLP in `double`, copies it to `float`, and
+ * quantizes the `float` one, calibrated on a random batch. For each path,
+ * prints the size of the parameters, the latency of a single sample, the
+ * throughput on `batch_size` samples, the top-1 agreement with the `double`
+ * outputs, and the relative error of the outputs. CMake builds it in
+ * Release unless another build type is given; the float path is not
+ * representative otherwise.
+ */
+
+#include "network/quantized_network.h"
+
+#include "Eigen/Dense"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+using namespace dmlfs;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kSizes[] = {784, 1024, 512, 10};
+
+template <typename Scalar>
+Network<Scalar> make_mlp(const Network<double>& reference) {
+  Network<Scalar> network;
+  for (std::size_t i = 0; i + 1 < std::size(kSizes); ++i) {
+    const auto& layer = reference.layers()[i];
+    network.addLayer(std::make_shared<Layer<Scalar>>(layer->weights().template cast<Scalar>(),
+                                                     layer->biases().template cast<Scalar>(),
+                                                     layer->activationType()));
+  }
+  return network;
+}
+
+/**
+ * @brief Average wall-clock time of a call, in seconds
+ */
+double time_per_call(const std::function<void()>& call, int iterations) {
+  call();
+  const auto start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    call();
+  }
+  return std::chrono::duration<double>(Clock::now() - start).count() / iterations;
+}
+
+double top1_agreement(const Eigen::MatrixXd& output, const Eigen::MatrixXd& reference) {
+  int agreements = 0;
+  for (Eigen::Index j = 0; j < output.cols(); ++j) {
+    Eigen::Index a, b;
+    output.col(j).maxCoeff(&a);
+    reference.col(j).maxCoeff(&b);
+    agreements += a == b;
+  }
+  return static_cast<double>(agreements) / static_cast<double>(output.cols());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int batchSize = argc > 1 ? std::atoi(argv[1]) : 256;
+  const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  Network<double> reference;
+  for (std::size_t i = 0; i + 1 < std::size(kSizes); ++i) {
+    const bool last = i + 2 == std::size(kSizes);
+    reference.addLayer(std::make_shared<Layer<double>>(kSizes[i], kSizes[i + 1], Initializer<>::Type::XAVIER,
+                                                       last ? Activation<>::Type::NONE : Activation<>::Type::RELU));
+  }
+  Network<float> single = make_mlp<float>(reference);
+  QuantizedNetwork<float> quantized(single, Eigen::MatrixXf::Random(kSizes[0], 512));
+
+  const Eigen::MatrixXd input = Eigen::MatrixXd::Random(kSizes[0], batchSize);
+  const Eigen::MatrixXf inputFloat = input.cast<float>();
+  const Eigen::MatrixXd expected = reference.predict(input);
+
+  std::printf("%10s %12s %14s %14s %12s %12s\n", "path", "params KiB", "latency us", "samples/sec", "top-1 agree", "rel. error");
+
+  auto report = [&](const char* name, std::size_t bytes,
+                    const std::function<void()>& one, const std::function<void()>& batch,
+                    const Eigen::MatrixXd& output) {
+    const double latency = time_per_call(one, 10 * iterations);
+    const double throughput = batchSize / time_per_call(batch, iterations);
+    std::printf("%10s %12.0f %14.1f %14.0f %11.2f%% %12.2e\n", name, bytes / 1024.0, 1e6 * latency, throughput,
+                100.0 * top1_agreement(output, expected), (output - expected).norm() / expected.norm());
+  };
+
+  report("double", reference.parameters().size() * sizeof(double),
+         [&] { reference.predict(input.leftCols(1)); },
+         [&] { reference.predict(input); },
+         expected);
+
+  report("float", single.parameters().size() * sizeof(float),
+         [&] { single.predict(inputFloat.leftCols(1)); },
+         [&] { single.predict(inputFloat); },
+         single.predict(inputFloat).cast<double>());
+
+  report("int8", quantized.parameterBytes(),
+         [&] { quantized.predict(inputFloat.leftCols(1)); },
+         [&] { quantized.predict(inputFloat); },
+         quantized.predict(inputFloat).cast<double>());
+
+  return 0;
+}
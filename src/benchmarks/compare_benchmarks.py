@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+"""Compare a bench_micro JSON report against a baseline and flag regressions.
+
+Usage: compare_benchmarks.py baseline.json current.json [--threshold 0.10]
+
+A benchmark regresses when its mean time grows by more than `threshold`
+relative to the baseline, and by more than the sum of both standard
+deviations, so that noisy benchmarks are not flagged for noise alone. The
+exit status is 1 if any benchmark regressed, so the script can gate CI.
+
+The `bench_compare` CMake target runs bench_micro and checks its report
+against baseline.json, next to this script. That baseline was recorded from a
+Release build on a single core of an AMD EPYC (AVX2, AVX-512), so timings from
+other machines are only comparable to a baseline of their own: to refresh it,
+copy a new report over it, or point DMLFS_BENCHMARK_BASELINE elsewhere.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Map each benchmark name of a report to its entry"""
+    with open(path) as f:
+        return {entry["name"]: entry for entry in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="report to compare against")
+    parser.add_argument("current", help="report to check")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown tolerated (default: 0.10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = 0
+    print(f"{'benchmark':48} {'baseline us':>12} {'current us':>12} {'change':>8}")
+    for name, entry in current.items():
+        if name not in baseline:
+            print(f"{name:48} {'-':>12} {entry['mean_ns'] / 1e3:12.2f} {'new':>8}")
+            continue
+        before = baseline[name]
+        change = entry["mean_ns"] / before["mean_ns"] - 1
+        noise = before["stddev_ns"] + entry["stddev_ns"]
+        regressed = (change > args.threshold
+                     and entry["mean_ns"] - before["mean_ns"] > noise)
+        regressions += regressed
+        print(f"{name:48} {before['mean_ns'] / 1e3:12.2f} "
+              f"{entry['mean_ns'] / 1e3:12.2f} {100 * change:+7.1f}%"
+              f"{'  REGRESSION' if regressed else ''}")
+    for name in baseline.keys() - current.keys():
+        print(f"{name:48} missing from the current report")
+
+    print(f"\n{regressions} regression(s) above {100 * args.threshold:.0f}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
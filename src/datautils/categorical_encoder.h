@@ -0,0 +1,239 @@
+#ifndef CATEGORICAL_ENCODER_H
+#define CATEGORICAL_ENCODER_H
+
+#include "datautils/matrix_representation.h"
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace dmlfs {
+
+/**
+ * @brief Maps the raw categorical values of a dataset to the columns of a `SparseInput`
+ * @tparam Nd Number of categorical features
+ *
+ * In `Mode::VOCABULARY`, `fit` learns the distinct values of every feature.
+ * Each thread collects the values of its share of the records into its own
+ * sets, and the sets are then merged feature by feature, also in parallel.
+ * The values of a feature are numbered in increasing order, followed by one
+ * extra column for values never seen by `fit`.
+ *
+ * In `Mode::HASHING`, nothing needs to be learnt: each feature gets a fixed
+ * number of buckets and a value goes to the bucket given by its hash. This
+ * bounds the input dimension for features with millions of categories, at
+ * the cost of occasional collisions.
+ *
+ * In both modes the column offset of every feature is computed once, so
+ * encoding a value is a single lookup plus an addition.
+ */
+template <size_t Nd>
+class CategoricalEncoder {
+public:
+  /**
+   * @brief Enum class to represent how values are mapped to columns
+   */
+  enum class Mode {
+    VOCABULARY,  ///< One column per distinct value seen by `fit`, plus one for unseen values
+    HASHING      ///< A fixed number of hashed buckets per feature
+  };
+
+  /**
+   * @brief Constructor
+   * @param mode How values are mapped to columns
+   * @param bucketCount Number of buckets per feature, only used by `Mode::HASHING`
+   */
+  explicit CategoricalEncoder(Mode mode = Mode::VOCABULARY, int bucketCount = 1 << 18):
+      m_mode{mode},
+      m_bucketCount{bucketCount}
+  {
+    if (m_mode == Mode::HASHING) {
+      m_sizes.assign(Nd, bucketCount);
+      computeOffsets();
+    }
+  }
+
+  /**
+   * @brief Learn the vocabulary of every feature
+   * @param data Vector of structs
+   *
+   * Does nothing in `Mode::HASHING`.
+   */
+  template <size_t Nc>
+  void fit(const std::vector<StructRepresentation<Nc, Nd>>& data) {
+    if (m_mode == Mode::HASHING) {
+      return;
+    }
+
+    int nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    std::vector<std::array<std::unordered_set<int>, Nd>> local(nThreads);
+
+    const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(data.size());
+    #pragma omp parallel num_threads(nThreads)
+    {
+      int t = 0;
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+#endif
+      auto& sets = local[t];
+      #pragma omp for schedule(static)
+      for (std::ptrdiff_t i = 0; i < n; ++i) {
+        for (size_t d = 0; d < Nd; ++d) {
+          sets[d].insert(data[i].categorical_features[d]);
+        }
+      }
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (std::ptrdiff_t d = 0; d < static_cast<std::ptrdiff_t>(Nd); ++d) {
+      std::unordered_set<int>& merged = local.front()[d];
+      for (std::size_t t = 1; t < local.size(); ++t) {
+        merged.merge(local[t][d]);
+      }
+
+      std::vector<int> values(merged.begin(), merged.end());
+      std::sort(values.begin(), values.end());
+
+      auto& vocabulary = m_vocabularies[d];
+      vocabulary.clear();
+      vocabulary.reserve(values.size());
+      for (std::size_t i = 0; i < values.size(); ++i) {
+        vocabulary.emplace(values[i], static_cast<int>(i));
+      }
+    }
+
+    m_sizes.resize(Nd);
+    for (size_t d = 0; d < Nd; ++d) {
+      m_sizes[d] = static_cast<int>(m_vocabularies[d].size()) + 1;
+    }
+    computeOffsets();
+  }
+
+  /**
+   * @brief Number of columns of a feature
+   * @param feature Index of the categorical feature
+   */
+  int categoryCount(size_t feature) const {
+    return m_sizes[feature];
+  }
+
+  /**
+   * @brief Total number of columns, i.e. `SparseInput::categoryCount`
+   */
+  int totalCategories() const {
+    return m_offsets.empty() ? 0 : m_offsets.back() + m_sizes.back();
+  }
+
+  /**
+   * @brief Column of the first category of each feature
+   */
+  const std::vector<int>& offsets() const {
+    return m_offsets;
+  }
+
+  /**
+   * @brief Column of a value of a feature
+   * @param feature Index of the categorical feature
+   * @param value Raw value of the feature
+   */
+  int encode(size_t feature, int value) const {
+    if (m_mode == Mode::HASHING) {
+      return m_offsets[feature] + static_cast<int>(hash(feature, value) % static_cast<std::uint64_t>(m_bucketCount));
+    }
+    const auto& vocabulary = m_vocabularies[feature];
+    auto it = vocabulary.find(value);
+    return m_offsets[feature] + (it != vocabulary.end() ? it->second : m_sizes[feature] - 1);
+  }
+
+  /**
+   * @brief Encode a vector of structs
+   * @param data Vector of structs
+   * @return Continuous features and the column of every categorical value
+   *
+   * The records are encoded in parallel.
+   */
+  template <typename Scalar = double, size_t Nc>
+  SparseInput<Scalar> transform(const std::vector<StructRepresentation<Nc, Nd>>& data) const {
+    SparseInput<Scalar> input;
+    input.categoryCount = totalCategories();
+    input.continuous.resize(Nc, data.size());
+    input.categories.resize(Nd, data.size());
+
+    const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(data.size());
+    #pragma omp parallel for schedule(static)
+    for (std::ptrdiff_t col = 0; col < n; ++col) {
+      for (size_t c = 0; c < Nc; ++c) {
+        input.continuous(c, col) = static_cast<Scalar>(data[col].continuous_features[c]);
+      }
+      for (size_t d = 0; d < Nd; ++d) {
+        input.categories(d, col) = encode(d, data[col].categorical_features[d]);
+      }
+    }
+
+    return input;
+  }
+
+private:
+  /**
+   * @brief Mix a feature index and a value into a well-distributed 64-bit hash
+   *
+   * Uses the splitmix64 finalizer, so that nearby values land in unrelated buckets.
+   */
+  static std::uint64_t hash(size_t feature, int value) {
+    std::uint64_t x = (static_cast<std::uint64_t>(feature) << 32) ^ static_cast<std::uint32_t>(value);
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  /**
+   * @brief Prefix sums of the feature sizes
+   */
+  void computeOffsets() {
+    m_offsets.resize(Nd);
+    std::exclusive_scan(m_sizes.begin(), m_sizes.end(), m_offsets.begin(), 0);
+  }
+
+  /**
+   * @brief How values are mapped to columns
+   */
+  Mode m_mode;
+
+  /**
+   * @brief Number of buckets per feature in `Mode::HASHING`
+   */
+  int m_bucketCount;
+
+  /**
+   * @brief Column of every known value of each feature, relative to the feature's offset
+   */
+  std::array<std::unordered_map<int, int>, Nd> m_vocabularies;
+
+  /**
+   * @brief Number of columns of each feature
+   */
+  std::vector<int> m_sizes;
+
+  /**
+   * @brief Column of the first category of each feature
+   */
+  std::vector<int> m_offsets;
+};
+
+}  // namespace dmlfs
+
+#endif /* CATEGORICAL_ENCODER_H */
@@ -0,0 +1,317 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "MappedFile.h"
+#include "datautils/csv.h"
+
+#include "Eigen/Dense"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dmlfs {
+
+namespace detail {
+
+constexpr char kDatasetMagic[8] = {'D', 'M', 'L', 'F', 'S', 'D', 'A', 'T'};
+constexpr std::uint32_t kDatasetVersion = 1;
+constexpr std::uint32_t kDatasetByteOrderMark = 0x01020304;
+
+/**
+ * @brief Fixed-size header at the start of a dataset file
+ *
+ * @see MappedDataset for the meaning of each field
+ */
+struct DatasetHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint32_t scalarSize;
+  std::uint32_t reserved;
+  std::uint64_t sampleCount;
+  std::uint64_t featureCount;
+  std::uint64_t labelCount;
+  std::uint64_t featuresOffset;
+  std::uint64_t labelsOffset;
+};
+static_assert(sizeof(DatasetHeader) == 64);
+
+/**
+ * @brief Round a byte offset up to a multiple of 64
+ */
+inline std::uint64_t align_to_cache_line(std::uint64_t offset) {
+  return (offset + 63) / 64 * 64;
+}
+
+/**
+ * @brief Write a matrix in column-major order, one column at a time if its columns are not contiguous
+ */
+template <typename Scalar>
+void write_columns(std::ofstream& file, const Eigen::Ref<const Eigen::MatrixX<Scalar>>& matrix) {
+  const auto columnBytes = static_cast<std::streamsize>(matrix.rows() * static_cast<Eigen::Index>(sizeof(Scalar)));
+  if (matrix.outerStride() == matrix.rows()) {
+    file.write(reinterpret_cast<const char*>(matrix.data()), columnBytes * matrix.cols());
+    return;
+  }
+  for (Eigen::Index j = 0; j < matrix.cols(); ++j) {
+    file.write(reinterpret_cast<const char*>(matrix.col(j).data()), columnBytes);
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Write features and labels to a binary dataset file
+ * @param filename Name of the file to write
+ * @param features Features, one column per sample
+ * @param labels Labels, one column per sample
+ *
+ * Views such as `all.topRows(2)`, whose columns are not contiguous, are
+ * written column by column. Throws `std::runtime_error` if the file cannot
+ * be written.
+ *
+ * @see MappedDataset for the layout of the file
+ */
+template <typename Scalar = double>
+void write_dataset(const std::string& filename,
+                   const Eigen::Ref<const Eigen::MatrixX<Scalar>>& features,
+                   const Eigen::Ref<const Eigen::MatrixX<Scalar>>& labels) {
+  if (features.cols() != labels.cols()) {
+    throw std::invalid_argument("Features and labels must have the same number of samples");
+  }
+
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + filename + " for writing");
+  }
+
+  const std::uint64_t featureBytes = static_cast<std::uint64_t>(features.size()) * sizeof(Scalar);
+  const std::uint64_t labelBytes = static_cast<std::uint64_t>(labels.size()) * sizeof(Scalar);
+
+  detail::DatasetHeader header{};
+  std::memcpy(header.magic, detail::kDatasetMagic, sizeof(header.magic));
+  header.version = detail::kDatasetVersion;
+  header.byteOrder = detail::kDatasetByteOrderMark;
+  header.scalarSize = sizeof(Scalar);
+  header.sampleCount = static_cast<std::uint64_t>(features.cols());
+  header.featureCount = static_cast<std::uint64_t>(features.rows());
+  header.labelCount = static_cast<std::uint64_t>(labels.rows());
+  header.featuresOffset = detail::align_to_cache_line(sizeof(header));
+  header.labelsOffset = detail::align_to_cache_line(header.featuresOffset + featureBytes);
+
+  const char padding[64] = {};
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  detail::write_columns<Scalar>(file, features);
+  file.write(padding, static_cast<std::streamsize>(header.labelsOffset - header.featuresOffset - featureBytes));
+  detail::write_columns<Scalar>(file, labels);
+
+  if (!file) {
+    throw std::runtime_error("Cannot write " + filename);
+  }
+}
+
+/**
+ * @brief Convert a numeric CSV file to a binary dataset file
+ * @param csvFilename Name of the CSV file to read
+ * @param datasetFilename Name of the dataset file to write
+ * @param labelColumns Indices of the CSV columns holding the labels
+ * @param hasHeader Whether the first line of the CSV holds the column names
+ * @param delimiter Field separator of the CSV
+ *
+ * Meant to be run once per dataset, so that training jobs can map the result
+ * instead of parsing the CSV every time.
+ *
+ * @see read_numeric_csv
+ */
+template <typename Scalar = double>
+void convert_csv_to_dataset(const std::string& csvFilename,
+                            const std::string& datasetFilename,
+                            const std::vector<int>& labelColumns,
+                            bool hasHeader = true,
+                            char delimiter = ',') {
+  NumericCsv<Scalar> csv = read_numeric_csv<Scalar>(csvFilename, labelColumns, hasHeader, delimiter);
+  write_dataset<Scalar>(datasetFilename, csv.features, csv.labels);
+}
+
+/**
+ * @brief Dataset file mapped into memory, handing out zero-copy views
+ * @tparam Scalar Floating point type of the stored values
+ *
+ * Nothing is read when the dataset is opened: the views point straight into
+ * the mapping, and the page cache brings samples in as they are touched.
+ * Datasets larger than RAM can thus be trained on, and several jobs reading
+ * the same file share its pages. The views can be passed directly to
+ * `Trainer::train`.
+ *
+ * The file starts with a 64-byte header:
+ *
+ * | Bytes | Content                                          |
+ * |-------|--------------------------------------------------|
+ * | 0-7   | Magic string `DMLFSDAT`                          |
+ * | 8-11  | Format version, currently 1                      |
+ * | 12-15 | `0x01020304`, to detect a byte order mismatch    |
+ * | 16-19 | `sizeof(Scalar)`                                 |
+ * | 20-23 | Reserved, zero                                   |
+ * | 24-31 | Number of samples                                |
+ * | 32-39 | Number of features                               |
+ * | 40-47 | Number of labels                                 |
+ * | 48-55 | Byte offset of the features block                |
+ * | 56-63 | Byte offset of the labels block                  |
+ *
+ * Both blocks start on a 64-byte boundary and hold column-major matrices with
+ * one column per sample, as used throughout the library.
+ *
+ * Throws `std::runtime_error` if the file cannot be mapped or is not a valid
+ * dataset for this scalar type.
+ */
+template <typename Scalar = double>
+class MappedDataset {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using ConstMap = Eigen::Map<const Matrix>;
+
+  /**
+   * @brief Map a dataset file written by `write_dataset`
+   * @param filename Name of the file
+   */
+  explicit MappedDataset(const std::string& filename):
+      m_file{filename}
+  {
+    detail::DatasetHeader header;
+    if (m_file.size() < sizeof(header)) {
+      throw std::runtime_error(filename + " is too small to be a dataset file");
+    }
+    std::memcpy(&header, m_file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, detail::kDatasetMagic, sizeof(header.magic)) != 0) {
+      throw std::runtime_error(filename + " is not a dataset file");
+    }
+    if (header.version != detail::kDatasetVersion) {
+      throw std::runtime_error(filename + " has unsupported dataset format version " + std::to_string(header.version));
+    }
+    if (header.byteOrder != detail::kDatasetByteOrderMark) {
+      throw std::runtime_error(filename + " was written with a different byte order");
+    }
+    if (header.scalarSize != sizeof(Scalar)) {
+      throw std::runtime_error(filename + " holds " + std::to_string(8 * header.scalarSize) + "-bit values, expected "
+                               + std::to_string(8 * sizeof(Scalar)) + "-bit");
+    }
+    if (!fits(header.featuresOffset, header.featureCount, header.sampleCount)
+        || !fits(header.labelsOffset, header.labelCount, header.sampleCount)) {
+      throw std::runtime_error(filename + " is truncated or has an invalid layout");
+    }
+
+    m_samples = static_cast<Eigen::Index>(header.sampleCount);
+    m_featureCount = static_cast<Eigen::Index>(header.featureCount);
+    m_labelCount = static_cast<Eigen::Index>(header.labelCount);
+    m_features = reinterpret_cast<const Scalar*>(m_file.data() + header.featuresOffset);
+    m_labels = reinterpret_cast<const Scalar*>(m_file.data() + header.labelsOffset);
+  }
+
+  /**
+   * @brief Number of samples
+   */
+  Eigen::Index size() const {
+    return m_samples;
+  }
+
+  /**
+   * @brief Number of features per sample
+   */
+  Eigen::Index featureCount() const {
+    return m_featureCount;
+  }
+
+  /**
+   * @brief Number of labels per sample
+   */
+  Eigen::Index labelCount() const {
+    return m_labelCount;
+  }
+
+  /**
+   * @brief View of all the features, one column per sample
+   */
+  ConstMap features() const {
+    return ConstMap(m_features, m_featureCount, m_samples);
+  }
+
+  /**
+   * @brief View of all the labels, one column per sample
+   */
+  ConstMap labels() const {
+    return ConstMap(m_labels, m_labelCount, m_samples);
+  }
+
+  /**
+   * @brief View of the features of a contiguous range of samples
+   * @param first Index of the first sample
+   * @param count Number of samples
+   */
+  ConstMap featureBatch(Eigen::Index first, Eigen::Index count) const {
+    assert(first >= 0 && count >= 0 && first + count <= m_samples);
+    return ConstMap(m_features + first * m_featureCount, m_featureCount, count);
+  }
+
+  /**
+   * @brief View of the labels of a contiguous range of samples
+   * @param first Index of the first sample
+   * @param count Number of samples
+   */
+  ConstMap labelBatch(Eigen::Index first, Eigen::Index count) const {
+    assert(first >= 0 && count >= 0 && first + count <= m_samples);
+    return ConstMap(m_labels + first * m_labelCount, m_labelCount, count);
+  }
+
+private:
+  /**
+   * @brief Whether a block of `rows x cols` scalars at `offset` lies within the file
+   */
+  bool fits(std::uint64_t offset, std::uint64_t rows, std::uint64_t cols) const {
+    const std::uint64_t size = m_file.size();
+    if (offset % 64 != 0 || offset < sizeof(detail::DatasetHeader) || offset > size) {
+      return false;
+    }
+    const std::uint64_t capacity = (size - offset) / sizeof(Scalar);
+    return rows == 0 || cols <= capacity / rows;
+  }
+
+  /**
+   * @brief Mapping of the whole file
+   */
+  MappedFile m_file;
+
+  /**
+   * @brief Number of samples
+   */
+  Eigen::Index m_samples = 0;
+
+  /**
+   * @brief Number of features per sample
+   */
+  Eigen::Index m_featureCount = 0;
+
+  /**
+   * @brief Number of labels per sample
+   */
+  Eigen::Index m_labelCount = 0;
+
+  /**
+   * @brief Start of the features block within the mapping
+   */
+  const Scalar* m_features = nullptr;
+
+  /**
+   * @brief Start of the labels block within the mapping
+   */
+  const Scalar* m_labels = nullptr;
+};
+
+}  // namespace dmlfs
+
+#endif /* DATASET_H */
@@ -0,0 +1,297 @@
+#ifndef IDX_H
+#define IDX_H
+
+#include "MappedFile.h"
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Memory-mapped IDX file of unsigned bytes, the format of the MNIST dataset
+ *
+ * An IDX file starts with two zero bytes, a type code (`0x08` for unsigned
+ * bytes, the only type supported here), the number of dimensions, and then
+ * each dimension as a big-endian 32-bit integer. The values follow in
+ * row-major order. Only the header is read; the values are left in the
+ * mapping.
+ *
+ * Throws `std::runtime_error` if the file cannot be mapped or is not an IDX
+ * file of unsigned bytes.
+ */
+class IdxFile {
+public:
+  /**
+   * @brief Map an IDX file
+   * @param filename Name of the file
+   */
+  explicit IdxFile(const std::string& filename):
+      m_file{filename}
+  {
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(m_file.data());
+    if (m_file.size() < 4 || bytes[0] != 0 || bytes[1] != 0) {
+      throw std::runtime_error(filename + " is not an IDX file");
+    }
+    if (bytes[2] != 0x08) {
+      throw std::runtime_error(filename + " does not hold unsigned bytes");
+    }
+
+    const std::size_t nDims = bytes[3];
+    const std::size_t headerSize = 4 + 4 * nDims;
+    if (m_file.size() < headerSize) {
+      throw std::runtime_error(filename + " has a truncated header");
+    }
+
+    for (std::size_t d = 0; d < nDims; ++d) {
+      const std::uint8_t* dim = bytes + 4 + 4 * d;
+      m_dims.push_back((std::uint32_t{dim[0]} << 24) | (std::uint32_t{dim[1]} << 16) | (std::uint32_t{dim[2]} << 8) | dim[3]);
+    }
+
+    // Unless a dimension is empty, the product of the dimensions is checked
+    // against the file before each multiplication, so that a crafted header
+    // cannot wrap it around.
+    const std::uint64_t available = m_file.size() - headerSize;
+    const bool empty = std::find(m_dims.begin(), m_dims.end(), 0u) != m_dims.end();
+    std::uint64_t count = 1;
+    for (std::size_t d = 0; d < nDims && !empty; ++d) {
+      if (count > available / m_dims[d]) {
+        throw std::runtime_error(filename + " is truncated");
+      }
+      count *= m_dims[d];
+    }
+
+    m_values = bytes + headerSize;
+  }
+
+  /**
+   * @brief Size of each dimension, the first one being the number of items
+   */
+  const std::vector<std::uint32_t>& dims() const {
+    return m_dims;
+  }
+
+  /**
+   * @brief Values in row-major order
+   */
+  const std::uint8_t* values() const {
+    return m_values;
+  }
+
+private:
+  /**
+   * @brief Mapping of the whole file
+   */
+  MappedFile m_file;
+
+  /**
+   * @brief Size of each dimension
+   */
+  std::vector<std::uint32_t> m_dims;
+
+  /**
+   * @brief Start of the values within the mapping
+   */
+  const std::uint8_t* m_values = nullptr;
+};
+
+/**
+ * @brief Image classification dataset read from a pair of IDX files, such as MNIST
+ * @tparam Scalar Floating point type of the batches handed to the network
+ *
+ * The pixels stay as bytes in the mapped image file, a quarter of the memory
+ * of `float` and an eighth of `double`, and are only converted for the
+ * samples of the current mini-batch. The conversion also normalizes them, as
+ * `(pixel / 255 - mean) / stddev`, in a single vectorized pass.
+ *
+ * Every image is flattened into a column of `rows * cols` pixels, as expected
+ * by the network's first layer, and labels are one-hot encoded.
+ */
+template <typename Scalar = double>
+class IdxDataset {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using PixelMap = Eigen::Map<const Eigen::Matrix<std::uint8_t, Eigen::Dynamic, Eigen::Dynamic>>;
+
+  /**
+   * @brief Map an image file and its label file
+   * @param imagesFilename IDX file of `count x rows x cols` pixels
+   * @param labelsFilename IDX file of `count` class indices
+   * @param nClasses Number of classes, i.e. of rows of the one-hot labels
+   * @param mean Mean subtracted from the pixels after scaling them to [0, 1]
+   * @param stddev Standard deviation the centered pixels are divided by
+   *
+   * The defaults leave the pixels in [0, 1]. MNIST is commonly normalized with
+   * a mean of 0.1307 and a standard deviation of 0.3081.
+   */
+  IdxDataset(const std::string& imagesFilename,
+             const std::string& labelsFilename,
+             int nClasses = 10,
+             Scalar mean = 0,
+             Scalar stddev = 1):
+      m_images{imagesFilename},
+      m_labels{labelsFilename},
+      m_nClasses{nClasses},
+      m_scale{Scalar(1) / (Scalar(255) * stddev)},
+      m_shift{-mean / stddev}
+  {
+    const auto& imageDims = m_images.dims();
+    const auto& labelDims = m_labels.dims();
+    if (imageDims.size() != 3 || labelDims.size() != 1 || imageDims[0] != labelDims[0]) {
+      throw std::runtime_error(imagesFilename + " and " + labelsFilename + " are not matching image and label files");
+    }
+    for (std::uint32_t i = 0; i < labelDims[0]; ++i) {
+      if (m_labels.values()[i] >= nClasses) {
+        throw std::runtime_error(labelsFilename + " has a label out of range at index " + std::to_string(i));
+      }
+    }
+
+    // Batches index pixels and images with `int` elsewhere, e.g. in the layers.
+    constexpr std::uint64_t kMaxExtent = std::numeric_limits<int>::max();
+    const std::uint64_t pixelCount = std::uint64_t{imageDims[1]} * imageDims[2];
+    if (pixelCount == 0 || pixelCount > kMaxExtent || imageDims[0] > kMaxExtent) {
+      throw std::runtime_error(imagesFilename + " has invalid image dimensions");
+    }
+
+    m_size = imageDims[0];
+    m_pixelCount = static_cast<Eigen::Index>(pixelCount);
+  }
+
+  /**
+   * @brief Number of images
+   */
+  Eigen::Index size() const {
+    return m_size;
+  }
+
+  /**
+   * @brief Number of pixels per image
+   */
+  Eigen::Index pixelCount() const {
+    return m_pixelCount;
+  }
+
+  /**
+   * @brief Raw pixels, one column per image
+   */
+  PixelMap pixels() const {
+    return PixelMap(m_images.values(), m_pixelCount, m_size);
+  }
+
+  /**
+   * @brief Class index of an image
+   */
+  int label(Eigen::Index index) const {
+    return m_labels.values()[index];
+  }
+
+  /**
+   * @brief Normalized pixels of a contiguous range of images
+   * @param first Index of the first image
+   * @param count Number of images
+   * @param output Receives `pixelCount() x count` values, reusing its storage if possible
+   */
+  void imageBatch(Eigen::Index first, Eigen::Index count, Matrix& output) const {
+    assert(first >= 0 && count >= 0 && first + count <= m_size);
+    output.resize(m_pixelCount, count);
+    normalize(m_images.values() + first * m_pixelCount, output.data(), m_pixelCount * count);
+  }
+
+  /**
+   * @brief Normalized pixels of arbitrary images, e.g. from a shuffled order
+   * @param indices Indices of the images
+   * @param output Receives `pixelCount() x indices.size()` values, reusing its storage if possible
+   */
+  void imageBatch(const std::vector<Eigen::Index>& indices, Matrix& output) const {
+    output.resize(m_pixelCount, static_cast<Eigen::Index>(indices.size()));
+    for (std::size_t j = 0; j < indices.size(); ++j) {
+      assert(indices[j] >= 0 && indices[j] < m_size);
+      normalize(m_images.values() + indices[j] * m_pixelCount, output.col(j).data(), m_pixelCount);
+    }
+  }
+
+  /**
+   * @brief One-hot labels of a contiguous range of images
+   * @param first Index of the first image
+   * @param count Number of images
+   * @param output Receives `nClasses x count` values, reusing its storage if possible
+   */
+  void labelBatch(Eigen::Index first, Eigen::Index count, Matrix& output) const {
+    assert(first >= 0 && count >= 0 && first + count <= m_size);
+    output.setZero(m_nClasses, count);
+    for (Eigen::Index j = 0; j < count; ++j) {
+      output(label(first + j), j) = Scalar(1);
+    }
+  }
+
+  /**
+   * @brief One-hot labels of arbitrary images
+   * @param indices Indices of the images
+   * @param output Receives `nClasses x indices.size()` values, reusing its storage if possible
+   */
+  void labelBatch(const std::vector<Eigen::Index>& indices, Matrix& output) const {
+    output.setZero(m_nClasses, static_cast<Eigen::Index>(indices.size()));
+    for (std::size_t j = 0; j < indices.size(); ++j) {
+      output(label(indices[j]), static_cast<Eigen::Index>(j)) = Scalar(1);
+    }
+  }
+
+private:
+  /**
+   * @brief Convert and normalize `size` contiguous pixels
+   */
+  void normalize(const std::uint8_t* __restrict pixels, Scalar* __restrict output, Eigen::Index size) const {
+    const Scalar scale = m_scale;
+    const Scalar shift = m_shift;
+    #pragma omp simd
+    for (Eigen::Index i = 0; i < size; ++i) {
+      output[i] = scale * static_cast<Scalar>(pixels[i]) + shift;
+    }
+  }
+
+  /**
+   * @brief Mapped image file
+   */
+  IdxFile m_images;
+
+  /**
+   * @brief Mapped label file
+   */
+  IdxFile m_labels;
+
+  /**
+   * @brief Number of classes
+   */
+  int m_nClasses;
+
+  /**
+   * @brief Factor applied to the raw pixels
+   */
+  Scalar m_scale;
+
+  /**
+   * @brief Offset added to the scaled pixels
+   */
+  Scalar m_shift;
+
+  /**
+   * @brief Number of images
+   */
+  Eigen::Index m_size = 0;
+
+  /**
+   * @brief Number of pixels per image
+   */
+  Eigen::Index m_pixelCount = 0;
+};
+
+}  // namespace dmlfs
+
+#endif /* IDX_H */
@@ -3,7 +3,10 @@
 
 #include "Eigen/Dense"
 
+#include <array>
 #include <numeric>
+#include <stdexcept>
+#include <string>
 #include <unordered_set>
 #include <vector>
 
@@ -30,13 +33,14 @@ template <size_t Nc, size_t Nd>
 std::vector<int> count_distinct_categories(const std::vector<StructRepresentation<Nc, Nd>>& data) {
   std::vector<std::unordered_set<int>> category_sets(Nd);
   for (const auto& item : data) {
-    for (int i = 0; i < Nd; ++i) {
+    for (size_t i = 0; i < Nd; ++i) {
       category_sets[i].insert(item.categorical_features[i]);
     }
   }
-  std::vector<int> distinct_counts(Nd);
+  std::vector<int> distinct_counts;
+  distinct_counts.reserve(Nd);
   for (const auto& set : category_sets) {
-    distinct_counts.push_back(set.size());
+    distinct_counts.push_back(static_cast<int>(set.size()));
   }
   return distinct_counts;
 }
@@ -52,20 +56,19 @@ Eigen::MatrixXd convert_to_matrix(const std::vector<StructRepresentation<Nc, Nd>
 
   Eigen::MatrixXd _data(Nc + total_categories, data.size());
 
-  for (size_t col = 0; col < data.sie(); ++col) {
+  for (size_t col = 0; col < data.size(); ++col) {
     int row = 0;
 
     // Continuous features
-    for (int c = 0; c < Nc; ++c) {
-      _data(row, col) = data[col].continuous_features[c];
+    for (size_t c = 0; c < Nc; ++c) {
+      _data(row++, col) = data[col].continuous_features[c];
     }
 
     // One-hot encoding of categorical features
-    for (int d = 0; d < Nd; ++d) {
+    for (size_t d = 0; d < Nd; ++d) {
       int category = data[col].categorical_features[d];
-      int offset = std::accumulate(distinct_categories.begin(), distinct_categories.begin() + d, 0);
       for (int cat = 0; cat < distinct_categories[d]; ++cat) {
-        _data(row + offset + cat, col) = (category == cat) ? 1.0 : 0.0;
+        _data(row + cat, col) = (category == cat) ? 1.0 : 0.0;
       }
       row += distinct_categories[d];
     }
@@ -74,6 +77,75 @@ Eigen::MatrixXd convert_to_matrix(const std::vector<StructRepresentation<Nc, Nd>
   return _data;
 }
 
+/**
+ * @brief Sparse counterpart of the dense matrix built by `convert_to_matrix`
+ * @tparam Scalar Floating point type of the continuous features
+ *
+ * The continuous features are kept dense, but instead of one-hot rows each
+ * categorical feature is stored as the single index its one-hot encoding
+ * would set, counted from the first categorical row. Memory is then
+ * proportional to the number of features rather than of categories.
+ *
+ * @see SparseInputLayer
+ */
+template <typename Scalar = double>
+struct SparseInput {
+  /**
+   * @brief Continuous features, one column per sample
+   */
+  Eigen::MatrixX<Scalar> continuous;
+
+  /**
+   * @brief One row per categorical feature and one column per sample
+   */
+  Eigen::MatrixXi categories;
+
+  /**
+   * @brief Total number of categories, i.e. the number of one-hot rows this replaces
+   */
+  int categoryCount = 0;
+};
+
+/**
+ * @brief Convert a vector of structs to continuous features and category indices
+ * @param data Vector of structs
+ *
+ * Encodes the same information as `convert_to_matrix`, without the dense
+ * one-hot rows. Like it, expects the values of each categorical feature to
+ * be the integers from 0 to its number of distinct categories, exclusive,
+ * and throws `std::invalid_argument` otherwise, e.g. for the values {3, 7}.
+ * Encode arbitrary values with `CategoricalEncoder` first.
+ */
+template <typename Scalar = double, size_t Nc, size_t Nd>
+SparseInput<Scalar> convert_to_sparse_input(const std::vector<StructRepresentation<Nc, Nd>>& data) {
+  std::vector<int> distinct_categories = count_distinct_categories(data);
+
+  std::vector<int> offsets(Nd);
+  std::exclusive_scan(distinct_categories.begin(), distinct_categories.end(), offsets.begin(), 0);
+
+  SparseInput<Scalar> input;
+  input.categoryCount = std::accumulate(distinct_categories.begin(), distinct_categories.end(), 0);
+  input.continuous.resize(Nc, data.size());
+  input.categories.resize(Nd, data.size());
+
+  for (size_t col = 0; col < data.size(); ++col) {
+    for (size_t c = 0; c < Nc; ++c) {
+      input.continuous(c, col) = static_cast<Scalar>(data[col].continuous_features[c]);
+    }
+    for (size_t d = 0; d < Nd; ++d) {
+      const int category = data[col].categorical_features[d];
+      if (category < 0 || category >= distinct_categories[d]) {
+        throw std::invalid_argument("Categorical feature " + std::to_string(d) + " of sample " + std::to_string(col) +
+                                    " is " + std::to_string(category) + ", expected a value in [0, " +
+                                    std::to_string(distinct_categories[d]) + ")");
+      }
+      input.categories(d, col) = offsets[d] + category;
+    }
+  }
+
+  return input;
+}
+
 }  // namespace dmlfs
 
 #endif /* MATRIX_REPRESENTATION_H */
@@ -0,0 +1,381 @@
+#ifndef SCALER_H
+#define SCALER_H
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <omp.h>
+
+namespace dmlfs {
+
+/**
+ * @brief Per-feature count, mean and sum of squared deviations, updated with Welford's algorithm
+ *
+ * Two sets of moments computed over disjoint samples can be merged exactly
+ * with Chan's formula, which lets chunks of a dataset be processed
+ * independently and in parallel. Accumulates in double precision whatever
+ * the scalar type of the data.
+ */
+struct RunningMoments {
+  /**
+   * @brief Number of samples seen
+   */
+  double count = 0;
+
+  /**
+   * @brief Mean of each feature
+   */
+  Eigen::VectorXd mean;
+
+  /**
+   * @brief Sum of squared deviations from the mean of each feature
+   */
+  Eigen::VectorXd m2;
+
+  /**
+   * @brief Add the samples of a batch, one per column
+   * @param batch Samples to add
+   */
+  template <typename Derived>
+  void add(const Eigen::MatrixBase<Derived>& batch) {
+    if (mean.size() == 0) {
+      mean = Eigen::VectorXd::Zero(batch.rows());
+      m2 = Eigen::VectorXd::Zero(batch.rows());
+    }
+    assert(mean.size() == batch.rows());
+
+    // Scalar updates, so that adding a sample never allocates a temporary.
+    double* __restrict mu = mean.data();
+    double* __restrict sq = m2.data();
+    for (Eigen::Index j = 0; j < batch.cols(); ++j) {
+      count += 1;
+      const double weight = 1 / count;
+      for (Eigen::Index i = 0; i < batch.rows(); ++i) {
+        const double x = static_cast<double>(batch(i, j));
+        const double delta = x - mu[i];
+        mu[i] += delta * weight;
+        sq[i] += delta * (x - mu[i]);
+      }
+    }
+  }
+
+  /**
+   * @brief Merge the moments of other samples into these
+   * @param other Moments of disjoint samples
+   */
+  void merge(const RunningMoments& other) {
+    if (other.count == 0) {
+      return;
+    }
+    if (count == 0) {
+      *this = other;
+      return;
+    }
+    const double total = count + other.count;
+    const Eigen::VectorXd delta = other.mean - mean;
+    mean += delta * (other.count / total);
+    m2 += other.m2 + delta.cwiseAbs2() * (count * other.count / total);
+    count = total;
+  }
+
+  /**
+   * @brief Population variance of each feature
+   */
+  Eigen::VectorXd variance() const {
+    return count > 0 ? Eigen::VectorXd(m2 / count) : Eigen::VectorXd::Zero(m2.size());
+  }
+};
+
+namespace detail {
+
+/**
+ * @brief Apply `x = x * scale + shift` row-wise to every column, in place
+ */
+template <typename Scalar>
+void affine_rows_in_place(Eigen::Ref<Eigen::MatrixX<Scalar>> batch,
+                          const Eigen::VectorX<Scalar>& scale,
+                          const Eigen::VectorX<Scalar>& shift) {
+  assert(batch.rows() == scale.size() && batch.rows() == shift.size());
+
+  const Eigen::Index rows = batch.rows();
+  const Eigen::Index cols = batch.cols();
+  const Scalar* __restrict a = scale.data();
+  const Scalar* __restrict b = shift.data();
+
+  #pragma omp parallel for schedule(static) if(rows * cols >= (1 << 16))
+  for (Eigen::Index j = 0; j < cols; ++j) {
+    Scalar* __restrict x = batch.col(j).data();
+    #pragma omp simd
+    for (Eigen::Index i = 0; i < rows; ++i) {
+      x[i] = x[i] * a[i] + b[i];
+    }
+  }
+}
+
+}  // namespace detail
+
+/**
+ * @brief Standardizes every feature to zero mean and unit variance
+ * @tparam Scalar Floating point type of the data
+ *
+ * The statistics are accumulated by `partialFit` one batch at a time, so a
+ * dataset can be streamed from a `MappedDataset` or chunked CSV without ever
+ * being fully in memory, and each batch is split over threads that run
+ * Welford's algorithm on their own columns before their moments are merged.
+ *
+ * `transform` then rescales batches in place with a single fused
+ * multiply-add per value. Features with zero variance are only centered.
+ * Transforming before any sample was fitted throws `std::runtime_error`.
+ */
+template <typename Scalar = double>
+class StandardScaler {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using Vector = Eigen::VectorX<Scalar>;
+
+  /**
+   * @brief Accumulate the statistics of a batch of samples, one per column
+   * @param batch Samples to add
+   */
+  void partialFit(const Eigen::Ref<const Matrix>& batch) {
+    const Eigen::Index nChunks = std::min<Eigen::Index>(batch.cols(), static_cast<Eigen::Index>(omp_get_max_threads()));
+    std::vector<RunningMoments> partial(static_cast<std::size_t>(std::max<Eigen::Index>(nChunks, 0)));
+
+    #pragma omp parallel for schedule(static)
+    for (Eigen::Index k = 0; k < nChunks; ++k) {
+      const Eigen::Index first = batch.cols() * k / nChunks;
+      const Eigen::Index last = batch.cols() * (k + 1) / nChunks;
+      partial[k].add(batch.middleCols(first, last - first));
+    }
+
+    for (const RunningMoments& moments : partial) {
+      m_moments.merge(moments);
+    }
+    if (m_moments.count > 0) {
+      update();
+    }
+  }
+
+  /**
+   * @brief Compute the statistics of a whole dataset, streaming it by chunks
+   * @param data Samples, one per column, e.g. `MappedDataset::features()`
+   * @param chunkSize Number of samples read per chunk
+   */
+  void fit(const Eigen::Ref<const Matrix>& data, Eigen::Index chunkSize = 1 << 14) {
+    m_moments = RunningMoments{};
+    m_scale.resize(0);
+    m_shift.resize(0);
+    for (Eigen::Index first = 0; first < data.cols(); first += chunkSize) {
+      partialFit(data.middleCols(first, std::min(chunkSize, data.cols() - first)));
+    }
+  }
+
+  /**
+   * @brief Standardize a batch in place
+   * @param batch Samples, one per column
+   */
+  void transform(Eigen::Ref<Matrix> batch) const {
+    if (m_moments.count == 0) {
+      throw std::runtime_error("StandardScaler cannot transform before fitting any sample");
+    }
+    detail::affine_rows_in_place<Scalar>(batch, m_scale, m_shift);
+  }
+
+  /**
+   * @brief Mean of each feature
+   */
+  Eigen::VectorXd mean() const {
+    return m_moments.mean;
+  }
+
+  /**
+   * @brief Population variance of each feature
+   */
+  Eigen::VectorXd variance() const {
+    return m_moments.variance();
+  }
+
+  /**
+   * @brief Number of samples seen so far
+   */
+  double count() const {
+    return m_moments.count;
+  }
+
+private:
+  /**
+   * @brief Refresh the coefficients used by `transform`
+   */
+  void update() {
+    const Eigen::VectorXd stddev = m_moments.variance().cwiseSqrt();
+    const Eigen::VectorXd scale = stddev.unaryExpr([](double s) { return s > 0 ? 1 / s : 1.0; });
+    m_scale = scale.cast<Scalar>();
+    m_shift = (-m_moments.mean.cwiseProduct(scale)).cast<Scalar>();
+  }
+
+  /**
+   * @brief Statistics of the samples seen so far
+   */
+  RunningMoments m_moments;
+
+  /**
+   * @brief Factor applied to each feature
+   */
+  Vector m_scale;
+
+  /**
+   * @brief Offset added to each scaled feature
+   */
+  Vector m_shift;
+};
+
+/**
+ * @brief Rescales every feature linearly to a given range, [0, 1] by default
+ * @tparam Scalar Floating point type of the data
+ *
+ * Like `StandardScaler`, the minimum and maximum are accumulated one batch at
+ * a time and `transform` is a single fused multiply-add per value. Features
+ * that are constant are mapped to the lower bound of the range. Transforming
+ * before any sample was fitted throws `std::runtime_error`.
+ */
+template <typename Scalar = double>
+class MinMaxScaler {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using Vector = Eigen::VectorX<Scalar>;
+
+  /**
+   * @brief Constructor
+   * @param low Value the minimum of each feature is mapped to
+   * @param high Value the maximum of each feature is mapped to
+   */
+  explicit MinMaxScaler(Scalar low = 0, Scalar high = 1):
+      m_low{low},
+      m_high{high}
+  {
+  }
+
+  /**
+   * @brief Accumulate the range of a batch of samples, one per column
+   * @param batch Samples to add
+   */
+  void partialFit(const Eigen::Ref<const Matrix>& batch) {
+    if (m_min.size() == 0) {
+      m_min = Vector::Constant(batch.rows(), std::numeric_limits<Scalar>::infinity());
+      m_max = Vector::Constant(batch.rows(), -std::numeric_limits<Scalar>::infinity());
+    }
+    assert(m_min.size() == batch.rows());
+
+    // Without samples the bounds stay infinite, and so would the coefficients.
+    if (batch.cols() == 0) {
+      return;
+    }
+    m_min = m_min.cwiseMin(batch.rowwise().minCoeff());
+    m_max = m_max.cwiseMax(batch.rowwise().maxCoeff());
+    m_count += static_cast<double>(batch.cols());
+    update();
+  }
+
+  /**
+   * @brief Compute the range of a whole dataset, streaming it by chunks
+   * @param data Samples, one per column
+   * @param chunkSize Number of samples read per chunk
+   */
+  void fit(const Eigen::Ref<const Matrix>& data, Eigen::Index chunkSize = 1 << 14) {
+    m_min.resize(0);
+    m_max.resize(0);
+    m_scale.resize(0);
+    m_shift.resize(0);
+    m_count = 0;
+    for (Eigen::Index first = 0; first < data.cols(); first += chunkSize) {
+      partialFit(data.middleCols(first, std::min(chunkSize, data.cols() - first)));
+    }
+  }
+
+  /**
+   * @brief Rescale a batch in place
+   * @param batch Samples, one per column
+   */
+  void transform(Eigen::Ref<Matrix> batch) const {
+    if (m_count == 0) {
+      throw std::runtime_error("MinMaxScaler cannot transform before fitting any sample");
+    }
+    detail::affine_rows_in_place<Scalar>(batch, m_scale, m_shift);
+  }
+
+  /**
+   * @brief Getter for the minimum of each feature
+   */
+  const Vector& min() const {
+    return m_min;
+  }
+
+  /**
+   * @brief Getter for the maximum of each feature
+   */
+  const Vector& max() const {
+    return m_max;
+  }
+
+  /**
+   * @brief Number of samples seen so far
+   */
+  double count() const {
+    return m_count;
+  }
+
+private:
+  /**
+   * @brief Refresh the coefficients used by `transform`
+   */
+  void update() {
+    const Vector range = m_max - m_min;
+    m_scale = range.unaryExpr([this](Scalar r) { return r > 0 ? (m_high - m_low) / r : Scalar(0); });
+    m_shift = Vector::Constant(m_min.size(), m_low) - m_min.cwiseProduct(m_scale);
+  }
+
+  /**
+   * @brief Lower bound of the output range
+   */
+  Scalar m_low;
+
+  /**
+   * @brief Upper bound of the output range
+   */
+  Scalar m_high;
+
+  /**
+   * @brief Minimum of each feature
+   */
+  Vector m_min;
+
+  /**
+   * @brief Maximum of each feature
+   */
+  Vector m_max;
+
+  /**
+   * @brief Number of samples seen so far
+   */
+  double m_count = 0;
+
+  /**
+   * @brief Factor applied to each feature
+   */
+  Vector m_scale;
+
+  /**
+   * @brief Offset added to each scaled feature
+   */
+  Vector m_shift;
+};
+
+}  // namespace dmlfs
+
+#endif /* SCALER_H */
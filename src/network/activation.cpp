@@ -1,56 +1,140 @@
 #include "activation.h"
 
+#include <stdexcept>
+
 namespace dmlfs {
 
-Eigen::MatrixXd Trivial::operator()(const Eigen::MatrixXd& input) const {
-  return input;
+template <typename Scalar>
+typename Activation<Scalar>::Matrix Activation<Scalar>::operator()(const Matrix& input) const {
+  Matrix output(input.rows(), input.cols());
+  (*this)(input, output);
+  return output;
+}
+
+template <typename Scalar>
+typename Activation<Scalar>::Matrix Activation<Scalar>::derivative(const Matrix& input) const {
+  Matrix output(input.rows(), input.cols());
+  derivative(input, output);
+  return output;
 }
 
-Eigen::MatrixXd Trivial::derivative(const Eigen::MatrixXd& input) const {
-  return Eigen::MatrixXd::Ones(input.rows(), input.cols());
+template <typename Scalar>
+void Trivial<Scalar>::operator()(const Matrix& input, Matrix& output) const {
+  output = input;
 }
 
-Eigen::MatrixXd ReLU::operator()(const Eigen::MatrixXd& input) const {
-  return input.cwiseMax(0);
+template <typename Scalar>
+void Trivial<Scalar>::derivative(const Matrix& input, Matrix& output) const {
+  output.setOnes(input.rows(), input.cols());
 }
 
-Eigen::MatrixXd ReLU::derivative(const Eigen::MatrixXd& input) const {
-  return (input.array() > 0).cast<double>();
+template <typename Scalar>
+void ReLU<Scalar>::operator()(const Matrix& input, Matrix& output) const {
+  output = input.cwiseMax(Scalar(0));
 }
 
-Eigen::MatrixXd Sigmoid::operator()(const Eigen::MatrixXd& input) const {
-  return 1 / (1 + (-input.array()).exp());
+template <typename Scalar>
+void ReLU<Scalar>::derivative(const Matrix& input, Matrix& output) const {
+  output = (input.array() > Scalar(0)).template cast<Scalar>();
 }
 
-Eigen::MatrixXd Sigmoid::derivative(const Eigen::MatrixXd& input) const {
-  return operator()(input).array() * (1 - operator()(input).array());
+template <typename Scalar>
+void Sigmoid<Scalar>::operator()(const Matrix& input, Matrix& output) const {
+  output = 1 / (1 + (-input.array()).exp());
 }
 
-Eigen::MatrixXd Tanh::operator()(const Eigen::MatrixXd& input) const {
-  return input.array().tanh();
+template <typename Scalar>
+void Sigmoid<Scalar>::derivative(const Matrix& input, Matrix& output) const {
+  (*this)(input, output);
+  output.array() *= 1 - output.array();
 }
 
-Eigen::MatrixXd Tanh::derivative(const Eigen::MatrixXd& input) const {
-  return 1 - operator()(input).array().square();
+template <typename Scalar>
+void Tanh<Scalar>::operator()(const Matrix& input, Matrix& output) const {
+  output = input.array().tanh();
 }
 
-void Activation::set(Activation::Type type, std::unique_ptr<Activation>& activation) {
+template <typename Scalar>
+void Tanh<Scalar>::derivative(const Matrix& input, Matrix& output) const {
+  output = 1 - input.array().tanh().square();
+}
+
+template <typename Scalar>
+void Activation<Scalar>::set(Type type, std::unique_ptr<Activation>& activation) {
   switch (type) {
-    case Activation::Type::NONE:
-      activation = std::make_unique<Trivial>();
+    case Type::NONE:
+      activation = std::make_unique<Trivial<Scalar>>();
       break;
-    case Activation::Type::RELU:
-      activation = std::make_unique<ReLU>();
+    case Type::RELU:
+      activation = std::make_unique<ReLU<Scalar>>();
       break;
-    case Activation::Type::SIGMOID:
-      activation = std::make_unique<Sigmoid>();
+    case Type::SIGMOID:
+      activation = std::make_unique<Sigmoid<Scalar>>();
       break;
-    case Activation::Type::TANH:
-      activation = std::make_unique<Tanh>();
+    case Type::TANH:
+      activation = std::make_unique<Tanh<Scalar>>();
       break;
     default:
       throw std::invalid_argument("Unimplemented activation type");
   }
 }
 
+template <typename Scalar>
+void FusedActivation<Scalar>::forward(ActivationBase::Type type, Eigen::Ref<Matrix> z, const Eigen::Ref<const Matrix>& biases) {
+  auto preActivation = (z.colwise() + biases.col(0)).array();
+
+  switch (type) {
+    case ActivationBase::Type::NONE:
+      z.colwise() += biases.col(0);
+      break;
+    case ActivationBase::Type::RELU:
+      z.array() = preActivation.cwiseMax(Scalar(0));
+      break;
+    case ActivationBase::Type::SIGMOID:
+      z.array() = 1 / (1 + (-preActivation).exp());
+      break;
+    case ActivationBase::Type::TANH:
+      z.array() = preActivation.tanh();
+      break;
+    default:
+      throw std::invalid_argument("Unimplemented activation type");
+  }
+}
+
+template <typename Scalar>
+void FusedActivation<Scalar>::backward(ActivationBase::Type type,
+                                       const Eigen::Ref<const Matrix>& activated,
+                                       const Eigen::Ref<const Matrix>& dOutput,
+                                       Eigen::Ref<Matrix> dZ) {
+  switch (type) {
+    case ActivationBase::Type::NONE:
+      dZ = dOutput;
+      break;
+    case ActivationBase::Type::RELU:
+      dZ = (activated.array() > Scalar(0)).select(dOutput, Scalar(0));
+      break;
+    case ActivationBase::Type::SIGMOID:
+      dZ.array() = dOutput.array() * activated.array() * (1 - activated.array());
+      break;
+    case ActivationBase::Type::TANH:
+      dZ.array() = dOutput.array() * (1 - activated.array().square());
+      break;
+    default:
+      throw std::invalid_argument("Unimplemented activation type");
+  }
+}
+
+template struct FusedActivation<float>;
+template struct FusedActivation<double>;
+template struct Activation<float>;
+template struct Activation<double>;
+template struct Trivial<float>;
+template struct Trivial<double>;
+template struct ReLU<float>;
+template struct ReLU<double>;
+template struct Sigmoid<float>;
+template struct Sigmoid<double>;
+template struct Tanh<float>;
+template struct Tanh<double>;
+
 }  // namespace dmlfs
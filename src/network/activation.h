@@ -8,12 +8,11 @@
 namespace dmlfs {
 
 /**
- * @brief Abstract class for activation functions
+ * @brief Scalar-independent base holding the activation function enum
+ *
+ * This lets every scalar instantiation of `Activation` share the same `Type`.
  */
-struct Activation {
-  virtual Eigen::MatrixXd operator()(const Eigen::MatrixXd& input) const = 0;
-  virtual Eigen::MatrixXd derivative(const Eigen::MatrixXd& input) const = 0;
-
+struct ActivationBase {
   /**
    * @brief Enum class to represent the type of activation function
    */
@@ -23,8 +22,45 @@ struct Activation {
     SIGMOID,
     TANH
   };
+};
 
-  static void set(Activation::Type type, std::unique_ptr<Activation>& activation);
+/**
+ * @brief Abstract class for activation functions
+ * @tparam Scalar Floating point type of the matrix coefficients
+ */
+template <typename Scalar = double>
+struct Activation: public ActivationBase {
+  using Matrix = Eigen::MatrixX<Scalar>;
+
+  /**
+   * @brief Apply the activation function, writing into a preallocated matrix
+   * @param input Pre-activation values
+   * @param output Matrix of the same shape as `input` receiving the activations
+   */
+  virtual void operator()(const Matrix& input, Matrix& output) const = 0;
+
+  /**
+   * @brief Evaluate the derivative, writing into a preallocated matrix
+   * @param input Pre-activation values
+   * @param output Matrix of the same shape as `input` receiving the derivative
+   */
+  virtual void derivative(const Matrix& input, Matrix& output) const = 0;
+
+  /**
+   * @brief Apply the activation function
+   * @param input Pre-activation values
+   * @return Newly allocated matrix of activations
+   */
+  Matrix operator()(const Matrix& input) const;
+
+  /**
+   * @brief Evaluate the derivative of the activation function
+   * @param input Pre-activation values
+   * @return Newly allocated matrix of derivatives
+   */
+  Matrix derivative(const Matrix& input) const;
+
+  static void set(Type type, std::unique_ptr<Activation>& activation);
 
   virtual ~Activation() = default;
 };
@@ -32,33 +68,88 @@ struct Activation {
 /**
  * @brief Concrete class for Trivial activation function
  */
-struct Trivial: public Activation {
-  Eigen::MatrixXd operator()(const Eigen::MatrixXd& input) const override;
-  Eigen::MatrixXd derivative(const Eigen::MatrixXd& input) const override;
+template <typename Scalar = double>
+struct Trivial: public Activation<Scalar> {
+  using typename Activation<Scalar>::Matrix;
+  using Activation<Scalar>::operator();
+  using Activation<Scalar>::derivative;
+
+  void operator()(const Matrix& input, Matrix& output) const override;
+  void derivative(const Matrix& input, Matrix& output) const override;
 };
 
 /**
  * @brief Concrete class for ReLU activation function
  */
-struct ReLU: public Activation {
-  Eigen::MatrixXd operator()(const Eigen::MatrixXd& input) const override;
-  Eigen::MatrixXd derivative(const Eigen::MatrixXd& input) const override;
+template <typename Scalar = double>
+struct ReLU: public Activation<Scalar> {
+  using typename Activation<Scalar>::Matrix;
+  using Activation<Scalar>::operator();
+  using Activation<Scalar>::derivative;
+
+  void operator()(const Matrix& input, Matrix& output) const override;
+  void derivative(const Matrix& input, Matrix& output) const override;
 };
 
 /**
  * @brief Concrete class for Sigmoid
  */
-struct Sigmoid: public Activation {
-  Eigen::MatrixXd operator()(const Eigen::MatrixXd& input) const override;
-  Eigen::MatrixXd derivative(const Eigen::MatrixXd& input) const override;
+template <typename Scalar = double>
+struct Sigmoid: public Activation<Scalar> {
+  using typename Activation<Scalar>::Matrix;
+  using Activation<Scalar>::operator();
+  using Activation<Scalar>::derivative;
+
+  void operator()(const Matrix& input, Matrix& output) const override;
+  void derivative(const Matrix& input, Matrix& output) const override;
 };
 
 /**
  * @brief Concrete class for Tanh
  */
-struct Tanh: public Activation {
-  Eigen::MatrixXd operator()(const Eigen::MatrixXd& input) const override;
-  Eigen::MatrixXd derivative(const Eigen::MatrixXd& input) const override;
+template <typename Scalar = double>
+struct Tanh: public Activation<Scalar> {
+  using typename Activation<Scalar>::Matrix;
+  using Activation<Scalar>::operator();
+  using Activation<Scalar>::derivative;
+
+  void operator()(const Matrix& input, Matrix& output) const override;
+  void derivative(const Matrix& input, Matrix& output) const override;
+};
+
+/**
+ * @brief Fused elementwise kernels used by `Layer` on its hot path
+ *
+ * Instead of going through the virtual `Activation` interface (one new matrix
+ * per call, and the nonlinearity recomputed in `derivative`), the forward kernel
+ * adds the bias and applies the activation in a single pass, overwriting the
+ * pre-activations with the activations. Every supported derivative can be
+ * expressed in terms of the activation itself, so the backward kernel only
+ * needs that cached output.
+ */
+template <typename Scalar = double>
+struct FusedActivation {
+  using Matrix = Eigen::MatrixX<Scalar>;
+
+  /**
+   * @brief Compute `z = f(z + bias)` in place
+   * @param type Type of activation function
+   * @param z Pre-activations without bias on input, activations on output
+   * @param biases Column vector broadcast over the columns of `z`
+   */
+  static void forward(ActivationBase::Type type, Eigen::Ref<Matrix> z, const Eigen::Ref<const Matrix>& biases);
+
+  /**
+   * @brief Compute `dZ = dOutput * f'(z)` from the cached activations
+   * @param type Type of activation function
+   * @param activated Activations produced by `forward`
+   * @param dOutput Gradient of the loss with respect to the activations
+   * @param dZ Receives the gradient with respect to the pre-activations
+   */
+  static void backward(ActivationBase::Type type,
+                       const Eigen::Ref<const Matrix>& activated,
+                       const Eigen::Ref<const Matrix>& dOutput,
+                       Eigen::Ref<Matrix> dZ);
 };
 
 }  // namespace dmlfs
@@ -0,0 +1,140 @@
+#include "batching_server.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace dmlfs {
+
+template <typename Scalar>
+BatchingServer<Scalar>::BatchingServer(const Network<Scalar>& network,
+                                       Eigen::Index maxBatchSize,
+                                       std::chrono::microseconds maxWait,
+                                       int workers):
+    m_network{network},
+    m_inputSize{network.layers().empty() ? 0 : network.layers().front()->inputSize()},
+    m_maxBatchSize{maxBatchSize},
+    m_maxWait{maxWait}
+{
+  if (network.layers().empty()) {
+    throw std::invalid_argument("BatchingServer: the network has no layers");
+  }
+  if (maxBatchSize <= 0 || workers <= 0) {
+    throw std::invalid_argument("BatchingServer: the batch size and the number of workers must be positive");
+  }
+
+  m_workers.reserve(static_cast<std::size_t>(workers));
+  for (int i = 0; i < workers; ++i) {
+    m_workers.emplace_back([this] { work(); });
+  }
+}
+
+template <typename Scalar>
+BatchingServer<Scalar>::~BatchingServer() {
+  {
+    std::lock_guard lock{m_mutex};
+    m_stopping = true;
+  }
+  m_ready.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+template <typename Scalar>
+std::future<typename BatchingServer<Scalar>::Vector> BatchingServer<Scalar>::submit(const Eigen::Ref<const Vector>& input) {
+  if (input.size() != m_inputSize) {
+    throw std::invalid_argument("BatchingServer: expected " + std::to_string(m_inputSize) + " inputs, got "
+                                + std::to_string(input.size()));
+  }
+
+  Request request{input, {}, Clock::now()};
+  auto output = request.output.get_future();
+  std::size_t pending;
+  {
+    std::lock_guard lock{m_mutex};
+    m_queue.push_back(std::move(request));
+    pending = m_queue.size();
+  }
+
+  // A worker only needs waking when a batch starts, so that it can arm the
+  // timeout, and when a batch fills. In between, it is already waiting.
+  if (pending == 1 || static_cast<Eigen::Index>(pending) == m_maxBatchSize) {
+    m_ready.notify_one();
+  }
+  return output;
+}
+
+template <typename Scalar>
+void BatchingServer<Scalar>::work() {
+  InferenceContext<Scalar> context;
+  Matrix input(m_inputSize, m_maxBatchSize);
+  std::vector<Request> batch;
+  batch.reserve(static_cast<std::size_t>(m_maxBatchSize));
+
+  const auto full = [this] {
+    return static_cast<Eigen::Index>(m_queue.size()) >= m_maxBatchSize;
+  };
+
+  std::unique_lock lock{m_mutex};
+  for (;;) {
+    m_ready.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      return;
+    }
+
+    // Wait for the batch to fill, up to the deadline of its oldest request.
+    // If another worker takes that request meanwhile, start over with the
+    // deadline of the new oldest one.
+    const auto oldest = m_queue.front().arrival;
+    const bool woken = m_ready.wait_until(lock, oldest + m_maxWait, [&] {
+      return m_stopping || full() || m_queue.empty() || m_queue.front().arrival != oldest;
+    });
+    if (m_queue.empty() || (woken && !m_stopping && !full())) {
+      continue;
+    }
+
+    const auto count = std::min<std::size_t>(m_queue.size(), static_cast<std::size_t>(m_maxBatchSize));
+    std::move(m_queue.begin(), m_queue.begin() + count, std::back_inserter(batch));
+    m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+    if (!m_queue.empty()) {
+      m_ready.notify_one();
+    }
+
+    lock.unlock();
+    run(batch, input, context);
+    batch.clear();
+    lock.lock();
+  }
+}
+
+template <typename Scalar>
+void BatchingServer<Scalar>::run(std::vector<Request>& batch, Matrix& input, InferenceContext<Scalar>& context) {
+  const auto count = static_cast<Eigen::Index>(batch.size());
+  for (Eigen::Index j = 0; j < count; ++j) {
+    input.col(j) = batch[j].input;
+  }
+
+  // Count the batch before fulfilling the promises, so that a caller seeing
+  // its output also sees the batch in the counters.
+  m_requests.fetch_add(static_cast<std::uint64_t>(count), std::memory_order_relaxed);
+  m_batches.fetch_add(1, std::memory_order_relaxed);
+
+  Eigen::Index j = 0;
+  try {
+    const auto output = m_network.predict(input.leftCols(count), context);
+    for (; j < count; ++j) {
+      batch[j].output.set_value(output.col(j));
+    }
+  } catch (...) {
+    for (; j < count; ++j) {
+      batch[j].output.set_exception(std::current_exception());
+    }
+  }
+}
+
+template class BatchingServer<float>;
+template class BatchingServer<double>;
+
+}  // namespace dmlfs
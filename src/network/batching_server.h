@@ -0,0 +1,173 @@
+#ifndef BATCHING_SERVER_H
+#define BATCHING_SERVER_H
+
+#include "network.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief In-process inference engine batching single-sample requests together
+ * @tparam Scalar Floating point type of the network
+ *
+ * Callers submit one sample at a time and get a future of its output. The
+ * requests wait in a queue until either `maxBatchSize` of them are pending or
+ * the oldest one has waited `maxWait`. A worker then takes up to
+ * `maxBatchSize` of them, packs them into the columns of one matrix, runs a
+ * single `Network::predict` on it and hands each caller its column.
+ *
+ * A wide batch amortizes the per-call overhead and turns matrix-vector
+ * products into matrix-matrix ones, at the cost of up to `maxWait` of extra
+ * latency when the load is too light to fill batches. Under heavy load the
+ * batches fill before the timeout and latency is bounded by the queueing
+ * alone.
+ *
+ * The network must outlive the server and must not be trained while it is
+ * serving. `submit` can be called from any number of threads.
+ */
+template <typename Scalar = double>
+class BatchingServer {
+public:
+  using Matrix = typename Network<Scalar>::Matrix;
+  using Vector = Eigen::VectorX<Scalar>;
+
+  /**
+   * @brief Start the workers
+   * @param network Network to serve
+   * @param maxBatchSize Largest number of requests run together
+   * @param maxWait Longest time a request waits for others to join its batch
+   * @param workers Number of threads running batches
+   *
+   * Throws `std::invalid_argument` if the network is empty, or if
+   * `maxBatchSize` or `workers` is not positive.
+   */
+  BatchingServer(const Network<Scalar>& network,
+                 Eigen::Index maxBatchSize,
+                 std::chrono::microseconds maxWait,
+                 int workers = 1);
+
+  /**
+   * @brief Run the requests still queued, then stop the workers
+   */
+  ~BatchingServer();
+
+  BatchingServer(const BatchingServer&) = delete;
+  BatchingServer& operator=(const BatchingServer&) = delete;
+
+  /**
+   * @brief Queue a sample for inference
+   * @param input Input of the network for a single sample
+   * @return Future of the network's output for this sample
+   *
+   * Throws `std::invalid_argument` if `input` does not have the network's
+   * input size. If the forward pass fails, the future holds the exception.
+   */
+  std::future<Vector> submit(const Eigen::Ref<const Vector>& input);
+
+  /**
+   * @brief Number of requests answered so far
+   */
+  std::uint64_t requests() const {
+    return m_requests.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Number of batches run so far
+   */
+  std::uint64_t batches() const {
+    return m_batches.load(std::memory_order_relaxed);
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief A queued sample and the promise of its output
+   */
+  struct Request {
+    Vector input;                  ///< Sample to run
+    std::promise<Vector> output;   ///< Receives the sample's output
+    Clock::time_point arrival;     ///< Time at which the request was queued
+  };
+
+  /**
+   * @brief Body of each worker thread: collect a batch, run it, repeat until stopped
+   */
+  void work();
+
+  /**
+   * @brief Run a batch and fulfil its promises
+   * @param batch Requests of the batch
+   * @param input Matrix reused by the calling worker to pack the inputs
+   * @param context Activation storage of the calling worker
+   */
+  void run(std::vector<Request>& batch, Matrix& input, InferenceContext<Scalar>& context);
+
+  /**
+   * @brief Network being served
+   */
+  const Network<Scalar>& m_network;
+
+  /**
+   * @brief Number of inputs of the network
+   */
+  Eigen::Index m_inputSize;
+
+  /**
+   * @brief Largest number of requests run together
+   */
+  Eigen::Index m_maxBatchSize;
+
+  /**
+   * @brief Longest time a request waits for others to join its batch
+   */
+  std::chrono::microseconds m_maxWait;
+
+  /**
+   * @brief Pending requests, oldest first
+   */
+  std::deque<Request> m_queue;
+
+  /**
+   * @brief Guards `m_queue` and `m_stopping`
+   */
+  std::mutex m_mutex;
+
+  /**
+   * @brief Signals the workers that a batch may be ready, or that the server is stopping
+   */
+  std::condition_variable m_ready;
+
+  /**
+   * @brief Whether the destructor has asked the workers to finish
+   */
+  bool m_stopping = false;
+
+  /**
+   * @brief Number of requests answered so far
+   */
+  std::atomic<std::uint64_t> m_requests{0};
+
+  /**
+   * @brief Number of batches run so far
+   */
+  std::atomic<std::uint64_t> m_batches{0};
+
+  /**
+   * @brief Worker threads, started last so that everything above is initialized
+   */
+  std::vector<std::thread> m_workers;
+};
+
+}  // namespace dmlfs
+
+#endif /* BATCHING_SERVER_H */
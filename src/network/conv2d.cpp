@@ -0,0 +1,175 @@
+#include "conv2d.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace dmlfs {
+
+namespace {
+
+/**
+ * @brief Patch matrix size from which im2col and col2im are spread over threads
+ */
+constexpr Eigen::Index kParallelLoweringThreshold = 1 << 15;
+
+}  // namespace
+
+template <typename Scalar>
+Conv2D<Scalar>::Conv2D(int inChannels,
+                       int height,
+                       int width,
+                       int outChannels,
+                       int kernelSize,
+                       int stride,
+                       int padding,
+                       InitializerBase::Type initializerType,
+                       ActivationBase::Type activationType):
+    Layer<Scalar>{kernelSize * kernelSize * inChannels, outChannels, initializerType, activationType},
+    m_inChannels{inChannels},
+    m_height{height},
+    m_width{width},
+    m_outChannels{outChannels},
+    m_kernelSize{kernelSize},
+    m_stride{stride},
+    m_padding{padding},
+    m_outputHeight{stride > 0 ? (height + 2 * padding - kernelSize) / stride + 1 : 0},
+    m_outputWidth{stride > 0 ? (width + 2 * padding - kernelSize) / stride + 1 : 0}
+{
+  if (inChannels <= 0 || outChannels <= 0 || kernelSize <= 0 || stride <= 0 || padding < 0) {
+    throw std::invalid_argument("Conv2D: channels, kernel size and stride must be positive and padding non-negative");
+  }
+  if (height + 2 * padding < kernelSize || width + 2 * padding < kernelSize) {
+    throw std::invalid_argument("Conv2D: the kernel is larger than the padded input");
+  }
+}
+
+template <typename Scalar>
+void Conv2D<Scalar>::im2col(const Eigen::Ref<const Matrix>& input, Matrix& patches) const {
+  const Eigen::Index patchSize = this->weights().cols();
+  const Eigen::Index positions = static_cast<Eigen::Index>(m_outputHeight) * m_outputWidth;
+  const Eigen::Index batchSize = input.cols();
+  patches.resize(patchSize, positions * batchSize);
+
+  #pragma omp parallel for schedule(static) if(patches.size() >= kParallelLoweringThreshold)
+  for (Eigen::Index j = 0; j < batchSize; ++j) {
+    const Scalar* image = input.col(j).data();
+    Scalar* column = patches.data() + j * positions * patchSize;
+
+    for (int oy = 0; oy < m_outputHeight; ++oy) {
+      for (int ox = 0; ox < m_outputWidth; ++ox) {
+        for (int ky = 0; ky < m_kernelSize; ++ky) {
+          const int iy = oy * m_stride - m_padding + ky;
+          for (int kx = 0; kx < m_kernelSize; ++kx) {
+            const int ix = ox * m_stride - m_padding + kx;
+            if (iy < 0 || iy >= m_height || ix < 0 || ix >= m_width) {
+              std::fill_n(column, m_inChannels, Scalar(0));
+            } else {
+              std::copy_n(image + (static_cast<Eigen::Index>(iy) * m_width + ix) * m_inChannels, m_inChannels, column);
+            }
+            column += m_inChannels;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Scalar>
+void Conv2D<Scalar>::col2im(const Matrix& patches, Matrix& images) const {
+  const Eigen::Index patchSize = this->weights().cols();
+  const Eigen::Index positions = static_cast<Eigen::Index>(m_outputHeight) * m_outputWidth;
+  const Eigen::Index batchSize = patches.cols() / positions;
+  images.setZero(inputSize(), batchSize);
+
+  // Each sample only scatters into its own column, so the loop needs no synchronization.
+  #pragma omp parallel for schedule(static) if(patches.size() >= kParallelLoweringThreshold)
+  for (Eigen::Index j = 0; j < batchSize; ++j) {
+    Scalar* image = images.col(j).data();
+    const Scalar* column = patches.data() + j * positions * patchSize;
+
+    for (int oy = 0; oy < m_outputHeight; ++oy) {
+      for (int ox = 0; ox < m_outputWidth; ++ox) {
+        for (int ky = 0; ky < m_kernelSize; ++ky) {
+          const int iy = oy * m_stride - m_padding + ky;
+          for (int kx = 0; kx < m_kernelSize; ++kx) {
+            const int ix = ox * m_stride - m_padding + kx;
+            if (iy >= 0 && iy < m_height && ix >= 0 && ix < m_width) {
+              Scalar* pixel = image + (static_cast<Eigen::Index>(iy) * m_width + ix) * m_inChannels;
+              #pragma omp simd
+              for (int c = 0; c < m_inChannels; ++c) {
+                pixel[c] += column[c];
+              }
+            }
+            column += m_inChannels;
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Scalar>
+const typename Conv2D<Scalar>::Matrix& Conv2D<Scalar>::forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const {
+  assert(input.rows() == inputSize());
+
+  // The patches play the part of a dense layer's input in the backward pass.
+  im2col(input, workspace.input);
+
+  // Column-major, an `outChannels x (positions * batchSize)` product is
+  // exactly the batch of output images in height, width, channel order.
+  workspace.output.resize(outputSize(), input.cols());
+  MatrixMap z(workspace.output.data(), m_outChannels, workspace.input.cols());
+  z.noalias() = this->weights() * workspace.input;
+  FusedActivation<Scalar>::forward(this->activationType(), z, this->biases());
+
+  return workspace.output;
+}
+
+template <typename Scalar>
+void Conv2D<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const {
+  Matrix patches;
+  predict(input, output, patches);
+}
+
+template <typename Scalar>
+void Conv2D<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output, Matrix& patches) const {
+  assert(input.rows() == inputSize());
+  assert(output.rows() == outputSize() && output.cols() == input.cols());
+  assert(output.outerStride() == output.rows());
+
+  im2col(input, patches);
+
+  MatrixMap z(output.data(), m_outChannels, patches.cols());
+  z.noalias() = this->weights() * patches;
+  FusedActivation<Scalar>::forward(this->activationType(), z, this->biases());
+}
+
+template <typename Scalar>
+const typename Conv2D<Scalar>::Matrix& Conv2D<Scalar>::backward(const Matrix& dOutput, Workspace& workspace, Eigen::Ref<Vector> gradients) const {
+  assert(dOutput.rows() == outputSize() && dOutput.cols() == workspace.output.cols());
+  assert(gradients.size() == this->parameterCount());
+
+  const MatrixMap& weights = this->weights();
+  MatrixMap weights_grad(gradients.data(), weights.rows(), weights.cols());
+  MatrixMap biases_grad(gradients.data() + weights.size(), weights.rows(), 1);
+
+  workspace.dZ.resize(workspace.output.rows(), workspace.output.cols());
+  FusedActivation<Scalar>::backward(this->activationType(), workspace.output, dOutput, workspace.dZ);
+  Eigen::Map<const Matrix> dZ(workspace.dZ.data(), m_outChannels, workspace.input.cols());
+
+  weights_grad.noalias() = dZ * workspace.input.transpose();
+  biases_grad = dZ.rowwise().sum();
+
+  Matrix& dPatches = workspace.template state<State>().dPatches;
+  dPatches.resize(weights.cols(), dZ.cols());
+  dPatches.noalias() = weights.transpose() * dZ;
+  col2im(dPatches, workspace.dInput);
+
+  return workspace.dInput;
+}
+
+template class Conv2D<float>;
+template class Conv2D<double>;
+
+}  // namespace dmlfs
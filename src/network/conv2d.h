@@ -0,0 +1,210 @@
+#ifndef CONV2D_H
+#define CONV2D_H
+
+#include "layer.h"
+
+namespace dmlfs {
+
+/**
+ * @brief Two-dimensional convolution layer
+ * @tparam Scalar Floating point type of the parameters and activations
+ *
+ * Each sample is one column holding an image in height, width, channel
+ * order, i.e. the channels of a pixel are contiguous. That is the layout of
+ * the output too, so convolutions can be stacked, and a dense `Layer` can
+ * follow directly since it does not care about the order of its inputs. For
+ * single-channel images such as MNIST, it is plain row-major order.
+ *
+ * The convolution is lowered to a matrix product: the forward pass copies
+ * every receptive field of the batch into one column of a patch matrix
+ * (im2col), so the whole batch is convolved by a single large GEMM with the
+ * `outChannels x (kernelSize * kernelSize * inChannels)` weights. The backward
+ * pass computes the weight gradients with one GEMM against the same patches,
+ * and the input gradients with one GEMM followed by the inverse scatter-add
+ * (col2im). The copies are spread over the samples of the batch with OpenMP,
+ * and the patch matrices live in the `Workspace`, so they are only
+ * reallocated when the batch size changes.
+ *
+ * The weights and biases are stored exactly like a dense layer's, so a
+ * `Conv2D` can be added to a `Network` and trained by any optimizer. The
+ * kernel weights of an output channel are laid out in the same height,
+ * width, channel order as the images.
+ */
+template <typename Scalar = double>
+class Conv2D: public Layer<Scalar> {
+public:
+  using typename Layer<Scalar>::Matrix;
+  using typename Layer<Scalar>::Vector;
+  using typename Layer<Scalar>::MatrixMap;
+  using typename Layer<Scalar>::Workspace;
+  using Layer<Scalar>::forward;
+  using Layer<Scalar>::backward;
+
+  /**
+   * @brief Constructor
+   * @param inChannels Number of channels of the input images
+   * @param height Height of the input images
+   * @param width Width of the input images
+   * @param outChannels Number of filters, i.e. of channels of the output images
+   * @param kernelSize Height and width of the filters
+   * @param stride Step between two receptive fields, in both directions
+   * @param padding Number of rows and columns of zeros added on each side of the input
+   * @param initializerType Type of initializer
+   * @param activationType Type of activation function
+   */
+  Conv2D(int inChannels,
+         int height,
+         int width,
+         int outChannels,
+         int kernelSize,
+         int stride = 1,
+         int padding = 0,
+         InitializerBase::Type initializerType = InitializerBase::Type::ZERO,
+         ActivationBase::Type activationType = ActivationBase::Type::NONE);
+
+  /**
+   * @brief Number of values per input image, `height * width * inChannels`
+   */
+  Eigen::Index inputSize() const override {
+    return static_cast<Eigen::Index>(m_height) * m_width * m_inChannels;
+  }
+
+  /**
+   * @brief Number of values per output image, `outputHeight * outputWidth * outChannels`
+   */
+  Eigen::Index outputSize() const override {
+    return static_cast<Eigen::Index>(m_outputHeight) * m_outputWidth * m_outChannels;
+  }
+
+  /**
+   * @brief Convolve a batch, keeping the patches for the backward pass in the workspace
+   * @param input Images, one per column
+   * @param workspace Workspace receiving the patches and the activations
+   * @return Output images, one per column, stored in `workspace`
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const override;
+
+  /**
+   * @brief Backward propagation from the state recorded in a given workspace
+   * @param grad_output Derivative of the output images
+   * @param workspace Workspace filled by the matching `forward`
+   * @param gradients Span of `parameterCount()` scalars receiving the gradients, laid out like the parameters
+   * @return Derivative of the input images, stored in `workspace`
+   */
+  const Matrix& backward(const Matrix& grad_output, Workspace& workspace, Eigen::Ref<Vector> gradients) const override;
+
+  /**
+   * @brief Inference-only convolution
+   * @param input Images, one per column
+   * @param output Preallocated matrix of size `outputSize() x input.cols()`, distinct from `input`
+   *
+   * The patches go to a temporary buffer, allocated on every call. Pass a
+   * scratch buffer to the other overload to reuse one.
+   */
+  void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const override;
+
+  /**
+   * @brief Inference-only convolution building the patches in caller-owned storage
+   * @param input Images, one per column
+   * @param output Preallocated matrix of size `outputSize() x input.cols()`, distinct from `input`
+   * @param scratch Buffer receiving the patches, only resized when the batch size changes
+   *
+   * Concurrent calls are safe as long as each one passes its own buffer.
+   */
+  void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output, Matrix& scratch) const override;
+
+  /**
+   * @brief Getter for the number of input channels
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, inChannels);
+
+  /**
+   * @brief Getter for the number of output channels
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, outChannels);
+
+  /**
+   * @brief Getter for the height of the output images
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, outputHeight);
+
+  /**
+   * @brief Getter for the width of the output images
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, outputWidth);
+
+private:
+  /**
+   * @brief State kept in `Workspace::extension` by the backward pass
+   */
+  struct State {
+    Matrix dPatches; ///< Gradient with respect to the patches, before col2im
+  };
+
+  /**
+   * @brief Copy every receptive field of a batch into one column of `patches`
+   */
+  void im2col(const Eigen::Ref<const Matrix>& input, Matrix& patches) const;
+
+  /**
+   * @brief Scatter-add the columns of `patches` back to the images they were taken from
+   */
+  void col2im(const Matrix& patches, Matrix& images) const;
+
+  /**
+   * @brief Number of channels of the input images
+   */
+  int m_inChannels;
+
+  /**
+   * @brief Height of the input images
+   */
+  int m_height;
+
+  /**
+   * @brief Width of the input images
+   */
+  int m_width;
+
+  /**
+   * @brief Number of filters
+   */
+  int m_outChannels;
+
+  /**
+   * @brief Height and width of the filters
+   */
+  int m_kernelSize;
+
+  /**
+   * @brief Step between two receptive fields
+   */
+  int m_stride;
+
+  /**
+   * @brief Zeros added on each side of the input
+   */
+  int m_padding;
+
+  /**
+   * @brief Height of the output images
+   */
+  int m_outputHeight;
+
+  /**
+   * @brief Width of the output images
+   */
+  int m_outputWidth;
+};
+
+}  // namespace dmlfs
+
+#endif /* CONV2D_H */
@@ -0,0 +1,114 @@
+#include "dropout.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace dmlfs {
+
+namespace {
+
+/**
+ * @brief Activation count from which masking is spread over threads
+ */
+constexpr Eigen::Index kParallelMaskThreshold = 1 << 16;
+
+/**
+ * @brief SplitMix64 finalizer, a cheap bijective hash with good avalanche
+ */
+inline std::uint64_t mix(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/**
+ * @brief Multiply `values` by `scale` where the mask bit is set and by zero elsewhere, in place
+ */
+template <typename Scalar>
+void apply_mask(Scalar* values, Eigen::Index size, const std::uint64_t* mask, Scalar scale) {
+  const Eigen::Index words = (size + 63) / 64;
+
+  #pragma omp parallel for schedule(static) if(size >= kParallelMaskThreshold)
+  for (Eigen::Index w = 0; w < words; ++w) {
+    const std::uint64_t bits = mask[w];
+    Scalar* chunk = values + w * 64;
+    const int count = static_cast<int>(std::min<Eigen::Index>(64, size - w * 64));
+    #pragma omp simd
+    for (int b = 0; b < count; ++b) {
+      chunk[b] *= ((bits >> b) & 1) ? scale : Scalar(0);
+    }
+  }
+}
+
+}  // namespace
+
+template <typename Scalar>
+Dropout<Scalar>::Dropout(int size, Scalar rate, std::uint64_t seed):
+    Layer<Scalar>{0, 0},
+    m_size{size},
+    m_rate{rate},
+    m_scale{Scalar(1) / (Scalar(1) - rate)},
+    m_threshold{static_cast<std::uint32_t>(std::min(std::ldexp(static_cast<double>(rate), 32), 4294967295.0))},
+    m_seed{seed}
+{
+  if (size < 0 || !(rate >= 0 && rate < 1)) {
+    throw std::invalid_argument("Dropout: the size must be non-negative and the rate in [0, 1)");
+  }
+}
+
+template <typename Scalar>
+const typename Dropout<Scalar>::Matrix& Dropout<Scalar>::forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const {
+  assert(input.rows() == m_size);
+
+  workspace.output = input;
+  const Eigen::Index size = workspace.output.size();
+  const Eigen::Index words = (size + 63) / 64;
+  std::vector<std::uint64_t>& bitmask = workspace.template state<State>().mask;
+  bitmask.resize(static_cast<std::size_t>(words));
+
+  const std::uint64_t stream = mix(m_seed + mix(m_draws.fetch_add(1, std::memory_order_relaxed)));
+  const std::uint32_t threshold = m_threshold;
+  std::uint64_t* mask = bitmask.data();
+
+  #pragma omp parallel for schedule(static) if(size >= kParallelMaskThreshold)
+  for (Eigen::Index w = 0; w < words; ++w) {
+    std::uint64_t bits = 0;
+    #pragma omp simd reduction(|:bits)
+    for (int b = 0; b < 64; ++b) {
+      const auto r = static_cast<std::uint32_t>(mix(stream ^ static_cast<std::uint64_t>(w * 64 + b)) >> 32);
+      bits |= static_cast<std::uint64_t>(r >= threshold) << b;
+    }
+    mask[w] = bits;
+  }
+
+  apply_mask(workspace.output.data(), size, mask, m_scale);
+  return workspace.output;
+}
+
+template <typename Scalar>
+void Dropout<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const {
+  assert(input.rows() == m_size);
+  assert(output.rows() == input.rows() && output.cols() == input.cols());
+
+  output = input;
+}
+
+template <typename Scalar>
+const typename Dropout<Scalar>::Matrix& Dropout<Scalar>::backward(const Matrix& dOutput, Workspace& workspace, Eigen::Ref<Vector> gradients) const {
+  assert(dOutput.rows() == workspace.output.rows() && dOutput.cols() == workspace.output.cols());
+  assert(gradients.size() == 0);
+  static_cast<void>(gradients);
+
+  workspace.dInput = dOutput;
+  apply_mask(workspace.dInput.data(), workspace.dInput.size(), workspace.template state<State>().mask.data(), m_scale);
+  return workspace.dInput;
+}
+
+template class Dropout<float>;
+template class Dropout<double>;
+
+}  // namespace dmlfs
@@ -0,0 +1,135 @@
+#ifndef DROPOUT_H
+#define DROPOUT_H
+
+#include "layer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Inverted dropout layer
+ * @tparam Scalar Floating point type of the activations
+ *
+ * During training, each activation is zeroed with probability `rate` and the
+ * others are scaled by `1 / (1 - rate)`, so nothing needs to be rescaled at
+ * inference: `predict` is a plain copy.
+ *
+ * The mask is drawn from a counter-based generator: the bit of activation `i`
+ * is a hash of `i` and of a per-pass stream number, so every bit can be
+ * computed independently and the loop vectorizes. It is kept as a bitmask in
+ * the `Workspace`, 64 activations per word, and the same pass over the words
+ * applies it. The backward pass reuses it to mask the gradients.
+ *
+ * The layer has no parameters, so it takes no room in a `Network`'s arenas.
+ */
+template <typename Scalar = double>
+class Dropout: public Layer<Scalar> {
+public:
+  using typename Layer<Scalar>::Matrix;
+  using typename Layer<Scalar>::Vector;
+  using typename Layer<Scalar>::Workspace;
+  using Layer<Scalar>::forward;
+  using Layer<Scalar>::backward;
+  using Layer<Scalar>::predict;
+
+  /**
+   * @brief Constructor
+   * @param size Number of activations per sample
+   * @param rate Probability of zeroing an activation, in [0, 1)
+   * @param seed Seed of the mask generator
+   */
+  Dropout(int size, Scalar rate, std::uint64_t seed = 0);
+
+  /**
+   * @brief Number of activations per sample
+   */
+  Eigen::Index inputSize() const override {
+    return m_size;
+  }
+
+  /**
+   * @brief Number of activations per sample
+   */
+  Eigen::Index outputSize() const override {
+    return m_size;
+  }
+
+  /**
+   * @brief Draw a new mask and apply it
+   * @param input Activations, one sample per column
+   * @param workspace Workspace receiving the mask and the output
+   * @return Masked and rescaled activations, stored in `workspace`
+   *
+   * Each call draws a different mask, including concurrent calls with
+   * distinct workspaces.
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const override;
+
+  /**
+   * @brief Mask and rescale the gradients like the matching forward pass did the activations
+   * @param grad_output Derivative of the output
+   * @param workspace Workspace filled by the matching `forward`
+   * @param gradients Empty span, the layer has no parameters
+   * @return Derivative of the input, stored in `workspace`
+   */
+  const Matrix& backward(const Matrix& grad_output, Workspace& workspace, Eigen::Ref<Vector> gradients) const override;
+
+  /**
+   * @brief Inference-only pass, a copy of the input
+   * @param input Activations, one sample per column
+   * @param output Preallocated matrix of the same size as `input`
+   */
+  void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const override;
+
+  /**
+   * @brief Getter for the probability of zeroing an activation
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Scalar, rate);
+
+private:
+  /**
+   * @brief State kept in `Workspace::extension` between the forward and backward passes
+   */
+  struct State {
+    std::vector<std::uint64_t> mask; ///< One bit per activation, set if it is kept
+  };
+
+  /**
+   * @brief Number of activations per sample
+   */
+  int m_size;
+
+  /**
+   * @brief Probability of zeroing an activation
+   */
+  Scalar m_rate;
+
+  /**
+   * @brief Factor applied to the activations that are kept
+   */
+  Scalar m_scale;
+
+  /**
+   * @brief 32-bit random values below this drop their activation
+   */
+  std::uint32_t m_threshold;
+
+  /**
+   * @brief Seed of the mask generator
+   */
+  std::uint64_t m_seed;
+
+  /**
+   * @brief Number of masks drawn so far, which selects the stream of the next one
+   */
+  mutable std::atomic<std::uint64_t> m_draws{0};
+};
+
+}  // namespace dmlfs
+
+#endif /* DROPOUT_H */
@@ -1,52 +1,66 @@
 #include "initializer.h"
 
 #include <random>
+#include <stdexcept>
 
 namespace dmlfs {
 
-void ZeroInitializer::operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const {
-  weights = Eigen::MatrixXd::Zero(weights.rows(), weights.cols());
-  biases = Eigen::MatrixXd::Zero(biases.rows(), 1);
+template <typename Scalar>
+void ZeroInitializer<Scalar>::operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const {
+  weights = Matrix::Zero(weights.rows(), weights.cols());
+  biases = Matrix::Zero(biases.rows(), 1);
 }
 
-void RandomInitializer::operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const {
+template <typename Scalar>
+void RandomInitializer<Scalar>::operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const {
   std::random_device rd;
   std::mt19937 gen(rd());
-  std::uniform_real_distribution<double> dis(0.0, 1.0);
+  std::uniform_real_distribution<Scalar> dis(0.0, 1.0);
   for (int i=0; i<weights.rows(); ++i) {
     for (int j=0; j<weights.cols(); ++j) {
       weights(i, j) = dis(gen);
     }
   }
-  biases = Eigen::MatrixXd::Random(biases.rows(), 1) * 0.01;
+  biases = Matrix::Random(biases.rows(), 1) * Scalar(0.01);
 }
 
-void XavierInitializer::operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const {
-  double stdDev = std::sqrt(2.0 / (weights.rows() + weights.cols()));
+template <typename Scalar>
+void XavierInitializer<Scalar>::operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const {
+  Scalar stdDev = std::sqrt(Scalar(2.0) / (weights.rows() + weights.cols()));
   std::random_device rd;
   std::mt19937 gen(rd());
-  std::normal_distribution<double> dis(0.0, stdDev);
+  std::normal_distribution<Scalar> dis(0.0, stdDev);
   for (int i=0; i<weights.rows(); ++i) {
     for (int j=0; j<weights.cols(); ++j) {
       weights(i, j) = dis(gen);
     }
   }
-  biases = Eigen::MatrixXd::Random(biases.rows(), 1) * 0.01;
+  biases = Matrix::Random(biases.rows(), 1) * Scalar(0.01);
 }
 
-void Initializer::apply(Initializer::Type initializerType, Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) {
+template <typename Scalar>
+void Initializer<Scalar>::apply(Type initializerType, Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) {
   switch (initializerType) {
-    case Initializer::Type::ZERO:
+    case Type::ZERO:
       break;
-    case Initializer::Type::RANDOM:
-      RandomInitializer()(weights, biases);
+    case Type::RANDOM:
+      RandomInitializer<Scalar>()(weights, biases);
       break;
-    case Initializer::Type::XAVIER:
-      XavierInitializer()(weights, biases);
+    case Type::XAVIER:
+      XavierInitializer<Scalar>()(weights, biases);
       break;
     default:
       throw std::invalid_argument("Unimplemented initializer type");
   }
 }
 
+template struct Initializer<float>;
+template struct Initializer<double>;
+template struct ZeroInitializer<float>;
+template struct ZeroInitializer<double>;
+template struct RandomInitializer<float>;
+template struct RandomInitializer<double>;
+template struct XavierInitializer<float>;
+template struct XavierInitializer<double>;
+
 }  // namespace dmlfs
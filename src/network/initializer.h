@@ -6,14 +6,11 @@
 namespace dmlfs {
 
 /**
- * @brief Abstract class for initializers
+ * @brief Scalar-independent base holding the initializer enum
+ *
+ * This lets every scalar instantiation of `Initializer` share the same `Type`.
  */
-struct Initializer {
-  /**
-   * @brief Pure virtual function to initialize the weights and biases
-   */
-  virtual void operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const = 0;
-
+struct InitializerBase {
   /**
    * @brief Enum class to represent the type of initializer
    */
@@ -22,6 +19,20 @@ struct Initializer {
     RANDOM,
     XAVIER
   };
+};
+
+/**
+ * @brief Abstract class for initializers
+ * @tparam Scalar Floating point type of the matrix coefficients
+ */
+template <typename Scalar = double>
+struct Initializer: public InitializerBase {
+  using Matrix = Eigen::MatrixX<Scalar>;
+
+  /**
+   * @brief Pure virtual function to initialize the weights and biases
+   */
+  virtual void operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const = 0;
 
   /**
    * @brief Initialize the weights and biases
@@ -29,7 +40,7 @@ struct Initializer {
    * @param weights Weights matrix
    * @param biases Biases matrix
    */
-  static void apply(Initializer::Type initializerType, Eigen::MatrixXd& weights, Eigen::MatrixXd& biases);
+  static void apply(Type initializerType, Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases);
 
   /**
    * @brief Virtual destructor
@@ -40,22 +51,31 @@ struct Initializer {
 /**
  * @brief Concrete class for zero initializer
  */
-struct ZeroInitializer: public Initializer {
-  void operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const override;
+template <typename Scalar = double>
+struct ZeroInitializer: public Initializer<Scalar> {
+  using typename Initializer<Scalar>::Matrix;
+
+  void operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const override;
 };
 
 /**
  * @brief Concrete class for random initializer
  */
-struct RandomInitializer: public Initializer {
-  void operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const override;
+template <typename Scalar = double>
+struct RandomInitializer: public Initializer<Scalar> {
+  using typename Initializer<Scalar>::Matrix;
+
+  void operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const override;
 };
 
 /**
  * @brief Concrete class for Xavier initializer
  */
-struct XavierInitializer : public Initializer {
-  void operator()(Eigen::MatrixXd& weights, Eigen::MatrixXd& biases) const override;
+template <typename Scalar = double>
+struct XavierInitializer : public Initializer<Scalar> {
+  using typename Initializer<Scalar>::Matrix;
+
+  void operator()(Eigen::Ref<Matrix> weights, Eigen::Ref<Matrix> biases) const override;
 };
 
 }  // namespace dmlfs
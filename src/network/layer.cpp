@@ -4,55 +4,157 @@
 
 namespace dmlfs {
 
-Layer::Layer(int inputSize, int outputSize, Initializer::Type initializerType, Activation::Type activationType):
-    m_weights{Matrix::Zero(outputSize, inputSize)},
-    m_weights_grad{Matrix::Zero(outputSize, inputSize)},
-    m_biases{Matrix::Zero(outputSize, 1)},
-    m_biases_grad{Matrix::Zero(outputSize, 1)},
-    m_activation{nullptr}
+template <typename Scalar>
+Layer<Scalar>::Layer(int inputSize, int outputSize, InitializerBase::Type initializerType, ActivationBase::Type activationType):
+    m_ownedParameters{Vector::Zero(outputSize * (inputSize + 1))},
+    m_ownedGradients{Vector::Zero(outputSize * (inputSize + 1))},
+    m_weights{nullptr, outputSize, inputSize},
+    m_biases{nullptr, outputSize, 1},
+    m_weights_grad{nullptr, outputSize, inputSize},
+    m_biases_grad{nullptr, outputSize, 1},
+    m_activationType{activationType}
 {
-  Initializer::apply(initializerType, m_weights, m_biases);
-  Activation::set(activationType, m_activation);
+  rebind(m_ownedParameters.data(), m_ownedGradients.data());
+  Initializer<Scalar>::apply(initializerType, m_weights, m_biases);
 }
 
-Layer::Layer(const Matrix& weights, const Matrix& biases, Activation::Type activationType):
-    m_weights{weights},
-    m_weights_grad{Matrix::Zero(weights.rows(), weights.cols())},
-    m_biases{biases},
-    m_biases_grad{Matrix::Zero(biases.rows(), biases.cols())},
-    m_activation{nullptr}
+template <typename Scalar>
+Layer<Scalar>::Layer(const Matrix& weights, const Matrix& biases, ActivationBase::Type activationType):
+    m_ownedParameters{Vector::Zero(weights.size() + biases.size())},
+    m_ownedGradients{Vector::Zero(weights.size() + biases.size())},
+    m_weights{nullptr, weights.rows(), weights.cols()},
+    m_biases{nullptr, biases.rows(), 1},
+    m_weights_grad{nullptr, weights.rows(), weights.cols()},
+    m_biases_grad{nullptr, biases.rows(), 1},
+    m_activationType{activationType}
 {
-  Activation::set(activationType, m_activation);
+  assert(biases.cols() == 1 && biases.rows() == weights.rows());
+
+  rebind(m_ownedParameters.data(), m_ownedGradients.data());
+  m_weights = weights;
+  m_biases = biases;
 }
 
-Layer::Matrix Layer::forward(const Matrix& input) {
-  assert(input.rows() == m_weights.cols());
+template <typename Scalar>
+Layer<Scalar>::Layer(int inputSize, int outputSize, ActivationBase::Type activationType, Scalar* parameters, Scalar* gradients):
+    m_weights{nullptr, outputSize, inputSize},
+    m_biases{nullptr, outputSize, 1},
+    m_weights_grad{nullptr, outputSize, inputSize},
+    m_biases_grad{nullptr, outputSize, 1},
+    m_activationType{activationType}
+{
+  rebind(parameters, gradients);
+}
+
+template <typename Scalar>
+Layer<Scalar>::Layer(const Layer& other):
+    m_ownedParameters{other.parameterCount()},
+    m_ownedGradients{other.parameterCount()},
+    m_weights{nullptr, other.m_weights.rows(), other.m_weights.cols()},
+    m_biases{nullptr, other.m_biases.rows(), 1},
+    m_weights_grad{nullptr, other.m_weights.rows(), other.m_weights.cols()},
+    m_biases_grad{nullptr, other.m_biases.rows(), 1},
+    m_workspace{other.m_workspace},
+    m_activationType{other.m_activationType}
+{
+  m_ownedParameters = Eigen::Map<const Vector>(other.m_weights.data(), other.parameterCount());
+  if (other.m_weights_grad.data() != nullptr) {
+    m_ownedGradients = Eigen::Map<const Vector>(other.m_weights_grad.data(), other.parameterCount());
+  } else {
+    m_ownedGradients.setZero();
+  }
+  rebind(m_ownedParameters.data(), m_ownedGradients.data());
+}
+
+template <typename Scalar>
+Layer<Scalar>& Layer<Scalar>::operator=(const Layer& other) {
+  if (this != &other) {
+    Layer copy{other};
+    m_ownedParameters.swap(copy.m_ownedParameters);
+    m_ownedGradients.swap(copy.m_ownedGradients);
+    new (&m_weights) MatrixMap(nullptr, other.m_weights.rows(), other.m_weights.cols());
+    new (&m_biases) MatrixMap(nullptr, other.m_biases.rows(), 1);
+    new (&m_weights_grad) MatrixMap(nullptr, other.m_weights.rows(), other.m_weights.cols());
+    new (&m_biases_grad) MatrixMap(nullptr, other.m_biases.rows(), 1);
+    rebind(m_ownedParameters.data(), m_ownedGradients.data());
+    m_workspace = std::move(copy.m_workspace);
+    m_activationType = other.m_activationType;
+  }
+  return *this;
+}
 
-  m_input = input;
-  m_output = m_weights * input;
-  m_output += m_biases.replicate(1, input.cols());
+template <typename Scalar>
+void Layer<Scalar>::rebind(Scalar* parameters, Scalar* gradients) {
+  const Eigen::Index rows = m_weights.rows();
+  const Eigen::Index cols = m_weights.cols();
 
-  return (*m_activation)(m_output);
+  // Placement new is Eigen's documented way of pointing a Map elsewhere.
+  new (&m_weights) MatrixMap(parameters, rows, cols);
+  new (&m_biases) MatrixMap(parameters + rows * cols, rows, 1);
+  new (&m_weights_grad) MatrixMap(gradients, rows, cols);
+  new (&m_biases_grad) MatrixMap(gradients != nullptr ? gradients + rows * cols : nullptr, rows, 1);
 }
 
-Layer::Matrix Layer::backward(const Matrix& dOutput) {
-  assert(dOutput.rows() == m_weights.rows());
+template <typename Scalar>
+void Layer<Scalar>::bind(Scalar* parameters, Scalar* gradients) {
+  const Eigen::Index count = parameterCount();
+  Eigen::Map<Vector>(parameters, count) = Eigen::Map<const Vector>(m_weights.data(), count);
+  if (m_weights_grad.data() != nullptr) {
+    Eigen::Map<Vector>(gradients, count) = Eigen::Map<const Vector>(m_weights_grad.data(), count);
+  }
+
+  attach(parameters, gradients);
+}
 
-  Matrix dActivation = m_activation->derivative(m_output);
+template <typename Scalar>
+void Layer<Scalar>::attach(Scalar* parameters, Scalar* gradients) {
+  rebind(parameters, gradients);
+  m_ownedParameters.resize(0);
+  m_ownedGradients.resize(0);
+}
+
+template <typename Scalar>
+const typename Layer<Scalar>::Matrix& Layer<Scalar>::forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const {
+  assert(input.rows() == m_weights.cols());
 
-  Matrix dZ = dOutput.array() * dActivation.array();
-  m_weights_grad = dZ * m_input.transpose();
-  m_biases_grad = dZ.rowwise().sum();
+  workspace.input = input;
+  workspace.output.resize(m_weights.rows(), input.cols());
+  workspace.output.noalias() = m_weights * input;
+  FusedActivation<Scalar>::forward(m_activationType, workspace.output, m_biases);
 
-  return m_weights.transpose() * dZ;
+  return workspace.output;
 }
 
-void Layer::updateWeights(const Matrix& dWeights) {
-  m_weights += dWeights;
+template <typename Scalar>
+void Layer<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const {
+  assert(input.rows() == m_weights.cols());
+  assert(output.rows() == m_weights.rows() && output.cols() == input.cols());
+
+  output.noalias() = m_weights * input;
+  FusedActivation<Scalar>::forward(m_activationType, output, m_biases);
 }
 
-void Layer::updateBiases(const Matrix& dBiases) {
-  m_biases += dBiases;
+template <typename Scalar>
+const typename Layer<Scalar>::Matrix& Layer<Scalar>::backward(const Matrix& dOutput, Workspace& workspace, Eigen::Ref<Vector> gradients) const {
+  assert(dOutput.rows() == m_weights.rows());
+  assert(gradients.size() == parameterCount());
+
+  MatrixMap weights_grad(gradients.data(), m_weights.rows(), m_weights.cols());
+  MatrixMap biases_grad(gradients.data() + m_weights.size(), m_biases.rows(), 1);
+
+  workspace.dZ.resize(workspace.output.rows(), workspace.output.cols());
+  FusedActivation<Scalar>::backward(m_activationType, workspace.output, dOutput, workspace.dZ);
+
+  weights_grad.noalias() = workspace.dZ * workspace.input.transpose();
+  biases_grad = workspace.dZ.rowwise().sum();
+
+  workspace.dInput.resize(m_weights.cols(), workspace.dZ.cols());
+  workspace.dInput.noalias() = m_weights.transpose() * workspace.dZ;
+
+  return workspace.dInput;
 }
 
+template class Layer<float>;
+template class Layer<double>;
+
 }  // namespace dmlfs
@@ -7,17 +7,62 @@
 
 #include "Eigen/Dense"
 
-#include <memory>
+#include <any>
+#include <vector>
 
 namespace dmlfs {
 
 /**
  * @brief Class representing a layer in a neural network
+ * @tparam Scalar Floating point type of the parameters and activations
+ *
+ * The single-argument `forward` and `backward` record state in the layer
+ * itself and must not be called concurrently. `predict` and the overloads
+ * taking a `Workspace` only read the parameters and may be called from any
+ * number of threads at once.
+ *
+ * The parameters are stored as one contiguous span, the weights in
+ * column-major order followed by the biases, and the gradients use the same
+ * layout. A standalone layer owns that storage; once added to a `Network`, it
+ * is bound to the network's flat parameter and gradient arenas instead, which
+ * may themselves be a mapped model file.
  */
+template <typename Scalar = double>
 class Layer {
 public:
-  using Matrix = Eigen::MatrixXd;
-  
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using Vector = Eigen::VectorX<Scalar>;
+  using MatrixMap = Eigen::Map<Matrix>;
+
+  /**
+   * @brief State recorded by a forward pass and consumed by the backward pass
+   *
+   * Every buffer is only resized when the batch size changes. Each thread
+   * training on a shared layer owns its own workspace.
+   *
+   * State that only some layers need, such as a pooling layer's positions
+   * of the maxima, goes in `extension`, whose type each layer chooses.
+   */
+  struct Workspace {
+    Matrix input;   ///< Input of the last forward pass
+    Matrix output;  ///< Activations of the last forward pass
+    Matrix dZ;      ///< Gradient with respect to the pre-activations
+    Matrix dInput;  ///< Gradient with respect to the input
+    std::any extension; ///< Layer-specific state, empty for dense layers
+
+    /**
+     * @brief The layer-specific state, default-constructed on first use
+     * @tparam State Type of the state, chosen by the layer owning the workspace
+     */
+    template <typename State>
+    State& state() {
+      if (auto* existing = std::any_cast<State>(&extension)) {
+        return *existing;
+      }
+      return extension.emplace<State>();
+    }
+  };
+
   /**
    * @brief Constructor
    * @param inputSize Number of input neurons
@@ -27,8 +72,8 @@ public:
    */
   Layer(int inputSize,
         int outputSize,
-        Initializer::Type initializerType = Initializer::Type::ZERO,
-        Activation::Type activationType = Activation::Type::NONE);
+        InitializerBase::Type initializerType = InitializerBase::Type::ZERO,
+        ActivationBase::Type activationType = ActivationBase::Type::NONE);
 
   /**
    * @brief Constructor specifying weights and biases
@@ -38,98 +83,254 @@ public:
    */
   Layer(const Matrix& weights,
         const Matrix& biases,
-        Activation::Type activationType = Activation::Type::NONE);
+        ActivationBase::Type activationType = ActivationBase::Type::NONE);
+
+  /**
+   * @brief Constructor viewing parameters stored elsewhere
+   * @param inputSize Number of input neurons
+   * @param outputSize Number of output neurons
+   * @param activationType Type of activation function
+   * @param parameters Start of a span of `outputSize * (inputSize + 1)` scalars holding the weights, then the biases
+   * @param gradients Start of a span of as many scalars receiving the gradients, or null until `attach` is called
+   *
+   * Nothing is copied or allocated. The spans must outlive the layer or be
+   * replaced with `attach` first.
+   */
+  Layer(int inputSize,
+        int outputSize,
+        ActivationBase::Type activationType,
+        Scalar* parameters,
+        Scalar* gradients);
+
+  /**
+   * @brief Copy constructor
+   *
+   * The copy owns its parameters, even if `other` is bound to a network.
+   */
+  Layer(const Layer& other);
+
+  /**
+   * @brief Copy assignment
+   *
+   * Like the copy constructor, this layer ends up owning its parameters.
+   */
+  Layer& operator=(const Layer& other);
+
+  /**
+   * @brief Virtual destructor
+   */
+  virtual ~Layer() = default;
 
   /**
    * @brief Getter for the weights matrix
    *
    * @see CommonMacros.h
    */
-  DEFINE_CONST_GETTER(Matrix, weights);
+  DEFINE_CONST_GETTER(MatrixMap, weights);
 
   /**
-   * @brief Getter for the weights gradients matrix
+   * @brief Getter for the biases matrix
    *
    * @see CommonMacros.h
    */
-  DEFINE_CONST_GETTER(Matrix, weights_grad);
+  DEFINE_CONST_GETTER(MatrixMap, biases);
 
   /**
-   * @brief Getter for the biases matrix
+   * @brief Getter for the weights gradients matrix
    *
    * @see CommonMacros.h
    */
-  DEFINE_CONST_GETTER(Matrix, biases);
+  DEFINE_CONST_GETTER(MatrixMap, weights_grad);
 
   /**
    * @brief Getter for the biases gradients matrix
    *
    * @see CommonMacros.h
    */
-  DEFINE_CONST_GETTER(Matrix, biases_grad);
+  DEFINE_CONST_GETTER(MatrixMap, biases_grad);
+
+  /**
+   * @brief Getter for the type of activation function
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(ActivationBase::Type, activationType);
+
+  /**
+   * @brief Number of rows of the input, i.e. of values per sample
+   */
+  virtual Eigen::Index inputSize() const {
+    return m_weights.cols();
+  }
+
+  /**
+   * @brief Number of rows of the output, i.e. of values per sample
+   */
+  virtual Eigen::Index outputSize() const {
+    return m_weights.rows();
+  }
+
+  /**
+   * @brief Number of scalars in the weights and biases together
+   */
+  Eigen::Index parameterCount() const {
+    return m_weights.size() + m_biases.size();
+  }
+
+  /**
+   * @brief Move the parameters and gradients into external storage
+   * @param parameters Start of a span of `parameterCount()` scalars receiving the current parameters
+   * @param gradients Start of a span of `parameterCount()` scalars receiving the current gradients
+   *
+   * The current values are copied over and the layer's own storage, if any,
+   * is released. The spans must outlive the layer or be rebound first.
+   */
+  void bind(Scalar* parameters, Scalar* gradients);
+
+  /**
+   * @brief Point the parameters and gradients at external storage without copying
+   * @param parameters Start of a span of `parameterCount()` scalars holding the parameters
+   * @param gradients Start of a span of `parameterCount()` scalars receiving the gradients
+   *
+   * The layer's own storage, if any, is released.
+   */
+  void attach(Scalar* parameters, Scalar* gradients);
+
+  /**
+   * @brief Forward propagation recording its state in a given workspace
+   * @param input Input to the layer, or any contiguous-column view of one
+   * @param workspace Workspace receiving the state needed by `backward`
+   * @return Output of the layer, stored in `workspace`
+   *
+   * This only reads the parameters, so threads can share a layer as long as
+   * each one passes its own workspace.
+   */
+  virtual const Matrix& forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const;
+
+  /**
+   * @brief Backward propagation from the state recorded in a given workspace
+   * @param grad_output Derivative of the output
+   * @param workspace Workspace filled by the matching `forward`
+   * @param gradients Span of `parameterCount()` scalars receiving the gradients, laid out like the parameters
+   * @return Derivative of the input, stored in `workspace`
+   */
+  virtual const Matrix& backward(const Matrix& grad_output, Workspace& workspace, Eigen::Ref<Vector> gradients) const;
 
   /**
    * @brief Forward propagation
-   * @param input Input to the layer
+   * @param input Input to the layer, or any contiguous-column view of one
    * @return Output of the layer
+   *
+   * The returned reference points into the layer's workspace and stays valid
+   * until the next call to `forward`. Workspaces are only resized when the
+   * batch size changes, so repeated calls with the same shape do not allocate.
    */
-  virtual Matrix forward(const Matrix& input);
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input) {
+    return forward(input, m_workspace);
+  }
 
   /**
    * @brief Backward propagation
    * @param grad_output Derivative of the output
-   * @param learningRate Learning rate
    * @return Derivative of the input
+   *
+   * The gradients are stored in `weights_grad()` and `biases_grad()`. The
+   * returned reference points into the layer's workspace and stays valid
+   * until the next call to `backward`.
    */
-  virtual Matrix backward(const Matrix& grad_output);
+  const Matrix& backward(const Matrix& grad_output) {
+    return backward(grad_output, m_workspace, Eigen::Map<Vector>(m_weights_grad.data(), parameterCount()));
+  }
+
+  /**
+   * @brief Inference-only forward propagation
+   * @param input Input to the layer
+   * @param output Preallocated matrix of size `outputSize x input.cols()`, distinct from `input`
+   *
+   * Unlike `forward`, this does not record anything for backpropagation and
+   * leaves the layer untouched.
+   */
+  virtual void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const;
+
+  /**
+   * @brief Inference-only forward propagation with caller-owned scratch storage
+   * @param input Input to the layer
+   * @param output Preallocated matrix of size `outputSize x input.cols()`, distinct from `input`
+   * @param scratch Buffer the layer may resize and overwrite, e.g. `InferenceContext::scratch()`
+   *
+   * Layers that lower their input before multiplying it, like `Conv2D`, do so
+   * in `scratch`, so a caller reusing the buffer does not allocate. The others
+   * ignore it.
+   */
+  virtual void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output, Matrix& /*scratch*/) const {
+    predict(input, output);
+  }
 
   /**
    * @brief Update weights after forward and backward propagation
-   * @param dWeights Gradients with which to update the weights
+   * @param dWeights Gradients (or any Eigen expression of them) with which to update the weights
    */
-  void updateWeights(const Matrix& dWeights);
+  template <typename Derived>
+  void updateWeights(const Eigen::MatrixBase<Derived>& dWeights) {
+    m_weights += dWeights;
+  }
 
   /**
    * @brief Update biases after forward and backward propagation
-   * @param dBiases Gradients with which to update the biases
+   * @param dBiases Gradients (or any Eigen expression of them) with which to update the biases
    */
-  void updateBiases(const Matrix& dBiases);
+  template <typename Derived>
+  void updateBiases(const Eigen::MatrixBase<Derived>& dBiases) {
+    m_biases += dBiases;
+  }
 
 private:
   /**
-   * @brief Weights
+   * @brief Point the parameter and gradient views at the given spans
    */
-  Matrix m_weights;
+  void rebind(Scalar* parameters, Scalar* gradients);
 
   /**
-   * @brief Weights gradients
+   * @brief Own storage for the parameters, empty once bound to a network
    */
-  Matrix m_weights_grad;
+  Vector m_ownedParameters;
+
+  /**
+   * @brief Own storage for the gradients, empty once bound to a network
+   */
+  Vector m_ownedGradients;
+
+  /**
+   * @brief Weights
+   */
+  MatrixMap m_weights;
 
   /**
    * @brief Biases
    */
-  Matrix m_biases;
+  MatrixMap m_biases;
 
   /**
-   * @brief Biases gradients
+   * @brief Weights gradients
    */
-  Matrix m_biases_grad;
+  MatrixMap m_weights_grad;
 
   /**
-   * @brief The input to the layer for use in backpropagation
+   * @brief Biases gradients
    */
-  Matrix m_input;
+  MatrixMap m_biases_grad;
 
   /**
-   * @brief The pre-activation vectors for use in backpropagation
+   * @brief State of the layer's own forward and backward passes
    */
-  Matrix m_output;
+  Workspace m_workspace;
 
   /**
-   * @brief Activation function and its derivative
+   * @brief Type of activation function, dispatched to the fused kernels
+   *
+   * @see FusedActivation
    */
-  std::unique_ptr<Activation> m_activation;
+  ActivationBase::Type m_activationType;
 };
 
 }  // namespace dmlfs
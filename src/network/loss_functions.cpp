@@ -1,47 +1,160 @@
 #include "loss_functions.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
 namespace dmlfs {
 
-double meanSquaredError(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  Eigen::MatrixXd diff = yHat - y;
+namespace {
+
+/**
+ * @brief Clipping bound for the logarithms, kept representable in `1 - epsilon`
+ */
+template <typename Scalar>
+constexpr Scalar clipEpsilon() {
+  return std::max(Scalar(1e-15), std::numeric_limits<Scalar>::epsilon());
+}
+
+/**
+ * @brief Coefficient count from which the softmax kernels are spread over the columns
+ */
+constexpr Eigen::Index kParallelSoftmaxThreshold = 1 << 16;
+
+/**
+ * @brief Largest coefficient of a column
+ */
+template <typename Scalar>
+Scalar columnMax(const Scalar* z, Eigen::Index size) {
+  Scalar max = -std::numeric_limits<Scalar>::infinity();
+  #pragma omp simd reduction(max:max)
+  for (Eigen::Index i = 0; i < size; ++i) {
+    max = std::max(max, z[i]);
+  }
+  return max;
+}
+
+}  // namespace
+
+template <typename Scalar>
+Scalar meanSquaredError(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  Eigen::MatrixX<Scalar> diff = yHat - y;
   return (diff.array().square()).mean();
 }
 
-Eigen::MatrixXd meanSquaredErrorDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  Eigen::MatrixXd gradient = -(y - yHat);
+template <typename Scalar>
+Eigen::MatrixX<Scalar> meanSquaredErrorDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  Eigen::MatrixX<Scalar> gradient = -(y - yHat);
   return gradient;
 }
 
-double crossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  const double epsilon = 1e-15;
-  Eigen::MatrixXd yHatClipped = yHat.unaryExpr([epsilon](double x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
+template <typename Scalar>
+Scalar crossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  const Scalar epsilon = clipEpsilon<Scalar>();
+  return -(y.array() * yHat.array().max(epsilon).min(1 - epsilon).log()).sum() / static_cast<Scalar>(y.cols());
+}
 
-  Eigen::ArrayXXd lossArray = -(y.array() * yHatClipped.array().log()).colwise().sum();
-  return lossArray.mean();
+template <typename Scalar>
+Eigen::MatrixX<Scalar> crossEntropyDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  const Scalar epsilon = clipEpsilon<Scalar>();
+  return -(y.array() / yHat.array().max(epsilon).min(1 - epsilon)).matrix();
 }
 
-Eigen::MatrixXd crossEntropyDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  const double epsilon = 1e-15;
-  Eigen::MatrixXd yHatClipped = yHat.unaryExpr([epsilon](double x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
+template <typename Scalar>
+Scalar softmaxCrossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& logits, Eigen::MatrixX<Scalar>& gradient) {
+  assert(y.rows() == logits.rows() && y.cols() == logits.cols());
 
-  Eigen::MatrixXd gradient = -(y.array() / yHatClipped.array());
-  return gradient;
+  const Eigen::Index classes = logits.rows();
+  const Eigen::Index samples = logits.cols();
+  gradient.resize(classes, samples);
+  double total = 0;
+
+  #pragma omp parallel for schedule(static) reduction(+:total) if(logits.size() >= kParallelSoftmaxThreshold)
+  for (Eigen::Index j = 0; j < samples; ++j) {
+    const Scalar* z = logits.col(j).data();
+    const Scalar* t = y.col(j).data();
+    Scalar* g = gradient.col(j).data();
+
+    const Scalar max = columnMax(z, classes);
+    Scalar sum = 0;
+    Scalar labelSum = 0;
+    Scalar dot = 0;
+    #pragma omp simd reduction(+:sum, labelSum, dot)
+    for (Eigen::Index i = 0; i < classes; ++i) {
+      const Scalar shifted = z[i] - max;
+      const Scalar e = std::exp(shifted);
+      g[i] = e;
+      sum += e;
+      labelSum += t[i];
+      dot += t[i] * shifted;
+    }
+
+    total += static_cast<double>(labelSum * std::log(sum) - dot);
+
+    const Scalar scale = labelSum / sum;
+    #pragma omp simd
+    for (Eigen::Index i = 0; i < classes; ++i) {
+      g[i] = g[i] * scale - t[i];
+    }
+  }
+
+  return static_cast<Scalar>(total / static_cast<double>(samples));
+}
+
+template <typename Scalar>
+void softmax(Eigen::Ref<Eigen::MatrixX<Scalar>> logits) {
+  const Eigen::Index classes = logits.rows();
+
+  #pragma omp parallel for schedule(static) if(logits.size() >= kParallelSoftmaxThreshold)
+  for (Eigen::Index j = 0; j < logits.cols(); ++j) {
+    Scalar* z = logits.col(j).data();
+    const Scalar max = columnMax(z, classes);
+    Scalar sum = 0;
+    #pragma omp simd reduction(+:sum)
+    for (Eigen::Index i = 0; i < classes; ++i) {
+      z[i] = std::exp(z[i] - max);
+      sum += z[i];
+    }
+    const Scalar inverse = Scalar(1) / sum;
+    #pragma omp simd
+    for (Eigen::Index i = 0; i < classes; ++i) {
+      z[i] *= inverse;
+    }
+  }
 }
 
-double binaryCrossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  const double epsilon = 1e-15;
-  Eigen::MatrixXd yHatClipped = yHat.unaryExpr([epsilon](double x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
+template <typename Scalar>
+Scalar binaryCrossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  const Scalar epsilon = clipEpsilon<Scalar>();
+  Eigen::MatrixX<Scalar> yHatClipped = yHat.unaryExpr([epsilon](Scalar x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
 
-  Eigen::ArrayXXd lossArray = -y.array() * yHatClipped.array().log() - (1 - y.array()) * (1 - yHatClipped.array()).log();
+  Eigen::ArrayXX<Scalar> lossArray = -y.array() * yHatClipped.array().log() - (1 - y.array()) * (1 - yHatClipped.array()).log();
   return lossArray.sum() / y.rows();
 }
 
-Eigen::MatrixXd binaryCrossEntropyDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat) {
-  const double epsilon = 1e-15;
-  Eigen::MatrixXd yHatClipped = yHat.unaryExpr([epsilon](double x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
+template <typename Scalar>
+Eigen::MatrixX<Scalar> binaryCrossEntropyDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat) {
+  const Scalar epsilon = clipEpsilon<Scalar>();
+  Eigen::MatrixX<Scalar> yHatClipped = yHat.unaryExpr([epsilon](Scalar x) { return std::max(epsilon, std::min(1 - epsilon, x)); });
 
-  Eigen::ArrayXXd gradient = - (y.array() / yHatClipped.array()) + (1 - y.array()) / (1 - yHatClipped.array());
+  Eigen::ArrayXX<Scalar> gradient = - (y.array() / yHatClipped.array()) + (1 - y.array()) / (1 - yHatClipped.array());
   return gradient.matrix();
 }
 
+#define DMLFS_INSTANTIATE_LOSS_FUNCTIONS(Scalar)                                                                 \
+  template Scalar meanSquaredError<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&);                   \
+  template Eigen::MatrixX<Scalar> meanSquaredErrorDerivative<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&); \
+  template Scalar crossEntropy<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&);                       \
+  template Eigen::MatrixX<Scalar> crossEntropyDerivative<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&); \
+  template Scalar softmaxCrossEntropy<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&, Eigen::MatrixX<Scalar>&); \
+  template void softmax<Scalar>(Eigen::Ref<Eigen::MatrixX<Scalar>>);                                          \
+  template Scalar binaryCrossEntropy<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&);                 \
+  template Eigen::MatrixX<Scalar> binaryCrossEntropyDerivative<Scalar>(const Eigen::MatrixX<Scalar>&, const Eigen::MatrixX<Scalar>&);
+
+DMLFS_INSTANTIATE_LOSS_FUNCTIONS(float)
+DMLFS_INSTANTIATE_LOSS_FUNCTIONS(double)
+
+#undef DMLFS_INSTANTIATE_LOSS_FUNCTIONS
+
 }  // namespace dmlfs
@@ -5,6 +5,11 @@
 
 namespace dmlfs {
 
+/*
+ * All loss functions are templated on the scalar type of the matrices and
+ * explicitly instantiated for `float` and `double` in loss_functions.cpp.
+ */
+
 /**
  * @brief Mean squared error loss function
  * @param y True labels
@@ -26,7 +31,8 @@ namespace dmlfs {
  * @see meanSquaredErrorDerivative
  * @see https://en.wikipedia.org/wiki/Mean_squared_error
  */
-double meanSquaredError(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Scalar meanSquaredError(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
 
 /**
  * @brief Derivative of the mean squared error loss function
@@ -42,7 +48,8 @@ double meanSquaredError(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
  *
  * @see meanSquaredError
  */
-Eigen::MatrixXd meanSquaredErrorDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Eigen::MatrixX<Scalar> meanSquaredErrorDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
 
 /**
  * @brief Cross entropy loss function
@@ -61,7 +68,8 @@ Eigen::MatrixXd meanSquaredErrorDerivative(const Eigen::MatrixXd& y, const Eigen
  *
  * @see https://en.wikipedia.org/wiki/Cross_entropy
  */
-double crossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Scalar crossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
 
 /**
  * @brief Derivative of the cross entropy loss function
@@ -78,7 +86,43 @@ double crossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
  *
  * @see crossEntropy
  */
-Eigen::MatrixXd crossEntropyDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Eigen::MatrixX<Scalar> crossEntropyDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
+
+/**
+ * @brief Softmax followed by the cross entropy loss, fused, with its gradient
+ * @param y True labels, typically one-hot, one sample per column
+ * @param logits Outputs of the last layer, before any activation
+ * @param gradient Receives the derivative of the loss with respect to the logits
+ * @return Cross entropy loss averaged over the samples
+ *
+ * With \f$p = \mathrm{softmax}(z)\f$, the loss of a sample is
+ * \f[
+ *   L(y, z) = -\sum_{i} y_i \log p_i = \sum_{i} y_i \left( \log \sum_{k} e^{z_k} - z_i \right)
+ * \f]
+ * and its gradient with respect to the logits is \f$p \sum_i y_i - y\f$, i.e.
+ * \f$p - y\f$ for one-hot labels. Like `meanSquaredErrorDerivative`, the gradient
+ * is not divided by the number of samples.
+ *
+ * The log-sum-exp is computed after subtracting the largest logit, so it
+ * neither overflows nor needs clipping, and each column is processed in one
+ * vectorized pass that writes the gradient as it goes. The last layer should
+ * use `Activation::Type::NONE`.
+ *
+ * @see Trainer::FusedLoss
+ */
+template <typename Scalar>
+Scalar softmaxCrossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& logits, Eigen::MatrixX<Scalar>& gradient);
+
+/**
+ * @brief Numerically stable softmax over each column, in place
+ * @param logits Logits on input, probabilities on output
+ *
+ * Turns the outputs of a network trained with `softmaxCrossEntropy` into
+ * class probabilities.
+ */
+template <typename Scalar>
+void softmax(Eigen::Ref<Eigen::MatrixX<Scalar>> logits);
 
 /**
  * @brief Binary cross entropy loss function
@@ -95,7 +139,8 @@ Eigen::MatrixXd crossEntropyDerivative(const Eigen::MatrixXd& y, const Eigen::Ma
  *
  * @see crossEntropy
  */
-double binaryCrossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Scalar binaryCrossEntropy(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
 
 /**
  * @brief Derivative of the binary cross entropy loss function
@@ -111,7 +156,8 @@ double binaryCrossEntropy(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat)
  *
  * @see crossEntropy
  */
-Eigen::MatrixXd binaryCrossEntropyDerivative(const Eigen::MatrixXd& y, const Eigen::MatrixXd& yHat);
+template <typename Scalar>
+Eigen::MatrixX<Scalar> binaryCrossEntropyDerivative(const Eigen::MatrixX<Scalar>& y, const Eigen::MatrixX<Scalar>& yHat);
 
 }  // namespace dmlfs
 
@@ -0,0 +1,143 @@
+#include "max_pool2d.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace dmlfs {
+
+namespace {
+
+/**
+ * @brief Activation count from which pooling is spread over the samples of the batch
+ */
+constexpr Eigen::Index kParallelPoolingThreshold = 1 << 15;
+
+}  // namespace
+
+template <typename Scalar>
+MaxPool2D<Scalar>::MaxPool2D(int channels, int height, int width, int kernelSize, int stride):
+    Layer<Scalar>{0, 0},
+    m_channels{channels},
+    m_height{height},
+    m_width{width},
+    m_kernelSize{kernelSize},
+    m_stride{stride > 0 ? stride : kernelSize},
+    m_outputHeight{kernelSize > 0 && height >= kernelSize ? (height - kernelSize) / m_stride + 1 : 0},
+    m_outputWidth{kernelSize > 0 && width >= kernelSize ? (width - kernelSize) / m_stride + 1 : 0}
+{
+  if (channels <= 0 || kernelSize <= 0 || stride < 0) {
+    throw std::invalid_argument("MaxPool2D: channels and kernel size must be positive and stride non-negative");
+  }
+  if (kernelSize > 16) {
+    throw std::invalid_argument("MaxPool2D: kernels larger than 16x16 are not supported");
+  }
+  if (height < kernelSize || width < kernelSize) {
+    throw std::invalid_argument("MaxPool2D: the kernel is larger than the input");
+  }
+}
+
+template <typename Scalar>
+template <bool RecordArgmax>
+void MaxPool2D<Scalar>::pool(const Scalar* image, Scalar* output, std::uint8_t* argmax) const {
+  for (int oy = 0; oy < m_outputHeight; ++oy) {
+    for (int ox = 0; ox < m_outputWidth; ++ox) {
+      std::fill_n(output, m_channels, -std::numeric_limits<Scalar>::infinity());
+      if constexpr (RecordArgmax) {
+        std::fill_n(argmax, m_channels, std::uint8_t{0});
+      }
+
+      for (int ky = 0; ky < m_kernelSize; ++ky) {
+        const Scalar* row = image + (static_cast<Eigen::Index>(oy * m_stride + ky) * m_width + ox * m_stride) * m_channels;
+        for (int kx = 0; kx < m_kernelSize; ++kx) {
+          const Scalar* pixel = row + kx * m_channels;
+          const auto position = static_cast<std::uint8_t>(ky * m_kernelSize + kx);
+          // The channels of a pixel are contiguous, so this loop vectorizes.
+          #pragma omp simd
+          for (int c = 0; c < m_channels; ++c) {
+            const bool greater = pixel[c] > output[c];
+            output[c] = greater ? pixel[c] : output[c];
+            if constexpr (RecordArgmax) {
+              argmax[c] = greater ? position : argmax[c];
+            }
+          }
+        }
+      }
+
+      output += m_channels;
+      if constexpr (RecordArgmax) {
+        argmax += m_channels;
+      }
+    }
+  }
+}
+
+template <typename Scalar>
+const typename MaxPool2D<Scalar>::Matrix& MaxPool2D<Scalar>::forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const {
+  assert(input.rows() == inputSize());
+
+  const Eigen::Index batchSize = input.cols();
+  const Eigen::Index outputs = outputSize();
+  workspace.output.resize(outputs, batchSize);
+  std::vector<std::uint8_t>& argmax = workspace.template state<State>().argmax;
+  argmax.resize(static_cast<std::size_t>(outputs * batchSize));
+
+  #pragma omp parallel for schedule(static) if(workspace.output.size() >= kParallelPoolingThreshold)
+  for (Eigen::Index j = 0; j < batchSize; ++j) {
+    pool<true>(input.col(j).data(), workspace.output.col(j).data(), argmax.data() + j * outputs);
+  }
+
+  return workspace.output;
+}
+
+template <typename Scalar>
+void MaxPool2D<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const {
+  assert(input.rows() == inputSize());
+  assert(output.rows() == outputSize() && output.cols() == input.cols());
+
+  #pragma omp parallel for schedule(static) if(output.size() >= kParallelPoolingThreshold)
+  for (Eigen::Index j = 0; j < input.cols(); ++j) {
+    pool<false>(input.col(j).data(), output.col(j).data(), nullptr);
+  }
+}
+
+template <typename Scalar>
+const typename MaxPool2D<Scalar>::Matrix& MaxPool2D<Scalar>::backward(const Matrix& dOutput, Workspace& workspace, Eigen::Ref<Vector> gradients) const {
+  assert(dOutput.rows() == outputSize() && dOutput.cols() == workspace.output.cols());
+  assert(gradients.size() == 0);
+  static_cast<void>(gradients);
+
+  const Eigen::Index batchSize = dOutput.cols();
+  const Eigen::Index outputs = outputSize();
+  workspace.dInput.setZero(inputSize(), batchSize);
+  const std::vector<std::uint8_t>& positions = workspace.template state<State>().argmax;
+
+  // Overlapping windows may route several gradients to the same input, but
+  // only within a sample, so the samples can be processed in parallel.
+  #pragma omp parallel for schedule(static) if(dOutput.size() >= kParallelPoolingThreshold)
+  for (Eigen::Index j = 0; j < batchSize; ++j) {
+    const Scalar* dOut = dOutput.col(j).data();
+    const std::uint8_t* argmax = positions.data() + j * outputs;
+    Scalar* dIn = workspace.dInput.col(j).data();
+
+    for (int oy = 0; oy < m_outputHeight; ++oy) {
+      for (int ox = 0; ox < m_outputWidth; ++ox) {
+        for (int c = 0; c < m_channels; ++c) {
+          const int ky = *argmax / m_kernelSize;
+          const int kx = *argmax % m_kernelSize;
+          dIn[(static_cast<Eigen::Index>(oy * m_stride + ky) * m_width + ox * m_stride + kx) * m_channels + c] += *dOut;
+          ++argmax;
+          ++dOut;
+        }
+      }
+    }
+  }
+
+  return workspace.dInput;
+}
+
+template class MaxPool2D<float>;
+template class MaxPool2D<double>;
+
+}  // namespace dmlfs
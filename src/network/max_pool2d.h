@@ -0,0 +1,151 @@
+#ifndef MAX_POOL2D_H
+#define MAX_POOL2D_H
+
+#include "layer.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Two-dimensional max pooling layer
+ * @tparam Scalar Floating point type of the activations
+ *
+ * Images are laid out like for `Conv2D`: one per column, in height, width,
+ * channel order. Windows that do not fit entirely in the input are dropped,
+ * so the output is `(height - kernelSize) / stride + 1` pixels high, and
+ * likewise wide.
+ *
+ * The forward pass records, for every output value, the position of the
+ * maximum within its window as a single byte, which is why kernels are
+ * limited to 16x16. The backward pass is then a plain scatter of the output
+ * gradients to those positions. `predict` records nothing.
+ *
+ * The layer has no parameters, so it takes no room in a `Network`'s arenas.
+ */
+template <typename Scalar = double>
+class MaxPool2D: public Layer<Scalar> {
+public:
+  using typename Layer<Scalar>::Matrix;
+  using typename Layer<Scalar>::Vector;
+  using typename Layer<Scalar>::Workspace;
+  using Layer<Scalar>::forward;
+  using Layer<Scalar>::backward;
+  using Layer<Scalar>::predict;
+
+  /**
+   * @brief Constructor
+   * @param channels Number of channels of the input images
+   * @param height Height of the input images
+   * @param width Width of the input images
+   * @param kernelSize Height and width of the pooling windows, at most 16
+   * @param stride Step between two windows, the kernel size if zero
+   */
+  MaxPool2D(int channels, int height, int width, int kernelSize, int stride = 0);
+
+  /**
+   * @brief Number of values per input image, `height * width * channels`
+   */
+  Eigen::Index inputSize() const override {
+    return static_cast<Eigen::Index>(m_height) * m_width * m_channels;
+  }
+
+  /**
+   * @brief Number of values per output image, `outputHeight * outputWidth * channels`
+   */
+  Eigen::Index outputSize() const override {
+    return static_cast<Eigen::Index>(m_outputHeight) * m_outputWidth * m_channels;
+  }
+
+  /**
+   * @brief Pool a batch, recording the position of each maximum in the workspace
+   * @param input Images, one per column
+   * @param workspace Workspace receiving the positions and the output
+   * @return Pooled images, one per column, stored in `workspace`
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const override;
+
+  /**
+   * @brief Route each output gradient to the input that was the maximum of its window
+   * @param grad_output Derivative of the pooled images
+   * @param workspace Workspace filled by the matching `forward`
+   * @param gradients Empty span, the layer has no parameters
+   * @return Derivative of the input images, stored in `workspace`
+   */
+  const Matrix& backward(const Matrix& grad_output, Workspace& workspace, Eigen::Ref<Vector> gradients) const override;
+
+  /**
+   * @brief Inference-only pooling
+   * @param input Images, one per column
+   * @param output Preallocated matrix of size `outputSize() x input.cols()`
+   */
+  void predict(const Eigen::Ref<const Matrix>& input, Eigen::Ref<Matrix> output) const override;
+
+  /**
+   * @brief Getter for the height of the output images
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, outputHeight);
+
+  /**
+   * @brief Getter for the width of the output images
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(int, outputWidth);
+
+private:
+  /**
+   * @brief State kept in `Workspace::extension` between the forward and backward passes
+   */
+  struct State {
+    std::vector<std::uint8_t> argmax; ///< Position of each output's maximum within its window
+  };
+
+  /**
+   * @brief Pool one image, recording the positions of the maxima if asked to
+   */
+  template <bool RecordArgmax>
+  void pool(const Scalar* image, Scalar* output, std::uint8_t* argmax) const;
+
+  /**
+   * @brief Number of channels of the images
+   */
+  int m_channels;
+
+  /**
+   * @brief Height of the input images
+   */
+  int m_height;
+
+  /**
+   * @brief Width of the input images
+   */
+  int m_width;
+
+  /**
+   * @brief Height and width of the pooling windows
+   */
+  int m_kernelSize;
+
+  /**
+   * @brief Step between two windows
+   */
+  int m_stride;
+
+  /**
+   * @brief Height of the output images
+   */
+  int m_outputHeight;
+
+  /**
+   * @brief Width of the output images
+   */
+  int m_outputWidth;
+};
+
+}  // namespace dmlfs
+
+#endif /* MAX_POOL2D_H */
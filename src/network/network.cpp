@@ -1,25 +1,331 @@
 #include "network.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
 
 namespace dmlfs {
 
-Network& Network::addLayer(std::shared_ptr<Layer> layer) {
+namespace {
+
+/**
+ * @brief Round an arena offset up to a multiple of 64 bytes, so that every layer's span keeps the arena's alignment
+ */
+template <typename Scalar>
+Eigen::Index alignOffset(Eigen::Index offset) {
+  constexpr Eigen::Index alignment = 64 / sizeof(Scalar);
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+constexpr char kModelMagic[8] = {'D', 'M', 'L', 'F', 'S', 'N', 'E', 'T'};
+constexpr std::uint32_t kModelVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+/**
+ * @brief Fixed-size header at the start of a model file
+ *
+ * @see Network for the meaning of each field
+ */
+struct ModelHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byteOrder;
+  std::uint32_t scalarSize;
+  std::uint32_t reserved0;
+  std::uint64_t layerCount;
+  std::uint64_t arenaSize;
+  std::uint64_t arenaOffset;
+  std::uint64_t reserved1[2];
+};
+static_assert(sizeof(ModelHeader) == 64);
+
+/**
+ * @brief Entry of the layer table following the header
+ */
+struct LayerRecord {
+  std::uint64_t inputSize;
+  std::uint64_t outputSize;
+  std::uint64_t offset;
+  std::uint32_t activationType;
+  std::uint32_t reserved;
+};
+static_assert(sizeof(LayerRecord) == 32);
+
+/**
+ * @brief Byte offset of the arena in a model file with the given number of layers
+ */
+std::uint64_t arenaOffset(std::uint64_t layerCount) {
+  const std::uint64_t end = sizeof(ModelHeader) + layerCount * sizeof(LayerRecord);
+  return (end + 63) / 64 * 64;
+}
+
+}  // namespace
+
+template <typename Scalar>
+Network<Scalar>& Network<Scalar>::operator=(Network&& other) noexcept {
+  if (this != &other) {
+    m_layers = std::move(other.m_layers);
+    m_ownedParameters = std::move(other.m_ownedParameters);
+    m_mapping = std::move(other.m_mapping);
+    // Assigning a Map copies coefficients, so point it at the new arena instead.
+    new (&m_parameters) ParameterMap(other.m_parameters.data(), other.m_parameters.size());
+    m_gradients = std::move(other.m_gradients);
+    m_offsets = std::move(other.m_offsets);
+    m_inferenceContext = std::move(other.m_inferenceContext);
+  }
+  return *this;
+}
+
+template <typename Scalar>
+Network<Scalar> Network<Scalar>::load(const std::string& path) {
+  auto mapping = std::make_shared<MappedFile>(path);
+  const std::byte* data = mapping->data();
+  const std::size_t fileSize = mapping->size();
+
+  ModelHeader header;
+  if (fileSize < sizeof(header)) {
+    throw std::runtime_error(path + " is too small to be a model file");
+  }
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.magic, kModelMagic, sizeof(kModelMagic)) != 0) {
+    throw std::runtime_error(path + " is not a model file");
+  }
+  if (header.version != kModelVersion) {
+    throw std::runtime_error(path + " has unsupported model format version " + std::to_string(header.version));
+  }
+  if (header.byteOrder != kByteOrderMark) {
+    throw std::runtime_error(path + " was written with a different byte order");
+  }
+  if (header.scalarSize != sizeof(Scalar)) {
+    throw std::runtime_error(path + " holds " + std::to_string(8 * header.scalarSize) + "-bit parameters, expected "
+                             + std::to_string(8 * sizeof(Scalar)) + "-bit");
+  }
+  if (header.layerCount > (fileSize - sizeof(header)) / sizeof(LayerRecord)
+      || header.arenaOffset < arenaOffset(header.layerCount) || header.arenaOffset % 64 != 0
+      || header.arenaSize > (fileSize - std::min<std::uint64_t>(header.arenaOffset, fileSize)) / sizeof(Scalar)) {
+    throw std::runtime_error(path + " is truncated or has an invalid layout");
+  }
+
+  Network network;
+  network.m_mapping = mapping;
+  Scalar* arena = reinterpret_cast<Scalar*>(mapping->data() + header.arenaOffset);
+  new (&network.m_parameters) ParameterMap(arena, static_cast<Eigen::Index>(header.arenaSize));
+
+  for (std::uint64_t i = 0; i < header.layerCount; ++i) {
+    LayerRecord record;
+    std::memcpy(&record, data + sizeof(ModelHeader) + i * sizeof(LayerRecord), sizeof(record));
+
+    // Layers take int sizes, and bounding them first keeps the count from overflowing.
+    constexpr std::uint64_t maxSize = std::numeric_limits<int>::max();
+    if (record.inputSize > maxSize || record.outputSize > maxSize) {
+      throw std::runtime_error(path + " has an invalid record for layer " + std::to_string(i));
+    }
+    const std::uint64_t count = record.outputSize * (record.inputSize + 1);
+    if (record.offset > header.arenaSize || count > header.arenaSize - record.offset
+        || record.offset * sizeof(Scalar) % 64 != 0
+        || record.activationType > static_cast<std::uint32_t>(ActivationBase::Type::TANH)
+        || (i > 0 && record.inputSize != static_cast<std::uint64_t>(network.m_layers.back()->outputSize()))) {
+      throw std::runtime_error(path + " has an invalid record for layer " + std::to_string(i));
+    }
+
+    network.m_offsets.push_back(static_cast<Eigen::Index>(record.offset));
+    network.m_layers.push_back(std::make_shared<Layer<Scalar>>(static_cast<int>(record.inputSize),
+                                                               static_cast<int>(record.outputSize),
+                                                               static_cast<ActivationBase::Type>(record.activationType),
+                                                               arena + record.offset,
+                                                               nullptr));
+  }
+
+  return network;
+}
+
+template <typename Scalar>
+void Network<Scalar>::save(const std::string& path) const {
+  for (const auto& layer : m_layers) {
+    if (layer->inputSize() != layer->weights().cols() || layer->outputSize() != layer->weights().rows()) {
+      throw std::runtime_error("Cannot save " + path + ": the model format only describes dense layers");
+    }
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Cannot open " + path + " for writing");
+  }
+
+  ModelHeader header{};
+  std::memcpy(header.magic, kModelMagic, sizeof(kModelMagic));
+  header.version = kModelVersion;
+  header.byteOrder = kByteOrderMark;
+  header.scalarSize = sizeof(Scalar);
+  header.layerCount = m_layers.size();
+  header.arenaSize = static_cast<std::uint64_t>(m_parameters.size());
+  header.arenaOffset = arenaOffset(header.layerCount);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (std::size_t i = 0; i < m_layers.size(); ++i) {
+    LayerRecord record{};
+    record.inputSize = static_cast<std::uint64_t>(m_layers[i]->weights().cols());
+    record.outputSize = static_cast<std::uint64_t>(m_layers[i]->weights().rows());
+    record.offset = static_cast<std::uint64_t>(m_offsets[i]);
+    record.activationType = static_cast<std::uint32_t>(m_layers[i]->activationType());
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+  }
+
+  const std::uint64_t written = sizeof(ModelHeader) + m_layers.size() * sizeof(LayerRecord);
+  const char padding[64] = {};
+  file.write(padding, static_cast<std::streamsize>(header.arenaOffset - written));
+  file.write(reinterpret_cast<const char*>(m_parameters.data()),
+             static_cast<std::streamsize>(m_parameters.size() * sizeof(Scalar)));
+
+  if (!file) {
+    throw std::runtime_error("Cannot write " + path);
+  }
+}
+
+template <typename Scalar>
+void Network<Scalar>::allocateGradients() {
+  if (m_gradients.size() == m_parameters.size()) {
+    return;
+  }
+  m_gradients = Eigen::VectorX<Scalar>::Zero(m_parameters.size());
+  for (std::size_t i = 0; i < m_layers.size(); ++i) {
+    m_layers[i]->attach(m_parameters.data() + m_offsets[i], m_gradients.data() + m_offsets[i]);
+  }
+}
+
+template <typename Scalar>
+Network<Scalar>& Network<Scalar>::addLayer(std::shared_ptr<Layer<Scalar>> layer) {
   m_layers.push_back(layer);
+
+  m_offsets.clear();
+  Eigen::Index size = 0;
+  for (const auto& l : m_layers) {
+    m_offsets.push_back(size);
+    size = alignOffset<Scalar>(size + l->parameterCount());
+  }
+
+  Eigen::VectorX<Scalar> parameters = Eigen::VectorX<Scalar>::Zero(size);
+  Eigen::VectorX<Scalar> gradients = Eigen::VectorX<Scalar>::Zero(size);
+  for (std::size_t i = 0; i < m_layers.size(); ++i) {
+    m_layers[i]->bind(parameters.data() + m_offsets[i], gradients.data() + m_offsets[i]);
+  }
+  m_ownedParameters.swap(parameters);
+  new (&m_parameters) ParameterMap(m_ownedParameters.data(), size);
+  m_mapping.reset();
+  m_gradients.swap(gradients);
+
   return *this;
 }
 
-Network::Matrix Network::forward(const Matrix& input) {
-  Matrix output = input;
-  for (auto& layer : m_layers) {
-    output = layer->forward(output);
+template <typename Scalar>
+const typename Network<Scalar>::Matrix& Network<Scalar>::forward(const Eigen::Ref<const Matrix>& input) {
+  assert(!m_layers.empty());
+
+  const Matrix* output;
+  {
+    DMLFS_PROFILE_SCOPE(false, 0, *m_layers.front(), input.cols());
+    output = &m_layers.front()->forward(input);
+  }
+  for (std::size_t i = 1; i < m_layers.size(); ++i) {
+    DMLFS_PROFILE_SCOPE(false, static_cast<int>(i), *m_layers[i], input.cols());
+    output = &m_layers[i]->forward(*output);
   }
-  return output;
+  return *output;
 }
 
-void Network::backward(const Matrix& dLoss_Output) {
-  Matrix dOutput = dLoss_Output;
-  for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it) {
-    dOutput = (*it)->backward(dOutput);
+template <typename Scalar>
+const typename Network<Scalar>::Matrix& Network<Scalar>::forward(const Eigen::Ref<const Matrix>& input, TrainingContext<Scalar>& context) const {
+  assert(!m_layers.empty());
+
+  auto& workspaces = context.workspaces();
+  workspaces.resize(m_layers.size());
+
+  const Matrix* output;
+  {
+    DMLFS_PROFILE_SCOPE(false, 0, *m_layers.front(), input.cols());
+    output = &m_layers.front()->forward(input, workspaces.front());
   }
+  for (std::size_t i = 1; i < m_layers.size(); ++i) {
+    DMLFS_PROFILE_SCOPE(false, static_cast<int>(i), *m_layers[i], input.cols());
+    output = &m_layers[i]->forward(*output, workspaces[i]);
+  }
+  return *output;
 }
 
+template <typename Scalar>
+void Network<Scalar>::backward(const Matrix& dLoss_Output, TrainingContext<Scalar>& context) const {
+  auto& workspaces = context.workspaces();
+  assert(workspaces.size() == m_layers.size());
+
+  auto& gradients = context.gradients();
+  if (gradients.size() != m_parameters.size()) {
+    gradients = Eigen::VectorX<Scalar>::Zero(m_parameters.size());
+  }
+
+  const Matrix* dOutput = &dLoss_Output;
+  for (std::size_t i = m_layers.size(); i-- > 0;) {
+    DMLFS_PROFILE_SCOPE(true, static_cast<int>(i), *m_layers[i], dLoss_Output.cols());
+    dOutput = &m_layers[i]->backward(*dOutput, workspaces[i], gradients.segment(m_offsets[i], m_layers[i]->parameterCount()));
+  }
+}
+
+template <typename Scalar>
+typename Network<Scalar>::ConstMap Network<Scalar>::predict(const Eigen::Ref<const Matrix>& input, InferenceContext<Scalar>& context) const {
+  using MutableMap = Eigen::Map<Matrix>;
+
+  const Eigen::Index batchSize = input.cols();
+  Eigen::Index maxRows = input.rows();
+  for (const auto& layer : m_layers) {
+    maxRows = std::max(maxRows, layer->outputSize());
+  }
+  context.reserve(maxRows * batchSize);
+
+  if (m_layers.empty()) {
+    MutableMap(context.buffer(0), input.rows(), batchSize) = input;
+    return ConstMap(context.buffer(0), input.rows(), batchSize);
+  }
+
+  MutableMap first(context.buffer(0), m_layers.front()->outputSize(), batchSize);
+  m_layers.front()->predict(input, first, context.scratch());
+
+  for (std::size_t i = 1; i < m_layers.size(); ++i) {
+    ConstMap previous(context.buffer((i - 1) % 2), m_layers[i - 1]->outputSize(), batchSize);
+    MutableMap output(context.buffer(i % 2), m_layers[i]->outputSize(), batchSize);
+    m_layers[i]->predict(previous, output, context.scratch());
+  }
+
+  const std::size_t last = m_layers.size() - 1;
+  return ConstMap(context.buffer(last % 2), m_layers[last]->outputSize(), batchSize);
+}
+
+template <typename Scalar>
+typename Network<Scalar>::ConstMap Network<Scalar>::predict(const Eigen::Ref<const Matrix>& input) {
+  return predict(input, m_inferenceContext);
+}
+
+template <typename Scalar>
+const typename Network<Scalar>::Matrix& Network<Scalar>::backward(const Matrix& dLoss_Output) {
+  allocateGradients();
+
+  const Matrix* dOutput = &dLoss_Output;
+  for (std::size_t i = m_layers.size(); i-- > 0;) {
+    DMLFS_PROFILE_SCOPE(true, static_cast<int>(i), *m_layers[i], dLoss_Output.cols());
+    dOutput = &m_layers[i]->backward(*dOutput);
+  }
+  return *dOutput;
+}
+
+template class TrainingContext<float>;
+template class TrainingContext<double>;
+template class InferenceContext<float>;
+template class InferenceContext<double>;
+template class Network<float>;
+template class Network<double>;
+
 }  // namespace dmlfs
@@ -2,55 +2,389 @@
 #define NETWORK_H
 
 #include "CommonMacros.h"
+#include "MappedFile.h"
 #include "layer.h"
 
+#include <array>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace dmlfs {
 
+/**
+ * @brief Per-thread activation storage for inference
+ * @tparam Scalar Floating point type of the activations
+ *
+ * Holds the two ping-pong buffers that `Network::predict` alternates between,
+ * and the scratch matrix in which layers such as `Conv2D` lower their input.
+ * The network's parameters stay read-only during inference, so any number of
+ * threads can share a single `Network` as long as each one passes its own context.
+ */
+template <typename Scalar = double>
+class InferenceContext {
+public:
+  /**
+   * @brief Default constructor
+   */
+  DEFINE_DEFAULT_CTOR(InferenceContext);
+
+  /**
+   * @brief Grow both buffers to hold at least `size` coefficients
+   * @param size Number of coefficients needed per buffer
+   */
+  void reserve(Eigen::Index size) {
+    for (auto& buffer : m_buffers) {
+      if (buffer.size() < size) {
+        buffer.resize(size);
+      }
+    }
+  }
+
+  /**
+   * @brief Raw storage of one of the two buffers
+   * @param index Either 0 or 1
+   */
+  Scalar* buffer(std::size_t index) {
+    return m_buffers[index].data();
+  }
+
+  /**
+   * @brief Getter for the scratch matrix passed to `Layer::predict`
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(Eigen::MatrixX<Scalar>, scratch);
+
+private:
+  /**
+   * @brief Ping-pong activation storage
+   */
+  std::array<Eigen::VectorX<Scalar>, 2> m_buffers;
+
+  /**
+   * @brief Storage for the layers that lower their input, e.g. im2col patches
+   */
+  Eigen::MatrixX<Scalar> m_scratch;
+};
+
+/**
+ * @brief Per-thread training state
+ * @tparam Scalar Floating point type of the activations and gradients
+ *
+ * Holds one `Layer::Workspace` per layer, so that several threads can run
+ * forward and backward passes over a shared `Network` at the same time, and a
+ * flat gradient vector laid out like `Network::parameters()` receiving the
+ * gradients for the samples seen by the owning thread.
+ */
+template <typename Scalar = double>
+class TrainingContext {
+public:
+  using Workspace = typename Layer<Scalar>::Workspace;
+
+  /**
+   * @brief Default constructor
+   */
+  DEFINE_DEFAULT_CTOR(TrainingContext);
+
+  /**
+   * @brief Read-write getter for the per-layer workspaces
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(std::vector<Workspace>, workspaces);
+
+  /**
+   * @brief Getter for the per-layer workspaces
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(std::vector<Workspace>, workspaces);
+
+  /**
+   * @brief Read-write getter for the flat gradients
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(Eigen::VectorX<Scalar>, gradients);
+
+  /**
+   * @brief Getter for the flat gradients
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Eigen::VectorX<Scalar>, gradients);
+
+private:
+  /**
+   * @brief One workspace per layer of the network
+   */
+  std::vector<Workspace> m_workspaces;
+
+  /**
+   * @brief Gradients of all layers, laid out like the network's parameter arena
+   */
+  Eigen::VectorX<Scalar> m_gradients;
+};
+
+/**
+ * @brief Sequential stack of layers
+ * @tparam Scalar Floating point type of the parameters and activations
+ *
+ * The network owns the parameters of all its layers in one contiguous arena,
+ * and their gradients in another with the same layout. Each layer's span
+ * starts a multiple of 64 bytes into the arena, so it keeps the arena's
+ * alignment, and the layers see their part through
+ * `Eigen::Map` views. Optimizers and gradient reductions can then work on
+ * the whole model with a single vectorized loop.
+ *
+ * A network can be saved to a binary model file and loaded back by mapping
+ * the file, in which case the parameter arena is the mapping itself. The file
+ * starts with a 64-byte header:
+ *
+ * | Bytes | Content                                          |
+ * |-------|--------------------------------------------------|
+ * | 0-7   | Magic string `DMLFSNET`                          |
+ * | 8-11  | Format version, currently 1                      |
+ * | 12-15 | `0x01020304`, to detect a byte order mismatch    |
+ * | 16-19 | `sizeof(Scalar)`                                 |
+ * | 20-23 | Reserved, zero                                   |
+ * | 24-31 | Number of layers                                 |
+ * | 32-39 | Size of the arena, in scalars                    |
+ * | 40-47 | Byte offset of the arena within the file         |
+ * | 48-63 | Reserved, zero                                   |
+ *
+ * It is followed by one 32-byte record per layer, holding its input size,
+ * output size and offset within the arena as 64-bit integers, then its
+ * `Activation::Type` as a 32-bit integer and 4 reserved bytes. The arena
+ * comes last, starting on a 64-byte boundary, exactly as laid out in memory.
+ * All integers are in the byte order of the machine that wrote the file.
+ */
+template <typename Scalar = double>
 class Network {
 public:
-  using Matrix = Layer::Matrix;
+  using Matrix = typename Layer<Scalar>::Matrix;
+  using ConstMap = Eigen::Map<const Matrix>;
+  using ParameterMap = Eigen::Map<Eigen::VectorX<Scalar>>;
 
   /**
    * @brief Default constructor
    */
   DEFINE_DEFAULT_CTOR(Network);
 
+  /**
+   * @brief Load a network saved with `save`
+   * @param path Path of the model file
+   * @return Network whose parameters are a copy-on-write mapping of the file
+   *
+   * Nothing is parsed or copied beyond the layer table: the layers view the
+   * mapping directly, so loading takes the same time whatever the model size,
+   * and processes loading the same file share its pages until they modify
+   * them. The gradient arena is only allocated when first needed.
+   *
+   * Throws `std::runtime_error` if the file cannot be mapped or is not a
+   * valid model for this scalar type.
+   */
+  static Network load(const std::string& path);
+
+  /**
+   * @brief Save the layer sizes, activations and parameters to a model file
+   * @param path Path of the model file
+   *
+   * Throws `std::runtime_error` if the file cannot be written, or if a layer
+   * is not a dense `Layer`, e.g. a `Conv2D`, whose shape the format cannot describe.
+   *
+   * @see Network for the layout of the file
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @brief Networks are not copyable, since their layers view the network's arenas
+   */
+  Network(const Network&) = delete;
+  Network& operator=(const Network&) = delete;
+
+  /**
+   * @brief Move constructor, the arenas keep their addresses
+   */
+  Network(Network&&) = default;
+
+  /**
+   * @brief Move assignment, the arenas keep their addresses
+   */
+  Network& operator=(Network&& other) noexcept;
+
   /**
    * @brief Add a layer to the network
    * @param layer Layer to add
    * @return Reference to this network
+   *
+   * The arenas are reallocated and every layer is rebound to them, so a layer
+   * should belong to a single network.
    */
-  Network& addLayer(std::shared_ptr<Layer> layer);
+  Network& addLayer(std::shared_ptr<Layer<Scalar>> layer);
 
   /**
    * @brief Forward pass through the network
-   * @param input Input matrix
-   * @return Output matrix
+   * @param input Input matrix, or any contiguous-column view of one
+   * @return Output matrix, owned by the last layer's workspace
+   *
+   * Each layer consumes the previous layer's workspace directly, so no
+   * intermediate copies are made between layers.
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input);
+
+  /**
+   * @brief Forward pass recording its state in a per-thread context
+   * @param input Input matrix, or any contiguous-column view of one
+   * @param context Training state owned by the calling thread
+   * @return Output matrix, owned by `context`
+   *
+   * This only reads the parameters, so several threads can run it on the same
+   * network as long as each one passes its own context.
    */
-  Matrix forward(const Matrix& input);
+  const Matrix& forward(const Eigen::Ref<const Matrix>& input, TrainingContext<Scalar>& context) const;
+
+  /**
+   * @brief Backward pass from the state recorded in a per-thread context
+   * @param dLoss_Output Gradient of the loss with respect to the output
+   * @param context Context filled by the matching `forward`, receiving the gradients
+   *
+   * The gradients are left in `context` for the caller to reduce; the layers'
+   * own gradients are not touched.
+   */
+  void backward(const Matrix& dLoss_Output, TrainingContext<Scalar>& context) const;
+
+  /**
+   * @brief Inference-only forward pass through the network
+   * @param input Input matrix, or any contiguous-column view of one
+   * @param context Activation storage owned by the calling thread
+   * @return View of the output, valid until the next call using `context`
+   *
+   * Nothing is recorded for backpropagation. The layers alternate between two
+   * buffers sized for the widest layer, so peak memory does not grow with
+   * depth, and repeated calls with the same batch size do not allocate.
+   *
+   * This only reads the parameters, so concurrent calls with distinct contexts
+   * are safe as long as no thread trains the network at the same time.
+   */
+  ConstMap predict(const Eigen::Ref<const Matrix>& input, InferenceContext<Scalar>& context) const;
+
+  /**
+   * @brief Inference-only forward pass using the network's own context
+   * @param input Input matrix, or any contiguous-column view of one
+   * @return View of the output, valid until the next call to `predict`
+   *
+   * Convenience overload for single-threaded use.
+   */
+  ConstMap predict(const Eigen::Ref<const Matrix>& input);
 
   /**
    * @brief Backward pass through the network
    * @param dLoss_Output Gradient of the loss with respect to the output
+   * @return Gradient of the loss with respect to the input, owned by the first layer
+   *
+   * The returned gradient lets a layer feeding the network, such as a
+   * `SparseInputLayer`, continue the backward pass.
    */
-  void backward(const Matrix& dLoss_Output);
+  const Matrix& backward(const Matrix& dLoss_Output);
 
   /**
    * @brief Read-write getter for the layers
    *
    * @see CommonMacros.h
    */
-  DEFINE_GETTER(std::vector<std::shared_ptr<Layer>>, layers);
+  DEFINE_GETTER(std::vector<std::shared_ptr<Layer<Scalar>>>, layers);
+
+  /**
+   * @brief Getter for the layers
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(std::vector<std::shared_ptr<Layer<Scalar>>>, layers);
+
+  /**
+   * @brief Read-write getter for the parameter arena
+   *
+   * The values may be modified in place, but the vector must not be resized.
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(ParameterMap, parameters);
+
+  /**
+   * @brief Getter for the parameter arena
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(ParameterMap, parameters);
+
+  /**
+   * @brief Read-write getter for the gradient arena
+   *
+   * The values may be modified in place, but the vector must not be resized.
+   * Allocates the arena if the network was loaded and has not been trained yet.
+   */
+  Eigen::VectorX<Scalar>& gradients() {
+    allocateGradients();
+    return m_gradients;
+  }
+
+  /**
+   * @brief Getter for the gradient arena
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Eigen::VectorX<Scalar>, gradients);
+
+  /**
+   * @brief Getter for the offset of each layer's span within the arenas
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(std::vector<Eigen::Index>, offsets);
 
 private:
 
+  /**
+   * @brief Allocate the gradient arena and point the layers at it, if not done yet
+   */
+  void allocateGradients();
+
   /**
    * @brief Layers in the network
    */
-  std::vector<std::shared_ptr<Layer>> m_layers;
+  std::vector<std::shared_ptr<Layer<Scalar>>> m_layers;
+
+  /**
+   * @brief Storage of the parameter arena, unless the network was loaded from a file
+   */
+  Eigen::VectorX<Scalar> m_ownedParameters;
+
+  /**
+   * @brief Mapping of the model file holding the parameter arena, if the network was loaded from one
+   */
+  std::shared_ptr<MappedFile> m_mapping;
+
+  /**
+   * @brief Parameters of all layers, viewing either the owned storage or the mapping
+   */
+  ParameterMap m_parameters{nullptr, 0};
+
+  /**
+   * @brief Gradients of all layers, with the same layout as the parameters
+   */
+  Eigen::VectorX<Scalar> m_gradients;
+
+  /**
+   * @brief Start of each layer's span within the arenas
+   */
+  std::vector<Eigen::Index> m_offsets;
+
+  /**
+   * @brief Activation storage used by the single-threaded `predict` overload
+   */
+  InferenceContext<Scalar> m_inferenceContext;
 };
 
 } // namespace dmlfs
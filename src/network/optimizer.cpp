@@ -1,20 +1,284 @@
 #include "optimizer.h"
+#include "profiler.h"
+
+#include <cassert>
+#include <cmath>
 
 namespace dmlfs {
 
-SGD::SGD(double learningRate):
+namespace {
+
+/**
+ * @brief Arena size from which the fused optimizer kernels are spread over threads
+ *
+ * Below it, the cost of waking up the OpenMP team outweighs the work.
+ */
+constexpr Eigen::Index kParallelUpdateThreshold = 1 << 16;
+
+/**
+ * @brief Step of the Adam algorithm for a given timestep
+ *
+ * Both bias corrections are folded into the step size and the epsilon, so
+ * the update of a parameter only needs one square root and one division.
+ */
+template <typename Scalar>
+struct AdamStep {
+  Scalar beta1;     ///< Decay rate of the first moment
+  Scalar beta2;     ///< Decay rate of the second moment
+  Scalar stepSize;  ///< Learning rate with both bias corrections
+  Scalar epsilon;   ///< Epsilon scaled by the second bias correction
+  Scalar decay;     ///< Factor applied to the parameter before the step, 1 without weight decay
+
+  AdamStep(Scalar learningRate, Scalar beta1, Scalar beta2, Scalar epsilon, Scalar weightDecay, long t):
+      beta1{beta1},
+      beta2{beta2},
+      decay{Scalar(1) - learningRate * weightDecay}
+  {
+    const Scalar correction1 = Scalar(1) - std::pow(beta1, Scalar(t));
+    const Scalar correction2 = std::sqrt(Scalar(1) - std::pow(beta2, Scalar(t)));
+    stepSize = learningRate * correction2 / correction1;
+    this->epsilon = epsilon * correction2;
+  }
+
+  /**
+   * @brief Update a parameter and its moments with its gradient
+   */
+  void apply(Scalar& parameter, Scalar& firstMoment, Scalar& secondMoment, Scalar g) const {
+    const Scalar m = beta1 * firstMoment + (Scalar(1) - beta1) * g;
+    const Scalar v = beta2 * secondMoment + (Scalar(1) - beta2) * g * g;
+    firstMoment = m;
+    secondMoment = v;
+    parameter = decay * parameter - stepSize * m / (std::sqrt(v) + epsilon);
+  }
+};
+
+/**
+ * @brief Apply an element-wise update to the parameters of a sparse input layer touched by a backward pass
+ * @param layer Layer to update
+ * @param workspace Workspace filled by the layer's `backward`
+ * @param update Called with a parameter, its gradient, then its entry of each state
+ * @param states Per-parameter states of the optimizer, shaped like the layer's parameters
+ *
+ * The continuous weights and the biases are always updated, the embedding
+ * table only in the columns of the touched categories.
+ */
+template <typename Scalar, typename Update, typename... States>
+void updateTouched(SparseInputLayer<Scalar>& layer,
+                   const typename SparseInputLayer<Scalar>::Workspace& workspace,
+                   const Update& update,
+                   States&... states) {
+  assert(workspace.weights_grad.size() == layer.weights().size());
+  assert(workspace.biases_grad.size() == layer.biases().size());
+
+  for (Eigen::Index i = 0; i < layer.weights().size(); ++i) {
+    update(layer.weights()(i), workspace.weights_grad(i), states.weights(i)...);
+  }
+  for (Eigen::Index i = 0; i < layer.biases().size(); ++i) {
+    update(layer.biases()(i), workspace.biases_grad(i), states.biases(i)...);
+  }
+
+  // The touched categories are distinct, so the columns can be updated in parallel.
+  const Eigen::Index rows = layer.embeddings().rows();
+  const Eigen::Index touched = static_cast<Eigen::Index>(workspace.touched.size());
+  #pragma omp parallel for schedule(static) if(touched * rows >= kParallelUpdateThreshold)
+  for (Eigen::Index j = 0; j < touched; ++j) {
+    const Eigen::Index category = workspace.touched[j];
+    for (Eigen::Index i = 0; i < rows; ++i) {
+      update(layer.embeddings()(i, category), workspace.embeddings_grad(i, j), states.embeddings(i, category)...);
+    }
+  }
+}
+
+/**
+ * @brief Number of parameters updated by `updateTouched`
+ */
+template <typename Scalar>
+double touchedSize(const SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) {
+  return static_cast<double>(layer.weights().size() + layer.biases().size())
+       + static_cast<double>(workspace.touched.size()) * layer.embeddings().rows();
+}
+
+}  // namespace
+
+template <typename Scalar>
+void SparseLayerState<Scalar>::prepare(const SparseInputLayer<Scalar>& layer) {
+  if (weights.rows() != layer.weights().rows() || weights.cols() != layer.weights().cols()
+   || embeddings.rows() != layer.embeddings().rows() || embeddings.cols() != layer.embeddings().cols()) {
+    weights = Eigen::MatrixX<Scalar>::Zero(layer.weights().rows(), layer.weights().cols());
+    biases = Eigen::MatrixX<Scalar>::Zero(layer.biases().rows(), layer.biases().cols());
+    embeddings = Eigen::MatrixX<Scalar>::Zero(layer.embeddings().rows(), layer.embeddings().cols());
+  }
+}
+
+template <typename Scalar>
+SGD<Scalar>::SGD(Scalar learningRate):
     m_learningRate{learningRate}
 {
 }
 
-void SGD::update(Network& network) {
-  for (auto& layer : network.layers()) {
-    Network::Matrix weights_grad = layer->weights_grad();
-    Network::Matrix biases_grad = layer->biases_grad();
+template <typename Scalar>
+void SGD<Scalar>::update(Network<Scalar>& network) {
+  DMLFS_PROFILE_SCOPE(updatePhase(), 2.0 * network.parameters().size(), 3.0 * network.parameters().size() * sizeof(Scalar));
+  network.parameters() -= m_learningRate * network.gradients();
+}
+
+template <typename Scalar>
+void SGD<Scalar>::update(Network<Scalar>& network, const TrainingContext<Scalar>& context) {
+  DMLFS_PROFILE_SCOPE(updatePhase(), 2.0 * network.parameters().size(), 3.0 * network.parameters().size() * sizeof(Scalar));
+  network.parameters() -= m_learningRate * context.gradients();
+}
+
+template <typename Scalar>
+void SGD<Scalar>::update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) {
+  const double size = touchedSize(layer, workspace);
+  DMLFS_PROFILE_SCOPE(updatePhase(), 2.0 * size, 3.0 * size * sizeof(Scalar));
+  const Scalar learningRate = m_learningRate;
+  updateTouched(layer, workspace, [learningRate](Scalar& parameter, Scalar g) {
+    parameter -= learningRate * g;
+  });
+}
+
+template <typename Scalar>
+Momentum<Scalar>::Momentum(Scalar learningRate, Scalar momentum):
+    m_learningRate{learningRate},
+    m_momentum{momentum}
+{
+}
 
-    layer->updateWeights(-m_learningRate * weights_grad);
-    layer->updateBiases(-m_learningRate * biases_grad);
+template <typename Scalar>
+void Momentum<Scalar>::prepare(const Network<Scalar>& network) {
+  if (m_velocity.size() != network.parameters().size()) {
+    m_velocity = Eigen::VectorX<Scalar>::Zero(network.parameters().size());
   }
 }
 
+template <typename Scalar>
+void Momentum<Scalar>::update(Network<Scalar>& network) {
+  prepare(network);
+  step(network.parameters().data(), network.gradients().data(), network.parameters().size());
+}
+
+template <typename Scalar>
+void Momentum<Scalar>::update(Network<Scalar>& network, const TrainingContext<Scalar>& context) {
+  prepare(network);
+  assert(context.gradients().size() == network.parameters().size());
+  step(network.parameters().data(), context.gradients().data(), network.parameters().size());
+}
+
+template <typename Scalar>
+void Momentum<Scalar>::update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) {
+  const double size = touchedSize(layer, workspace);
+  DMLFS_PROFILE_SCOPE(updatePhase(), 4.0 * size, 5.0 * size * sizeof(Scalar));
+  SparseLayerState<Scalar>& velocity = m_sparseVelocity[&layer];
+  velocity.prepare(layer);
+
+  const Scalar learningRate = m_learningRate;
+  const Scalar momentum = m_momentum;
+  updateTouched(layer, workspace, [learningRate, momentum](Scalar& parameter, Scalar g, Scalar& velocity) {
+    velocity = momentum * velocity + g;
+    parameter -= learningRate * velocity;
+  }, velocity);
+}
+
+template <typename Scalar>
+void Momentum<Scalar>::step(Scalar* __restrict parameters, const Scalar* __restrict gradients, Eigen::Index size) {
+  DMLFS_PROFILE_SCOPE(updatePhase(), 4.0 * size, 5.0 * size * sizeof(Scalar));
+  Scalar* __restrict velocity = m_velocity.data();
+  const Scalar learningRate = m_learningRate;
+  const Scalar momentum = m_momentum;
+
+  #pragma omp parallel for simd schedule(static) if(size >= kParallelUpdateThreshold)
+  for (Eigen::Index i = 0; i < size; ++i) {
+    const Scalar v = momentum * velocity[i] + gradients[i];
+    velocity[i] = v;
+    parameters[i] -= learningRate * v;
+  }
+}
+
+template <typename Scalar>
+Adam<Scalar>::Adam(Scalar learningRate, Scalar beta1, Scalar beta2, Scalar epsilon):
+    Adam{learningRate, beta1, beta2, epsilon, Scalar(0)}
+{
+}
+
+template <typename Scalar>
+Adam<Scalar>::Adam(Scalar learningRate, Scalar beta1, Scalar beta2, Scalar epsilon, Scalar weightDecay):
+    m_learningRate{learningRate},
+    m_beta1{beta1},
+    m_beta2{beta2},
+    m_epsilon{epsilon},
+    m_weightDecay{weightDecay}
+{
+}
+
+template <typename Scalar>
+void Adam<Scalar>::prepare(const Network<Scalar>& network) {
+  if (m_firstMoment.size() != network.parameters().size()) {
+    m_firstMoment = Eigen::VectorX<Scalar>::Zero(network.parameters().size());
+    m_secondMoment = Eigen::VectorX<Scalar>::Zero(network.parameters().size());
+    m_timestep.store(0, std::memory_order_relaxed);
+  }
+}
+
+template <typename Scalar>
+void Adam<Scalar>::update(Network<Scalar>& network) {
+  prepare(network);
+  step(network.parameters().data(), network.gradients().data(), network.parameters().size());
+}
+
+template <typename Scalar>
+void Adam<Scalar>::update(Network<Scalar>& network, const TrainingContext<Scalar>& context) {
+  prepare(network);
+  assert(context.gradients().size() == network.parameters().size());
+  step(network.parameters().data(), context.gradients().data(), network.parameters().size());
+}
+
+template <typename Scalar>
+void Adam<Scalar>::update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) {
+  const double size = touchedSize(layer, workspace);
+  DMLFS_PROFILE_SCOPE(updatePhase(), 13.0 * size, 7.0 * size * sizeof(Scalar));
+  SparseMoments& moments = m_sparseMoments[&layer];
+  moments.first.prepare(layer);
+  moments.second.prepare(layer);
+
+  const AdamStep<Scalar> adam{m_learningRate, m_beta1, m_beta2, m_epsilon, m_weightDecay, ++moments.timestep};
+  updateTouched(layer, workspace, [&adam](Scalar& parameter, Scalar g, Scalar& firstMoment, Scalar& secondMoment) {
+    adam.apply(parameter, firstMoment, secondMoment, g);
+  }, moments.first, moments.second);
+}
+
+template <typename Scalar>
+void Adam<Scalar>::step(Scalar* __restrict parameters, const Scalar* __restrict gradients, Eigen::Index size) {
+  DMLFS_PROFILE_SCOPE(updatePhase(), 13.0 * size, 7.0 * size * sizeof(Scalar));
+  const long t = m_timestep.fetch_add(1, std::memory_order_relaxed) + 1;
+  const AdamStep<Scalar> adam{m_learningRate, m_beta1, m_beta2, m_epsilon, m_weightDecay, t};
+
+  Scalar* __restrict firstMoment = m_firstMoment.data();
+  Scalar* __restrict secondMoment = m_secondMoment.data();
+
+  #pragma omp parallel for simd schedule(static) if(size >= kParallelUpdateThreshold)
+  for (Eigen::Index i = 0; i < size; ++i) {
+    adam.apply(parameters[i], firstMoment[i], secondMoment[i], gradients[i]);
+  }
+}
+
+template <typename Scalar>
+AdamW<Scalar>::AdamW(Scalar learningRate, Scalar weightDecay, Scalar beta1, Scalar beta2, Scalar epsilon):
+    Adam<Scalar>{learningRate, beta1, beta2, epsilon, weightDecay}
+{
+}
+
+template struct SparseLayerState<float>;
+template struct SparseLayerState<double>;
+template class Optimizer<float>;
+template class Optimizer<double>;
+template class SGD<float>;
+template class SGD<double>;
+template class Momentum<float>;
+template class Momentum<double>;
+template class Adam<float>;
+template class Adam<double>;
+template class AdamW<float>;
+template class AdamW<double>;
+
 }  // namespace dmlfs
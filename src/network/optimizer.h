@@ -2,12 +2,37 @@
 #define OPTIMIZER_H_
 
 #include "network.h"
+#include "sparse_input_layer.h"
+
+#include "Eigen/Dense"
+
+#include <atomic>
+#include <unordered_map>
 
 namespace dmlfs {
 
+/**
+ * @brief Per-parameter state kept by an optimizer for a `SparseInputLayer`, shaped like its parameters
+ * @tparam Scalar Floating point type of the layer's parameters
+ */
+template <typename Scalar = double>
+struct SparseLayerState {
+  Eigen::MatrixX<Scalar> weights;     ///< State of the continuous weights
+  Eigen::MatrixX<Scalar> biases;      ///< State of the biases
+  Eigen::MatrixX<Scalar> embeddings;  ///< State of the embedding table, only accessed through touched columns
+
+  /**
+   * @brief Zero the state unless it already has the shape of the layer's parameters
+   * @param layer Layer the state belongs to
+   */
+  void prepare(const SparseInputLayer<Scalar>& layer);
+};
+
 /**
  * @brief Abstract class for optimizers
+ * @tparam Scalar Floating point type of the network's parameters
  */
+template <typename Scalar = double>
 class Optimizer {
 public:
 
@@ -15,7 +40,46 @@ public:
    * @brief Update the weights and biases of the network
    * @param network Network to update
    */
-  virtual void update(Network& network) = 0;
+  virtual void update(Network<Scalar>& network) = 0;
+
+  /**
+   * @brief Update the weights and biases of the network from gradients held in a context
+   * @param network Network to update
+   * @param context Training context whose workspaces hold the gradients to apply
+   *
+   * Used by asynchronous training, where each worker applies its own gradients
+   * straight to the shared parameters without going through the layers.
+   */
+  virtual void update(Network<Scalar>& network, const TrainingContext<Scalar>& context) = 0;
+
+  /**
+   * @brief Update a sparse input layer with the gradients of one of its backward passes
+   * @param layer Layer to update
+   * @param workspace Workspace filled by the layer's `backward`
+   *
+   * Only the embeddings of the categories seen in the mini-batch are
+   * written, and only their share of the optimizer's per-parameter state is
+   * read and written. The state of the other embeddings is left as is until
+   * their category is seen again, as in "lazy" Adam. Updates of the same
+   * layer must not run concurrently.
+   */
+  virtual void update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) = 0;
+
+  /**
+   * @brief Allocate any per-parameter state needed to update the given network
+   * @param network Network that will be updated
+   *
+   * Stateful optimizers otherwise allocate it on their first update. Must be
+   * called before updates are applied from several threads at once.
+   */
+  virtual void prepare(const Network<Scalar>& /*network*/) {}
+
+  /**
+   * @brief Name under which the profiler records the updates, e.g. `"SGD::update"`
+   */
+  virtual const char* updatePhase() const {
+    return "Optimizer::update";
+  }
 
   /**
    * @brief Virtual destructor
@@ -26,27 +90,296 @@ public:
 /**
  * @brief Concrete class for Stochastic Gradient Descent (SGD) optimizer
  */
-class SGD : public Optimizer {
+template <typename Scalar = double>
+class SGD : public Optimizer<Scalar> {
 public:
 
   /**
    * @brief Constructor
    * @param learningRate Learning rate
    */
-  explicit SGD(double learningRate);
+  explicit SGD(Scalar learningRate);
+
+  /**
+   * @brief Update the weights and biases of the network according to the SGD algorithm
+   * @param network Network to update
+   */
+  void update(Network<Scalar>& network) override;
 
   /**
    * @brief Update the weights and biases of the network according to the SGD algorithm
    * @param network Network to update
+   * @param context Training context whose workspaces hold the gradients to apply
+   */
+  void update(Network<Scalar>& network, const TrainingContext<Scalar>& context) override;
+
+  /**
+   * @brief Update the touched parameters of a sparse input layer according to the SGD algorithm
+   * @param layer Layer to update
+   * @param workspace Workspace filled by the layer's `backward`
+   */
+  void update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) override;
+
+  /**
+   * @brief Name under which the profiler records the updates
+   */
+  const char* updatePhase() const override {
+    return "SGD::update";
+  }
+
+private:
+
+  /**
+   * @brief Learning rate
+   */
+  Scalar m_learningRate;
+};
+
+/**
+ * @brief SGD with (heavy ball) momentum
+ *
+ * Keeps a velocity per parameter and applies, in a single pass over the
+ * network's parameter arena,
+ * `v = momentum * v + g` followed by `p -= learningRate * v`.
+ */
+template <typename Scalar = double>
+class Momentum : public Optimizer<Scalar> {
+public:
+
+  /**
+   * @brief Constructor
+   * @param learningRate Learning rate
+   * @param momentum Decay factor of the velocity
+   */
+  Momentum(Scalar learningRate, Scalar momentum = 0.9);
+
+  /**
+   * @brief Update the weights and biases of the network according to the momentum algorithm
+   * @param network Network to update
+   */
+  void update(Network<Scalar>& network) override;
+
+  /**
+   * @brief Update the weights and biases of the network according to the momentum algorithm
+   * @param network Network to update
+   * @param context Training context whose workspaces hold the gradients to apply
+   */
+  void update(Network<Scalar>& network, const TrainingContext<Scalar>& context) override;
+
+  /**
+   * @brief Update the touched parameters of a sparse input layer according to the momentum algorithm
+   * @param layer Layer to update
+   * @param workspace Workspace filled by the layer's `backward`
+   *
+   * The velocity of an embedding only decays in the steps where its
+   * category is seen.
+   */
+  void update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) override;
+
+  /**
+   * @brief Name under which the profiler records the updates
+   */
+  const char* updatePhase() const override {
+    return "Momentum::update";
+  }
+
+  /**
+   * @brief Allocate the velocities
+   * @param network Network that will be updated
+   */
+  void prepare(const Network<Scalar>& network) override;
+
+private:
+
+  /**
+   * @brief Fused velocity and parameter update over the whole arena
+   */
+  void step(Scalar* parameters, const Scalar* gradients, Eigen::Index size);
+
+  /**
+   * @brief Learning rate
+   */
+  Scalar m_learningRate;
+
+  /**
+   * @brief Decay factor of the velocity
+   */
+  Scalar m_momentum;
+
+  /**
+   * @brief Velocity of each parameter, laid out like the network's arena
+   */
+  Eigen::VectorX<Scalar> m_velocity;
+
+  /**
+   * @brief Velocities of the parameters of each sparse input layer updated so far
+   */
+  std::unordered_map<const SparseInputLayer<Scalar>*, SparseLayerState<Scalar>> m_sparseVelocity;
+};
+
+/**
+ * @brief Adam optimizer
+ *
+ * Keeps bias-corrected running averages of the gradients and of their
+ * squares, and updates every parameter with one fused pass reading the
+ * gradient and both moments and writing the moments and the parameter in
+ * place.
+ */
+template <typename Scalar = double>
+class Adam : public Optimizer<Scalar> {
+public:
+
+  /**
+   * @brief Constructor
+   * @param learningRate Learning rate
+   * @param beta1 Decay factor of the first moment
+   * @param beta2 Decay factor of the second moment
+   * @param epsilon Term added to the denominator for numerical stability
+   */
+  explicit Adam(Scalar learningRate,
+                Scalar beta1 = 0.9,
+                Scalar beta2 = 0.999,
+                Scalar epsilon = 1e-8);
+
+  /**
+   * @brief Update the weights and biases of the network according to the Adam algorithm
+   * @param network Network to update
+   */
+  void update(Network<Scalar>& network) override;
+
+  /**
+   * @brief Update the weights and biases of the network according to the Adam algorithm
+   * @param network Network to update
+   * @param context Training context whose workspaces hold the gradients to apply
+   *
+   * Concurrent calls share the moments without locking, like the parameters.
+   */
+  void update(Network<Scalar>& network, const TrainingContext<Scalar>& context) override;
+
+  /**
+   * @brief Update the touched parameters of a sparse input layer according to the Adam algorithm
+   * @param layer Layer to update
+   * @param workspace Workspace filled by the layer's `backward`
+   *
+   * The moments of an embedding, and its weight decay if any, are only
+   * updated in the steps where its category is seen. The bias correction
+   * counts the updates of the layer, apart from those of any network.
+   */
+  void update(SparseInputLayer<Scalar>& layer, const typename SparseInputLayer<Scalar>::Workspace& workspace) override;
+
+  /**
+   * @brief Name under which the profiler records the updates
+   */
+  const char* updatePhase() const override {
+    return "Adam::update";
+  }
+
+  /**
+   * @brief Allocate the moments
+   * @param network Network that will be updated
+   */
+  void prepare(const Network<Scalar>& network) override;
+
+protected:
+
+  /**
+   * @brief Constructor with decoupled weight decay, used by `AdamW`
    */
-  void update(Network& network) override;
+  Adam(Scalar learningRate, Scalar beta1, Scalar beta2, Scalar epsilon, Scalar weightDecay);
 
 private:
 
+  /**
+   * @brief Fused moments and parameter update over the whole arena
+   */
+  void step(Scalar* parameters, const Scalar* gradients, Eigen::Index size);
+
   /**
    * @brief Learning rate
    */
-  double m_learningRate;
+  Scalar m_learningRate;
+
+  /**
+   * @brief Decay factor of the first moment
+   */
+  Scalar m_beta1;
+
+  /**
+   * @brief Decay factor of the second moment
+   */
+  Scalar m_beta2;
+
+  /**
+   * @brief Term added to the denominator for numerical stability
+   */
+  Scalar m_epsilon;
+
+  /**
+   * @brief Decoupled weight decay, zero for plain Adam
+   */
+  Scalar m_weightDecay;
+
+  /**
+   * @brief Number of updates applied so far, used for the bias correction
+   */
+  std::atomic<long> m_timestep{0};
+
+  /**
+   * @brief Running average of the gradients, laid out like the network's arena
+   */
+  Eigen::VectorX<Scalar> m_firstMoment;
+
+  /**
+   * @brief Running average of the squared gradients, laid out like the network's arena
+   */
+  Eigen::VectorX<Scalar> m_secondMoment;
+
+  /**
+   * @brief Moments and number of updates of a sparse input layer
+   */
+  struct SparseMoments {
+    SparseLayerState<Scalar> first;   ///< Running average of the gradients
+    SparseLayerState<Scalar> second;  ///< Running average of the squared gradients
+    long timestep = 0;                ///< Number of updates applied to the layer so far
+  };
+
+  /**
+   * @brief Moments of the parameters of each sparse input layer updated so far
+   */
+  std::unordered_map<const SparseInputLayer<Scalar>*, SparseMoments> m_sparseMoments;
+};
+
+/**
+ * @brief Adam with decoupled weight decay
+ *
+ * Every parameter additionally shrinks by `learningRate * weightDecay * p`
+ * per step, independently of the adaptive scaling. The decay is fused in
+ * the same pass as the Adam update.
+ */
+template <typename Scalar = double>
+class AdamW : public Adam<Scalar> {
+public:
+
+  /**
+   * @brief Constructor
+   * @param learningRate Learning rate
+   * @param weightDecay Decoupled weight decay
+   * @param beta1 Decay factor of the first moment
+   * @param beta2 Decay factor of the second moment
+   * @param epsilon Term added to the denominator for numerical stability
+   */
+  explicit AdamW(Scalar learningRate,
+                 Scalar weightDecay = 0.01,
+                 Scalar beta1 = 0.9,
+                 Scalar beta2 = 0.999,
+                 Scalar epsilon = 1e-8);
+
+  /**
+   * @brief Name under which the profiler records the updates
+   */
+  const char* updatePhase() const override {
+    return "AdamW::update";
+  }
 };
 
 }  // namespace dmlfs
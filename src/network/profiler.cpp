@@ -0,0 +1,151 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace dmlfs {
+
+namespace {
+
+/**
+ * @brief Human-readable name of the layer or optimizer an event belongs to
+ */
+std::string eventName(const ProfileEvent& event) {
+  if (event.layer < 0) {
+    return event.phase;
+  }
+  return "layer " + std::to_string(event.layer) + " " + event.phase;
+}
+
+}  // namespace
+
+Profiler& Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler():
+    m_origin{Clock::now()}
+{
+}
+
+Profiler::ThreadBuffer& Profiler::buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> local = [this] {
+    auto created = std::make_shared<ThreadBuffer>();
+    std::lock_guard lock{m_mutex};
+    created->thread = static_cast<int>(m_buffers.size());
+    m_buffers.push_back(created);
+    return created;
+  }();
+  return *local;
+}
+
+void Profiler::record(ProfileEvent event) {
+  ThreadBuffer& local = buffer();
+  event.thread = local.thread;
+  std::lock_guard lock{local.mutex};
+  local.events.push_back(event);
+}
+
+std::vector<ProfileEvent> Profiler::events() const {
+  std::vector<ProfileEvent> all;
+  {
+    std::lock_guard lock{m_mutex};
+    for (const auto& buffer : m_buffers) {
+      std::lock_guard bufferLock{buffer->mutex};
+      all.insert(all.end(), buffer->events.begin(), buffer->events.end());
+    }
+  }
+  std::stable_sort(all.begin(), all.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+    return a.start < b.start;
+  });
+  return all;
+}
+
+void Profiler::clear() {
+  std::lock_guard lock{m_mutex};
+  for (const auto& buffer : m_buffers) {
+    std::lock_guard bufferLock{buffer->mutex};
+    buffer->events.clear();
+  }
+}
+
+void Profiler::writeChromeTrace(const std::string& path) const {
+  std::ofstream ofs{path};
+  if (!ofs) {
+    throw std::runtime_error("Cannot open " + path + " for writing");
+  }
+
+  // Complete ("X") events, with times in microseconds as the format expects.
+  const auto events = this->events();
+  char buffer[512];
+  ofs << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    const auto& event = events[i];
+    const double ns = std::max<double>(1, static_cast<double>(event.duration));
+    std::snprintf(buffer, sizeof(buffer),
+                  "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, "
+                  "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"layer\": %d, \"inputs\": %ld, \"outputs\": %ld, "
+                  "\"batch\": %ld, \"flops\": %.0f, \"bytes\": %.0f, \"GFLOP/s\": %.3f, \"GB/s\": %.3f}}",
+                  i == 0 ? "" : ",", eventName(event).c_str(), event.phase, event.thread,
+                  static_cast<double>(event.start) / 1e3, static_cast<double>(event.duration) / 1e3,
+                  event.layer, static_cast<long>(event.inputSize), static_cast<long>(event.outputSize),
+                  static_cast<long>(event.batchSize), event.flops, event.bytes, event.flops / ns, event.bytes / ns);
+    ofs << buffer;
+  }
+  ofs << "\n]}\n";
+
+  if (!ofs) {
+    throw std::runtime_error("Failed to write " + path);
+  }
+}
+
+std::string Profiler::summary() const {
+  struct Row {
+    const ProfileEvent* first;
+    std::size_t calls = 0;
+    double ns = 0;
+    double flops = 0;
+    double bytes = 0;
+  };
+
+  // One row per layer and phase, in order of first appearance.
+  const auto events = this->events();
+  std::vector<Row> rows;
+  double total = 0;
+  for (const auto& event : events) {
+    auto row = std::find_if(rows.begin(), rows.end(), [&](const Row& r) {
+      return r.first->layer == event.layer && std::string_view{r.first->phase} == event.phase;
+    });
+    if (row == rows.end()) {
+      row = rows.insert(rows.end(), Row{&event});
+    }
+    ++row->calls;
+    row->ns += static_cast<double>(event.duration);
+    row->flops += event.flops;
+    row->bytes += event.bytes;
+    total += static_cast<double>(event.duration);
+  }
+
+  std::string table;
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-28s %12s %8s %12s %8s %12s %10s %10s\n",
+                "name", "shape", "calls", "total ms", "share", "mean us", "GFLOP/s", "GB/s");
+  table += line;
+  for (const auto& row : rows) {
+    const std::string shape = row.first->layer < 0 ? "-"
+                              : std::to_string(row.first->inputSize) + "->" + std::to_string(row.first->outputSize);
+    const double ns = std::max(1.0, row.ns);
+    std::snprintf(line, sizeof(line), "%-28s %12s %8zu %12.3f %7.1f%% %12.2f %10.2f %10.2f\n",
+                  eventName(*row.first).c_str(), shape.c_str(), row.calls, row.ns / 1e6,
+                  total > 0 ? 100 * row.ns / total : 0.0, row.ns / 1e3 / static_cast<double>(row.calls),
+                  row.flops / ns, row.bytes / ns);
+    table += line;
+  }
+  return table;
+}
+
+}  // namespace dmlfs
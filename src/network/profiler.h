@@ -0,0 +1,259 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "layer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Whether the profiling hooks are compiled into the library
+ *
+ * The hooks in `Network` and the optimizers only exist when `DMLFS_PROFILING`
+ * is defined, e.g. by configuring with `-DDMLFS_PROFILING=ON`. Otherwise they
+ * expand to nothing and cost nothing.
+ */
+#ifdef DMLFS_PROFILING
+inline constexpr bool kProfilingCompiledIn = true;
+#else
+inline constexpr bool kProfilingCompiledIn = false;
+#endif
+
+/**
+ * @brief A timed piece of work, e.g. the forward pass of one layer on one batch
+ */
+struct ProfileEvent {
+  const char* phase = "";       ///< "forward", "backward", or the optimizer's name, e.g. "SGD::update"
+  int layer = -1;               ///< Index of the layer in the network, -1 for whole-network work
+  Eigen::Index inputSize = 0;   ///< Inputs per sample of the layer
+  Eigen::Index outputSize = 0;  ///< Outputs per sample of the layer
+  Eigen::Index batchSize = 0;   ///< Number of samples
+  std::int64_t start = 0;       ///< Start, in nanoseconds since the profiler was created
+  std::int64_t duration = 0;    ///< Wall time, in nanoseconds
+  double flops = 0;             ///< Floating point operations, estimated from the shapes
+  double bytes = 0;             ///< Bytes read and written, estimated from the shapes
+  int thread = 0;               ///< Small integer identifying the recording thread
+};
+
+/**
+ * @brief Process-wide collector of `ProfileEvent`s
+ *
+ * Recording is off until `enable` is called. While off, each hook costs a
+ * relaxed atomic load. While on, each costs two clock reads and an append
+ * to a buffer owned by the calling thread, so training threads never
+ * contend with each other.
+ *
+ * The events can be exported as a Chrome trace, to open in Perfetto or
+ * `chrome://tracing`, or aggregated per layer and phase into a table.
+ */
+class Profiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief The process-wide profiler
+   */
+  static Profiler& instance();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  /**
+   * @brief Start or stop recording
+   */
+  void enable(bool enabled = true) {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Whether events are being recorded
+   */
+  bool enabled() const {
+    return m_enabled.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Nanoseconds elapsed since the profiler was created
+   */
+  std::int64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_origin).count();
+  }
+
+  /**
+   * @brief Append an event to the calling thread's buffer
+   * @param event Event to record, whose `thread` is overwritten
+   */
+  void record(ProfileEvent event);
+
+  /**
+   * @brief Copy of the events recorded by every thread, by start time
+   */
+  std::vector<ProfileEvent> events() const;
+
+  /**
+   * @brief Discard the events recorded so far
+   */
+  void clear();
+
+  /**
+   * @brief Write the events in the Chrome trace event format
+   * @param path Path of the JSON file
+   *
+   * Throws `std::runtime_error` if the file cannot be written.
+   */
+  void writeChromeTrace(const std::string& path) const;
+
+  /**
+   * @brief Table of the time, share, GFLOP/s and GB/s of each layer and phase
+   */
+  std::string summary() const;
+
+private:
+  /**
+   * @brief Events of a single thread
+   */
+  struct ThreadBuffer {
+    std::mutex mutex;                 ///< Only contended while exporting or clearing
+    std::vector<ProfileEvent> events; ///< Events recorded by the thread
+    int thread = 0;                   ///< Identifier of the thread
+  };
+
+  Profiler();
+
+  /**
+   * @brief Buffer of the calling thread, registered on first use
+   */
+  ThreadBuffer& buffer();
+
+  /**
+   * @brief Time origin of the events
+   */
+  const Clock::time_point m_origin;
+
+  /**
+   * @brief Whether events are being recorded
+   */
+  std::atomic<bool> m_enabled{false};
+
+  /**
+   * @brief Guards `m_buffers`
+   */
+  mutable std::mutex m_mutex;
+
+  /**
+   * @brief Buffers of every thread that recorded an event, shared with the threads
+   */
+  std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+};
+
+/**
+ * @brief Records the wall time of its own lifetime as a `ProfileEvent`
+ *
+ * Does nothing beyond checking `Profiler::enabled` if recording is off when
+ * the scope starts. Normally used through `DMLFS_PROFILE_SCOPE`.
+ */
+class ProfileScope {
+public:
+  /**
+   * @brief Time a pass through a layer
+   * @param backward Whether this is the backward pass
+   * @param index Index of the layer in its network
+   * @param layer The layer
+   * @param batchSize Number of samples
+   *
+   * Each weight is applied once per output position of a sample: once for a
+   * dense layer, at every location for a convolution. Parameter-free layers
+   * count one operation per input. The traffic counts the parameters (and
+   * their gradients) and each activation read or written once.
+   */
+  template <typename Scalar>
+  ProfileScope(bool backward, int index, const Layer<Scalar>& layer, Eigen::Index batchSize) {
+    Profiler& profiler = Profiler::instance();
+    if (!profiler.enabled()) {
+      return;
+    }
+
+    const double batch = static_cast<double>(batchSize);
+    const double parameters = static_cast<double>(layer.parameterCount());
+    const double inputs = static_cast<double>(layer.inputSize()) * batch;
+    const double outputs = static_cast<double>(layer.outputSize()) * batch;
+    const auto& weights = layer.weights();
+    const double macs = weights.size() > 0
+                        ? static_cast<double>(weights.size()) * static_cast<double>(layer.outputSize() / weights.rows()) * batch
+                        : 0;
+    const double elementwise = macs > 0 ? 2 * outputs : inputs;
+
+    m_event.phase = backward ? "backward" : "forward";
+    m_event.layer = index;
+    m_event.inputSize = layer.inputSize();
+    m_event.outputSize = layer.outputSize();
+    m_event.batchSize = batchSize;
+    m_event.flops = (backward ? 4 : 2) * macs + elementwise;
+    m_event.bytes = sizeof(Scalar) * ((backward ? 2 : 1) * parameters + (backward ? 2 : 1) * (inputs + outputs));
+    m_profiler = &profiler;
+    m_event.start = profiler.now();
+  }
+
+  /**
+   * @brief Time any other piece of work
+   * @param phase Name of the work, a string literal
+   * @param flops Floating point operations it performs
+   * @param bytes Bytes it reads and writes
+   */
+  ProfileScope(const char* phase, double flops, double bytes) {
+    Profiler& profiler = Profiler::instance();
+    if (!profiler.enabled()) {
+      return;
+    }
+    m_event.phase = phase;
+    m_event.flops = flops;
+    m_event.bytes = bytes;
+    m_profiler = &profiler;
+    m_event.start = profiler.now();
+  }
+
+  ~ProfileScope() {
+    if (m_profiler != nullptr) {
+      m_event.duration = m_profiler->now() - m_event.start;
+      m_profiler->record(m_event);
+    }
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  /**
+   * @brief Event being timed
+   */
+  ProfileEvent m_event;
+
+  /**
+   * @brief Profiler receiving the event, null if recording was off
+   */
+  Profiler* m_profiler = nullptr;
+};
+
+}  // namespace dmlfs
+
+/**
+ * @brief Time the rest of the enclosing block with a `ProfileScope` built from the arguments
+ *
+ * Expands to nothing unless `DMLFS_PROFILING` is defined.
+ */
+#ifdef DMLFS_PROFILING
+#define DMLFS_PROFILE_CONCAT_(a, b) a##b
+#define DMLFS_PROFILE_CONCAT(a, b) DMLFS_PROFILE_CONCAT_(a, b)
+#define DMLFS_PROFILE_SCOPE(...) const ::dmlfs::ProfileScope DMLFS_PROFILE_CONCAT(dmlfsProfileScope, __LINE__){__VA_ARGS__}
+#else
+#define DMLFS_PROFILE_SCOPE(...) static_cast<void>(0)
+#endif
+
+#endif /* PROFILER_H */
@@ -0,0 +1,522 @@
+#include "quantized_network.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+#include <omp.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DMLFS_QUANTIZED_X86
+#endif
+
+namespace dmlfs {
+
+namespace {
+
+/**
+ * @brief Number of samples sharing each pass over a weight row
+ */
+constexpr Eigen::Index kSampleBlock = 4;
+
+/**
+ * @brief Largest number of weight rows sharing each pass over a block of samples
+ */
+constexpr Eigen::Index kMaxRowBlock = 4;
+
+/**
+ * @brief Multiply-accumulate count from which a layer is spread over threads
+ */
+constexpr Eigen::Index kParallelGemmThreshold = 1 << 18;
+
+/**
+ * @brief Largest magnitude representable by an 8-bit activation of the given signedness
+ */
+template <typename Scalar>
+Scalar levels(bool isUnsigned) {
+  return isUnsigned ? Scalar(255) : Scalar(127);
+}
+
+/**
+ * @brief Scale mapping `maxAbs` to the largest 8-bit level
+ */
+template <typename Scalar>
+Scalar scaleFor(Scalar maxAbs, bool isUnsigned) {
+  return maxAbs > 0 ? maxAbs / levels<Scalar>(isUnsigned) : Scalar(1);
+}
+
+/**
+ * @brief Round and saturate a value to an 8-bit activation
+ *
+ * Rounds halfway cases away from zero with a truncating conversion, which
+ * compiles inline, where `std::lrint` is a libm call on baseline x86-64 and
+ * this runs once per activation.
+ */
+template <typename Out, typename Scalar>
+Out quantize(Scalar value) {
+  constexpr Scalar lo = std::is_signed_v<Out> ? -127 : 0;
+  constexpr Scalar hi = std::is_signed_v<Out> ? 127 : 255;
+  const Scalar clamped = std::clamp(value, lo, hi);
+  return static_cast<Out>(static_cast<int>(clamped + std::copysign(Scalar(0.5), clamped)));
+}
+
+/**
+ * @brief Apply an activation function to a single value
+ */
+template <typename Scalar>
+Scalar activate(ActivationBase::Type type, Scalar value) {
+  switch (type) {
+    case ActivationBase::Type::RELU:
+      return std::max(value, Scalar(0));
+    case ActivationBase::Type::SIGMOID:
+      return Scalar(1) / (Scalar(1) + std::exp(-value));
+    case ActivationBase::Type::TANH:
+      return std::tanh(value);
+    case ActivationBase::Type::NONE:
+    default:
+      return value;
+  }
+}
+
+/**
+ * @brief Dot product of an 8-bit weight row with an activation widened to 16 bits
+ *
+ * Written as a plain widening multiply-accumulate, which compilers map to
+ * `pmaddwd` (or `vpdpwssd` with AVX-512 VNNI) when vectorizing at -O3. An
+ * `omp simd` reduction would hide that pattern.
+ */
+inline std::int32_t dot(const std::int8_t* w, const std::int16_t* x, Eigen::Index size) {
+  std::int32_t acc = 0;
+  for (Eigen::Index k = 0; k < size; ++k) {
+    acc += static_cast<std::int16_t>(w[k]) * x[k];
+  }
+  return acc;
+}
+
+/**
+ * @brief Four dot products sharing each load of the weight row
+ */
+inline void dot4(const std::int8_t* w, const std::int16_t* x, Eigen::Index size, std::int32_t* acc) {
+  const std::int16_t* x0 = x;
+  const std::int16_t* x1 = x0 + size;
+  const std::int16_t* x2 = x1 + size;
+  const std::int16_t* x3 = x2 + size;
+  std::int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+  for (Eigen::Index k = 0; k < size; ++k) {
+    const std::int16_t wk = w[k];
+    acc0 += wk * x0[k];
+    acc1 += wk * x1[k];
+    acc2 += wk * x2[k];
+    acc3 += wk * x3[k];
+  }
+  acc[0] = acc0;
+  acc[1] = acc1;
+  acc[2] = acc2;
+  acc[3] = acc3;
+}
+
+#ifdef DMLFS_QUANTIZED_X86
+
+/**
+ * @brief Sum of the eight 32-bit lanes of a register
+ */
+__attribute__((target("avx2")))
+inline std::int32_t horizontalSum(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+  return _mm_cvtsi128_si32(sum);
+}
+
+/**
+ * @brief Dot products of `Rows` consecutive weight rows with `Samples` widened activations
+ * @param w First weight row, rows being `size` apart
+ * @param x First sample, samples being `size` apart
+ * @param size Number of inputs
+ * @param acc Receives `Rows x Samples` dot products, `kSampleBlock` apart per row
+ *
+ * Each iteration widens 16 weights of every row and multiplies them with 16
+ * activations of every sample with `vpmaddwd`, so that every load is shared
+ * by `Samples` or `Rows` multiply-accumulates.
+ */
+template <int Rows, int Samples>
+__attribute__((target("avx2")))
+void dotBlockAvx2(const std::int8_t* w, const std::int16_t* x, Eigen::Index size, std::int32_t* acc) {
+  __m256i sums[Rows][Samples];
+  for (int r = 0; r < Rows; ++r) {
+    for (int s = 0; s < Samples; ++s) {
+      sums[r][s] = _mm256_setzero_si256();
+    }
+  }
+
+  Eigen::Index k = 0;
+  for (; k + 16 <= size; k += 16) {
+    __m256i xs[Samples];
+    for (int s = 0; s < Samples; ++s) {
+      xs[s] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + s * size + k));
+    }
+    for (int r = 0; r < Rows; ++r) {
+      const __m256i wr = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + r * size + k)));
+      for (int s = 0; s < Samples; ++s) {
+        sums[r][s] = _mm256_add_epi32(sums[r][s], _mm256_madd_epi16(wr, xs[s]));
+      }
+    }
+  }
+
+  for (int r = 0; r < Rows; ++r) {
+    for (int s = 0; s < Samples; ++s) {
+      std::int32_t total = horizontalSum(sums[r][s]);
+      for (Eigen::Index t = k; t < size; ++t) {
+        total += static_cast<std::int16_t>(w[r * size + t]) * x[s * size + t];
+      }
+      acc[r * kSampleBlock + s] = total;
+    }
+  }
+}
+
+/**
+ * @brief Dot products of `Rows` consecutive weight rows with `Samples` unsigned activations
+ *
+ * Same contract as `dotBlockAvx2`, but each `vpdpbusd` multiplies 64
+ * unsigned activations with 64 signed weights and adds them to 16
+ * accumulators, without widening either. The tail of the rows is read with
+ * masked loads.
+ */
+template <int Rows, int Samples>
+__attribute__((target("avx512f,avx512bw,avx512vnni")))
+void dotBlockVnni(const std::int8_t* w, const std::uint8_t* x, Eigen::Index size, std::int32_t* acc) {
+  __m512i sums[Rows][Samples];
+  for (int r = 0; r < Rows; ++r) {
+    for (int s = 0; s < Samples; ++s) {
+      sums[r][s] = _mm512_setzero_si512();
+    }
+  }
+
+  Eigen::Index k = 0;
+  for (; k + 64 <= size; k += 64) {
+    __m512i xs[Samples];
+    for (int s = 0; s < Samples; ++s) {
+      xs[s] = _mm512_loadu_si512(x + s * size + k);
+    }
+    for (int r = 0; r < Rows; ++r) {
+      const __m512i wr = _mm512_loadu_si512(w + r * size + k);
+      for (int s = 0; s < Samples; ++s) {
+        sums[r][s] = _mm512_dpbusd_epi32(sums[r][s], xs[s], wr);
+      }
+    }
+  }
+
+  // Masking every step of the loop instead keeps GCC from holding the
+  // accumulators in registers.
+  if (k < size) {
+    const __mmask64 mask = (__mmask64{1} << (size - k)) - 1;
+    __m512i xs[Samples];
+    for (int s = 0; s < Samples; ++s) {
+      xs[s] = _mm512_maskz_loadu_epi8(mask, x + s * size + k);
+    }
+    for (int r = 0; r < Rows; ++r) {
+      const __m512i wr = _mm512_maskz_loadu_epi8(mask, w + r * size + k);
+      for (int s = 0; s < Samples; ++s) {
+        sums[r][s] = _mm512_dpbusd_epi32(sums[r][s], xs[s], wr);
+      }
+    }
+  }
+
+  for (int r = 0; r < Rows; ++r) {
+    for (int s = 0; s < Samples; ++s) {
+      acc[r * kSampleBlock + s] = _mm512_reduce_add_epi32(sums[r][s]);
+    }
+  }
+}
+
+/**
+ * @brief `dotBlockVnni` or `dotBlockAvx2` for a block of `Rows` rows and `Samples` samples
+ */
+template <bool Vnni, int Rows, int Samples, typename X>
+void dotBlockX86(const std::int8_t* w, const X* x, Eigen::Index size, std::int32_t* acc) {
+  if constexpr (Vnni) {
+    dotBlockVnni<Rows, Samples>(w, x, size, acc);
+  } else {
+    dotBlockAvx2<Rows, Samples>(w, x, size, acc);
+  }
+}
+
+/**
+ * @brief `dotBlockX86` instantiated for a block of `rows` rows and `samples` samples
+ */
+template <bool Vnni, int Rows, typename X>
+void dotBlockX86(const std::int8_t* w, const X* x, Eigen::Index size, Eigen::Index rows, Eigen::Index samples,
+                 std::int32_t* acc) {
+  if constexpr (Rows > 1) {
+    if (rows < Rows) {
+      dotBlockX86<Vnni, Rows - 1>(w, x, size, rows, samples, acc);
+      return;
+    }
+  }
+  switch (samples) {
+    case 1: dotBlockX86<Vnni, Rows, 1>(w, x, size, acc); break;
+    case 2: dotBlockX86<Vnni, Rows, 2>(w, x, size, acc); break;
+    case 3: dotBlockX86<Vnni, Rows, 3>(w, x, size, acc); break;
+    default: dotBlockX86<Vnni, Rows, 4>(w, x, size, acc); break;
+  }
+}
+
+#endif
+
+/**
+ * @brief Integer GEMM kernel used on the CPU running the process
+ */
+enum class Kernel {
+  PORTABLE,     ///< Auto-vectorized loops over activations widened to 16 bits
+  AVX2,         ///< `vpmaddwd` over activations widened to 16 bits
+  AVX512_VNNI,  ///< `vpdpbusd` over activations offset to unsigned bytes
+};
+
+/**
+ * @brief Best kernel the CPU supports, whatever the flags the library was compiled with
+ */
+Kernel selectKernel() {
+#ifdef DMLFS_QUANTIZED_X86
+  static const Kernel kernel = __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw")
+                               ? Kernel::AVX512_VNNI
+                               : __builtin_cpu_supports("avx2") ? Kernel::AVX2 : Kernel::PORTABLE;
+  return kernel;
+#else
+  return Kernel::PORTABLE;
+#endif
+}
+
+/**
+ * @brief Number of weight rows sharing each load of the samples
+ *
+ * The AVX2 kernel keeps two rows of four samples in 8 of its 16 `ymm`
+ * registers, next to the activations and weights. AVX-512 has 32 `zmm`
+ * registers, enough for four rows.
+ */
+Eigen::Index rowBlock(Kernel kernel) {
+  return kernel == Kernel::AVX512_VNNI ? kMaxRowBlock : kernel == Kernel::AVX2 ? 2 : 1;
+}
+
+/**
+ * @brief Dot products of up to `rowBlock(kernel)` weight rows with a block of samples
+ * @param x Widened activations, or unsigned bytes for `Kernel::AVX512_VNNI`
+ * @param acc Receives `rows x samples` dot products, `kSampleBlock` apart per row
+ */
+inline void dotBlock(Kernel kernel, const std::int8_t* w, const void* x, Eigen::Index size, Eigen::Index rows,
+                     Eigen::Index samples, std::int32_t* acc) {
+#ifdef DMLFS_QUANTIZED_X86
+  if (kernel == Kernel::AVX512_VNNI) {
+    dotBlockX86<true, kMaxRowBlock>(w, static_cast<const std::uint8_t*>(x), size, rows, samples, acc);
+    return;
+  }
+  if (kernel == Kernel::AVX2) {
+    dotBlockX86<false, 2>(w, static_cast<const std::int16_t*>(x), size, rows, samples, acc);
+    return;
+  }
+#endif
+  const auto* x16 = static_cast<const std::int16_t*>(x);
+  for (Eigen::Index r = 0; r < rows; ++r) {
+    if (samples == kSampleBlock) {
+      dot4(w + r * size, x16, size, acc + r * kSampleBlock);
+    } else {
+      for (Eigen::Index c = 0; c < samples; ++c) {
+        acc[r * kSampleBlock + c] = dot(w + r * size, x16 + c * size, size);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Run one layer: integer GEMM, then fused rescale, bias, activation and requantization
+ * @tparam In `int8_t` or `uint8_t` inputs
+ * @tparam Out `int8_t` or `uint8_t` for a hidden layer, `Scalar` for the last one
+ * @param x Inputs, `layer.inputSize` per sample
+ * @param batchSize Number of samples
+ * @param y Outputs, `layer.outputSize` per sample
+ * @param widened Room for `kSampleBlock * layer.inputSize` values per OpenMP thread, widened or offset to bytes
+ */
+template <typename Scalar, typename In, typename Out>
+void runLayer(const QuantizedLayer<Scalar>& layer, const In* x, Eigen::Index batchSize, Out* y, std::int16_t* widened) {
+  const Eigen::Index inputs = layer.inputSize;
+  const Eigen::Index outputs = layer.outputSize;
+  const Eigen::Index blocks = (batchSize + kSampleBlock - 1) / kSampleBlock;
+  const Scalar inverseOutputScale = Scalar(1) / layer.outputScale;
+  const Kernel kernel = selectKernel();
+  const Eigen::Index rowsPerPass = rowBlock(kernel);
+
+  // `vpdpbusd` takes unsigned activations: signed ones are offset by 128,
+  // which adds 128 times the sum of each weight row to its dot products.
+  const bool offset = kernel == Kernel::AVX512_VNNI && std::is_signed_v<In>;
+
+  #pragma omp parallel for schedule(static) if(inputs * outputs * batchSize >= kParallelGemmThreshold)
+  for (Eigen::Index block = 0; block < blocks; ++block) {
+    const Eigen::Index first = block * kSampleBlock;
+    const Eigen::Index count = std::min(kSampleBlock, batchSize - first);
+
+    // Convert the block's activations once for all the weight rows: widened
+    // to 16 bits for `vpmaddwd`, so that the inner products only widen the
+    // weights, or to unsigned bytes for `vpdpbusd`.
+    std::int16_t* scratch = widened + omp_get_thread_num() * kSampleBlock * inputs;
+    const void* operand = scratch;
+    if (kernel != Kernel::AVX512_VNNI) {
+      std::copy_n(x + first * inputs, count * inputs, scratch);
+    } else if (offset) {
+      auto* bytes = reinterpret_cast<std::uint8_t*>(scratch);
+      for (Eigen::Index k = 0; k < count * inputs; ++k) {
+        bytes[k] = static_cast<std::uint8_t>(x[first * inputs + k] + 128);
+      }
+    } else {
+      operand = x + first * inputs;
+    }
+
+    std::int32_t acc[kMaxRowBlock * kSampleBlock];
+    for (Eigen::Index row = 0; row < outputs; row += rowsPerPass) {
+      const Eigen::Index rows = std::min(rowsPerPass, outputs - row);
+      dotBlock(kernel, layer.weights.data() + row * inputs, operand, inputs, rows, count, acc);
+
+      for (Eigen::Index r = 0; r < rows; ++r) {
+        const Eigen::Index o = row + r;
+        const Scalar scale = layer.inputScale * layer.weightScales[o];
+        const std::int32_t correction = offset ? 128 * layer.weightSums[o] : 0;
+        for (Eigen::Index c = 0; c < count; ++c) {
+          const Scalar value = activate(layer.activationType, static_cast<Scalar>(acc[r * kSampleBlock + c] - correction) * scale + layer.biases[o]);
+          if constexpr (std::is_floating_point_v<Out>) {
+            y[(first + c) * outputs + o] = value;
+          } else {
+            y[(first + c) * outputs + o] = quantize<Out>(value * inverseOutputScale);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Dispatch `runLayer` on the signedness of the layer's input and output
+ */
+template <typename Scalar>
+void runLayer(const QuantizedLayer<Scalar>& layer, const std::uint8_t* x, Eigen::Index batchSize, void* y, bool last,
+              std::int16_t* widened) {
+  const auto* xs = reinterpret_cast<const std::int8_t*>(x);
+  if (last) {
+    auto* out = static_cast<Scalar*>(y);
+    layer.unsignedInput ? runLayer(layer, x, batchSize, out, widened) : runLayer(layer, xs, batchSize, out, widened);
+  } else if (layer.unsignedOutput) {
+    auto* out = static_cast<std::uint8_t*>(y);
+    layer.unsignedInput ? runLayer(layer, x, batchSize, out, widened) : runLayer(layer, xs, batchSize, out, widened);
+  } else {
+    auto* out = static_cast<std::int8_t*>(y);
+    layer.unsignedInput ? runLayer(layer, x, batchSize, out, widened) : runLayer(layer, xs, batchSize, out, widened);
+  }
+}
+
+}  // namespace
+
+template <typename Scalar>
+QuantizedNetwork<Scalar>::QuantizedNetwork(const Network<Scalar>& network, const Eigen::Ref<const Matrix>& calibration) {
+  const auto& layers = network.layers();
+  if (layers.empty()) {
+    throw std::invalid_argument("QuantizedNetwork: the network has no layers");
+  }
+
+  Matrix input = calibration;
+  bool unsignedInput = false;
+  for (const auto& layer : layers) {
+    const auto& weights = layer->weights();
+    if (layer->inputSize() != weights.cols() || layer->outputSize() != weights.rows()) {
+      throw std::invalid_argument("QuantizedNetwork: only dense layers can be quantized");
+    }
+
+    QuantizedLayer<Scalar> q;
+    q.inputSize = weights.cols();
+    q.outputSize = weights.rows();
+    q.activationType = layer->activationType();
+    q.unsignedInput = unsignedInput;
+    q.unsignedOutput = q.activationType == ActivationBase::Type::RELU;
+    q.inputScale = scaleFor(input.size() > 0 ? input.cwiseAbs().maxCoeff() : Scalar(0), unsignedInput);
+
+    q.weights.resize(static_cast<std::size_t>(weights.size()));
+    q.weightScales.resize(static_cast<std::size_t>(q.outputSize));
+    q.weightSums.resize(static_cast<std::size_t>(q.outputSize));
+    q.biases.assign(layer->biases().data(), layer->biases().data() + q.outputSize);
+    for (Eigen::Index o = 0; o < q.outputSize; ++o) {
+      const Scalar scale = scaleFor(weights.row(o).cwiseAbs().maxCoeff(), false);
+      q.weightScales[o] = scale;
+      std::int32_t sum = 0;
+      for (Eigen::Index k = 0; k < q.inputSize; ++k) {
+        q.weights[o * q.inputSize + k] = quantize<std::int8_t>(weights(o, k) / scale);
+        sum += q.weights[o * q.inputSize + k];
+      }
+      q.weightSums[o] = sum;
+    }
+
+    // Propagate the calibration batch through the floating point layer.
+    Matrix output(q.outputSize, input.cols());
+    layer->predict(input, output);
+    q.outputScale = scaleFor(output.size() > 0 ? output.cwiseAbs().maxCoeff() : Scalar(0), q.unsignedOutput);
+
+    m_layers.push_back(std::move(q));
+    input = std::move(output);
+    unsignedInput = m_layers.back().unsignedOutput;
+  }
+}
+
+template <typename Scalar>
+const typename QuantizedNetwork<Scalar>::Matrix& QuantizedNetwork<Scalar>::predict(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const {
+  assert(input.rows() == m_layers.front().inputSize);
+
+  const Eigen::Index batchSize = input.cols();
+  Eigen::Index widest = input.rows();
+  for (const auto& layer : m_layers) {
+    widest = std::max(widest, layer.outputSize);
+  }
+  for (auto& buffer : workspace.buffers) {
+    if (static_cast<Eigen::Index>(buffer.size()) < widest * batchSize) {
+      buffer.resize(static_cast<std::size_t>(widest * batchSize));
+    }
+  }
+  workspace.output.resize(m_layers.back().outputSize, batchSize);
+  const auto widenedSize = static_cast<std::size_t>(omp_get_max_threads() * kSampleBlock * widest);
+  if (workspace.widened.size() < widenedSize) {
+    workspace.widened.resize(widenedSize);
+  }
+
+  // The network's input is the only floating point activation to quantize.
+  const Scalar inverseScale = Scalar(1) / m_layers.front().inputScale;
+  auto* quantized = reinterpret_cast<std::int8_t*>(workspace.buffers[0].data());
+  for (Eigen::Index j = 0; j < batchSize; ++j) {
+    const Scalar* x = input.col(j).data();
+    std::int8_t* q = quantized + j * input.rows();
+    for (Eigen::Index i = 0; i < input.rows(); ++i) {
+      q[i] = quantize<std::int8_t>(x[i] * inverseScale);
+    }
+  }
+
+  for (std::size_t l = 0; l < m_layers.size(); ++l) {
+    const bool last = l + 1 == m_layers.size();
+    void* output = last ? static_cast<void*>(workspace.output.data()) : workspace.buffers[(l + 1) % 2].data();
+    runLayer(m_layers[l], workspace.buffers[l % 2].data(), batchSize, output, last, workspace.widened.data());
+  }
+
+  return workspace.output;
+}
+
+template <typename Scalar>
+std::size_t QuantizedNetwork<Scalar>::parameterBytes() const {
+  std::size_t bytes = 0;
+  for (const auto& layer : m_layers) {
+    bytes += layer.weights.size() * sizeof(std::int8_t)
+             + (layer.weightScales.size() + layer.biases.size()) * sizeof(Scalar);
+  }
+  return bytes;
+}
+
+template struct QuantizedLayer<float>;
+template struct QuantizedLayer<double>;
+template class QuantizedNetwork<float>;
+template class QuantizedNetwork<double>;
+
+}  // namespace dmlfs
@@ -0,0 +1,129 @@
+#ifndef QUANTIZED_NETWORK_H
+#define QUANTIZED_NETWORK_H
+
+#include "CommonMacros.h"
+#include "network.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Dense layer converted to 8-bit integers
+ * @tparam Scalar Floating point type of the original layer
+ *
+ * The weights are quantized symmetrically per output neuron, so a row with
+ * small weights keeps its precision next to rows with large ones. The
+ * activations flowing in and out use a single scale each, calibrated on
+ * sample data. Activations known to be non-negative, i.e. after a ReLU, are
+ * stored as `uint8_t` to use the full 8 bits, the others as `int8_t`.
+ */
+template <typename Scalar = double>
+struct QuantizedLayer {
+  Eigen::Index inputSize = 0;             ///< Number of inputs
+  Eigen::Index outputSize = 0;            ///< Number of outputs
+  std::vector<std::int8_t> weights;       ///< Quantized weights, row-major, one row per output
+  std::vector<Scalar> weightScales;       ///< Scale of each row of `weights`
+  std::vector<std::int32_t> weightSums;   ///< Sum of each row of `weights`, to undo the offset of signed inputs
+  std::vector<Scalar> biases;             ///< Biases, kept in floating point
+  Scalar inputScale = 1;                  ///< Scale of the quantized inputs
+  Scalar outputScale = 1;                 ///< Scale of the quantized outputs, unused by the last layer
+  bool unsignedInput = false;             ///< Whether the inputs are stored as `uint8_t`
+  bool unsignedOutput = false;            ///< Whether the outputs are stored as `uint8_t`
+  ActivationBase::Type activationType = ActivationBase::Type::NONE;  ///< Activation applied before requantizing
+};
+
+/**
+ * @brief Inference-only 8-bit copy of a trained `Network` of dense layers
+ * @tparam Scalar Floating point type of the network's inputs and outputs
+ *
+ * Each layer multiplies 8-bit activations by 8-bit weights with 32-bit
+ * accumulation, then a single fused pass over the accumulators rescales them,
+ * adds the bias, applies the activation and requantizes to 8 bits for the
+ * next layer. Only the input is quantized from and the output dequantized to
+ * floating point. The weights take one byte each, a quarter of `float` and
+ * an eighth of `double`, which is what matters for memory-bound inference.
+ *
+ * The integer GEMM uses `vpdpbusd` on CPUs with AVX-512 VNNI and `vpmaddwd`
+ * on CPUs with AVX2, whatever the flags the library was compiled with, and
+ * portable loops otherwise. All of them compute the same exact dot products.
+ *
+ * The scales of the activations are calibrated at conversion time, by
+ * running the floating point network on a representative batch and taking
+ * the largest magnitude seen at the input of each layer.
+ *
+ * Like `Network::predict`, concurrent calls are safe as long as each thread
+ * passes its own `Workspace`.
+ */
+template <typename Scalar = double>
+class QuantizedNetwork {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using ConstMap = Eigen::Map<const Matrix>;
+
+  /**
+   * @brief Per-thread activation storage
+   */
+  struct Workspace {
+    std::vector<std::uint8_t> buffers[2];  ///< Ping-pong quantized activations, reinterpreted as `int8_t` when signed
+    Matrix output;                         ///< Dequantized output of the last layer
+    std::vector<std::int16_t> widened;     ///< Blocks of inputs widened to 16 bits or offset to unsigned bytes, one slice per OpenMP thread
+  };
+
+  /**
+   * @brief Quantize a trained network
+   * @param network Network made of dense `Layer`s only
+   * @param calibration Representative inputs, one sample per column
+   *
+   * Throws `std::invalid_argument` if the network is empty or contains a
+   * layer other than a dense `Layer`, e.g. a `Conv2D`.
+   */
+  QuantizedNetwork(const Network<Scalar>& network, const Eigen::Ref<const Matrix>& calibration);
+
+  /**
+   * @brief Inference on a batch
+   * @param input Inputs, one sample per column
+   * @param workspace Activation storage owned by the calling thread
+   * @return Outputs, stored in `workspace`
+   */
+  const Matrix& predict(const Eigen::Ref<const Matrix>& input, Workspace& workspace) const;
+
+  /**
+   * @brief Inference on a batch using the network's own workspace
+   * @param input Inputs, one sample per column
+   * @return Outputs, valid until the next call
+   *
+   * Convenience overload for single-threaded use.
+   */
+  const Matrix& predict(const Eigen::Ref<const Matrix>& input) {
+    return predict(input, m_workspace);
+  }
+
+  /**
+   * @brief Getter for the quantized layers
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(std::vector<QuantizedLayer<Scalar>>, layers);
+
+  /**
+   * @brief Number of bytes taken by the weights and biases
+   */
+  std::size_t parameterBytes() const;
+
+private:
+  /**
+   * @brief Quantized layers, in order
+   */
+  std::vector<QuantizedLayer<Scalar>> m_layers;
+
+  /**
+   * @brief Activation storage used by the single-threaded `predict` overload
+   */
+  Workspace m_workspace;
+};
+
+}  // namespace dmlfs
+
+#endif /* QUANTIZED_NETWORK_H */
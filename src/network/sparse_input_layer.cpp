@@ -0,0 +1,107 @@
+#include "sparse_input_layer.h"
+#include "optimizer.h"
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace dmlfs {
+
+template <typename Scalar>
+SparseInputLayer<Scalar>::SparseInputLayer(int continuousSize,
+                                           int categoryCount,
+                                           int outputSize,
+                                           InitializerBase::Type initializerType,
+                                           ActivationBase::Type activationType):
+    m_activationType{activationType}
+{
+  // Initialize as the equivalent dense layer, then split its weights.
+  Matrix weights = Matrix::Zero(outputSize, continuousSize + categoryCount);
+  m_biases = Matrix::Zero(outputSize, 1);
+  Initializer<Scalar>::apply(initializerType, weights, m_biases);
+
+  m_weights = weights.leftCols(continuousSize);
+  m_embeddings = weights.rightCols(categoryCount);
+}
+
+template <typename Scalar>
+const typename SparseInputLayer<Scalar>::Matrix& SparseInputLayer<Scalar>::forward(const Eigen::Ref<const Matrix>& continuous,
+                                                                                   const Eigen::Ref<const IndexMatrix>& categories,
+                                                                                   Workspace& workspace) const {
+  assert(continuous.rows() == m_weights.cols());
+  assert(continuous.cols() == categories.cols());
+  if (categories.size() > 0 && (categories.minCoeff() < 0 || categories.maxCoeff() >= m_embeddings.cols())) {
+    throw std::invalid_argument("Category indices must be in [0, " + std::to_string(m_embeddings.cols()) + ")");
+  }
+
+  workspace.continuous = continuous;
+  workspace.categories = categories;
+
+  Matrix& output = workspace.output;
+  output.resize(m_weights.rows(), categories.cols());
+  if (m_weights.cols() > 0) {
+    output.noalias() = m_weights * continuous;
+  } else {
+    output.setZero();
+  }
+
+  for (Eigen::Index j = 0; j < categories.cols(); ++j) {
+    for (Eigen::Index k = 0; k < categories.rows(); ++k) {
+      output.col(j) += m_embeddings.col(categories(k, j));
+    }
+  }
+
+  FusedActivation<Scalar>::forward(m_activationType, output, m_biases);
+  return output;
+}
+
+template <typename Scalar>
+void SparseInputLayer<Scalar>::backward(const Matrix& dOutput, Workspace& workspace) const {
+  assert(dOutput.rows() == workspace.output.rows() && dOutput.cols() == workspace.output.cols());
+
+  workspace.dZ.resize(workspace.output.rows(), workspace.output.cols());
+  FusedActivation<Scalar>::backward(m_activationType, workspace.output, dOutput, workspace.dZ);
+  const Matrix& dZ = workspace.dZ;
+
+  workspace.weights_grad.resize(m_weights.rows(), m_weights.cols());
+  if (m_weights.cols() > 0) {
+    workspace.weights_grad.noalias() = dZ * workspace.continuous.transpose();
+  }
+  workspace.biases_grad = dZ.rowwise().sum();
+
+  // Only the entries of the previous pass's touched categories were set.
+  std::vector<int>& slot = workspace.slot;
+  slot.resize(static_cast<std::size_t>(m_embeddings.cols()), -1);
+  for (int category : workspace.touched) {
+    slot[category] = -1;
+  }
+  workspace.touched.clear();
+
+  // Scatter-add each sample's gradient into the columns of its categories.
+  // The buffer is sized for the worst case, where all categories differ.
+  const IndexMatrix& categories = workspace.categories;
+  Matrix& embeddingsGrad = workspace.embeddings_grad;
+  embeddingsGrad.resize(dZ.rows(), categories.size());
+  for (Eigen::Index j = 0; j < categories.cols(); ++j) {
+    for (Eigen::Index k = 0; k < categories.rows(); ++k) {
+      const int category = categories(k, j);
+      if (slot[category] < 0) {
+        slot[category] = static_cast<int>(workspace.touched.size());
+        workspace.touched.push_back(category);
+        embeddingsGrad.col(slot[category]) = dZ.col(j);
+      } else {
+        embeddingsGrad.col(slot[category]) += dZ.col(j);
+      }
+    }
+  }
+}
+
+template <typename Scalar>
+void SparseInputLayer<Scalar>::update(Scalar learningRate) {
+  SGD<Scalar>(learningRate).update(*this, m_workspace);
+}
+
+template class SparseInputLayer<float>;
+template class SparseInputLayer<double>;
+
+}  // namespace dmlfs
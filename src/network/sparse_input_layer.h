@@ -0,0 +1,245 @@
+#ifndef SPARSE_INPUT_LAYER_H
+#define SPARSE_INPUT_LAYER_H
+
+#include "CommonMacros.h"
+#include "activation.h"
+#include "initializer.h"
+
+#include "Eigen/Dense"
+
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief First layer for inputs made of continuous features and one-hot encoded categories
+ * @tparam Scalar Floating point type of the parameters and activations
+ *
+ * Computes the same function as a dense `Layer` fed with the continuous
+ * features stacked over the one-hot encoding of the categorical ones, but
+ * without ever materializing the one-hot rows. Each category owns a column of
+ * an embedding table, and a sample's pre-activation is the dense product for
+ * its continuous features plus the sum of the columns of its categories.
+ *
+ * The backward pass only produces gradients for the categories seen in the
+ * mini-batch, and `Optimizer::update(SparseInputLayer&, const Workspace&)`
+ * only touches those columns of the table, so the cost of a step does not
+ * grow with the number of categories.
+ *
+ * Like `Layer`, the overloads taking a `Workspace` only read the parameters
+ * and may be called from any number of threads at once, each with its own
+ * workspace. The overloads without one use the layer's own workspace.
+ *
+ * The categories of a sample are given as global column indices of the
+ * table, i.e. the row its one-hot encoding would have set in the categorical
+ * part of the dense input.
+ *
+ * @see SparseInput
+ */
+template <typename Scalar = double>
+class SparseInputLayer {
+public:
+  using Matrix = Eigen::MatrixX<Scalar>;
+  using IndexMatrix = Eigen::MatrixXi;
+
+  /**
+   * @brief State recorded by a forward pass, and gradients produced by the backward pass
+   *
+   * The gradients of the embeddings are sparse, so they are kept here for
+   * the optimizer rather than written to a span laid out like the parameters.
+   */
+  struct Workspace {
+    Matrix continuous;       ///< Continuous input of the last forward pass
+    IndexMatrix categories;  ///< Category indices of the last forward pass
+    Matrix output;           ///< Activations of the last forward pass
+    Matrix dZ;               ///< Gradient with respect to the pre-activations
+    Matrix weights_grad;     ///< Gradients of the continuous weights
+    Matrix biases_grad;      ///< Gradients of the biases
+    Matrix embeddings_grad;  ///< Gradients of the touched embeddings, followed by unused capacity
+    std::vector<int> touched;  ///< Categories seen in the last backward pass
+    std::vector<int> slot;     ///< Column of `embeddings_grad` of each category, -1 if untouched
+
+    /**
+     * @brief Gradients of the touched embeddings, column `i` belonging to `touched[i]`
+     */
+    auto touchedGradients() const {
+      return embeddings_grad.leftCols(static_cast<Eigen::Index>(touched.size()));
+    }
+  };
+
+  /**
+   * @brief Constructor
+   * @param continuousSize Number of continuous features
+   * @param categoryCount Total number of categories over all categorical features
+   * @param outputSize Number of output neurons
+   * @param initializerType Type of initializer
+   * @param activationType Type of activation function
+   */
+  SparseInputLayer(int continuousSize,
+                   int categoryCount,
+                   int outputSize,
+                   InitializerBase::Type initializerType = InitializerBase::Type::ZERO,
+                   ActivationBase::Type activationType = ActivationBase::Type::NONE);
+
+  /**
+   * @brief Getter for the weights of the continuous features
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Matrix, weights);
+
+  /**
+   * @brief Read-write getter for the weights of the continuous features, used by the optimizers
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(Matrix, weights);
+
+  /**
+   * @brief Getter for the embedding table, one column per category
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Matrix, embeddings);
+
+  /**
+   * @brief Read-write getter for the embedding table, used by the optimizers
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(Matrix, embeddings);
+
+  /**
+   * @brief Getter for the biases
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Matrix, biases);
+
+  /**
+   * @brief Read-write getter for the biases, used by the optimizers
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_GETTER(Matrix, biases);
+
+  /**
+   * @brief Getter for the layer's own workspace, used by the overloads without one
+   *
+   * @see CommonMacros.h
+   */
+  DEFINE_CONST_GETTER(Workspace, workspace);
+
+  /**
+   * @brief Categories whose embedding received a gradient in the last backward pass
+   */
+  const std::vector<int>& touched() const {
+    return m_workspace.touched;
+  }
+
+  /**
+   * @brief Gradients of the touched embeddings, column `i` belonging to `touched()[i]`
+   */
+  auto embeddings_grad() const {
+    return m_workspace.touchedGradients();
+  }
+
+  /**
+   * @brief Gradients of the continuous weights from the last backward pass
+   */
+  const Matrix& weights_grad() const {
+    return m_workspace.weights_grad;
+  }
+
+  /**
+   * @brief Gradients of the biases from the last backward pass
+   */
+  const Matrix& biases_grad() const {
+    return m_workspace.biases_grad;
+  }
+
+  /**
+   * @brief Forward propagation recording its state in a given workspace
+   * @param continuous Continuous features, one column per sample
+   * @param categories Category indices, one column per sample and one row per categorical feature
+   * @param workspace Workspace receiving the state needed by `backward`
+   * @return Output of the layer, stored in `workspace`
+   *
+   * Throws `std::invalid_argument` if a category index is out of range.
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& continuous,
+                        const Eigen::Ref<const IndexMatrix>& categories,
+                        Workspace& workspace) const;
+
+  /**
+   * @brief Backward propagation from the state recorded in a given workspace
+   * @param dOutput Derivative of the output
+   * @param workspace Workspace filled by the matching `forward`, receiving the gradients
+   *
+   * There is no gradient with respect to the inputs, since this is the first
+   * layer. The embedding gradients are accumulated per touched category.
+   */
+  void backward(const Matrix& dOutput, Workspace& workspace) const;
+
+  /**
+   * @brief Forward propagation
+   * @param continuous Continuous features, one column per sample
+   * @param categories Category indices, one column per sample and one row per categorical feature
+   * @return Output of the layer, stored in the layer until the next call
+   *
+   * Throws `std::invalid_argument` if a category index is out of range.
+   */
+  const Matrix& forward(const Eigen::Ref<const Matrix>& continuous, const Eigen::Ref<const IndexMatrix>& categories) {
+    return forward(continuous, categories, m_workspace);
+  }
+
+  /**
+   * @brief Backward propagation for the inputs of the last `forward`
+   * @param dOutput Derivative of the output
+   */
+  void backward(const Matrix& dOutput) {
+    backward(dOutput, m_workspace);
+  }
+
+  /**
+   * @brief Apply a plain gradient descent step with the gradients of the last `backward`
+   * @param learningRate Learning rate
+   *
+   * Shorthand for `SGD(learningRate).update(*this, workspace())`. Other
+   * optimizers, e.g. `Adam`, are applied with their own `update` overload
+   * for sparse input layers.
+   */
+  void update(Scalar learningRate);
+
+private:
+  /**
+   * @brief Weights of the continuous features
+   */
+  Matrix m_weights;
+
+  /**
+   * @brief Embedding table, one column per category
+   */
+  Matrix m_embeddings;
+
+  /**
+   * @brief Biases
+   */
+  Matrix m_biases;
+
+  /**
+   * @brief Workspace used by the overloads without one
+   */
+  Workspace m_workspace;
+
+  /**
+   * @brief Type of activation function, dispatched to the fused kernels
+   *
+   * @see FusedActivation
+   */
+  ActivationBase::Type m_activationType;
+};
+
+}  // namespace dmlfs
+
+#endif // SPARSE_INPUT_LAYER_H
@@ -0,0 +1,180 @@
+#ifndef STATIC_NETWORK_H
+#define STATIC_NETWORK_H
+
+#include "activation.h"
+#include "network.h"
+
+#include "Eigen/Dense"
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace dmlfs {
+
+/**
+ * @brief Dense layer whose shape and activation are known at compile time
+ * @tparam InputSize Number of inputs
+ * @tparam OutputSize Number of outputs
+ * @tparam Type Activation function
+ * @tparam Scalar Floating point type of the parameters and activations
+ *
+ * The parameters are fixed-size Eigen matrices stored inline, so a whole
+ * `StaticNetwork` is a single flat object and evaluating a layer involves no
+ * allocation, no pointer chasing and no dispatch on the activation.
+ */
+template <int InputSize, int OutputSize, ActivationBase::Type Type = ActivationBase::Type::NONE, typename Scalar = double>
+struct StaticLayer {
+  using scalar_type = Scalar;
+  using Input = Eigen::Matrix<Scalar, InputSize, 1>;
+  using Output = Eigen::Matrix<Scalar, OutputSize, 1>;
+
+  static constexpr int inputSize = InputSize;
+  static constexpr int outputSize = OutputSize;
+  static constexpr ActivationBase::Type activationType = Type;
+
+  Eigen::Matrix<Scalar, OutputSize, InputSize> weights = Eigen::Matrix<Scalar, OutputSize, InputSize>::Zero();  ///< Weights
+  Output biases = Output::Zero();  ///< Biases
+
+  /**
+   * @brief Evaluate the layer on a single sample
+   */
+  Output operator()(const Input& input) const {
+    Output z = weights * input + biases;
+    if constexpr (Type == ActivationBase::Type::RELU) {
+      z = z.cwiseMax(Scalar(0));
+    } else if constexpr (Type == ActivationBase::Type::SIGMOID) {
+      z = (Scalar(1) + (-z.array()).exp()).inverse().matrix();
+    } else if constexpr (Type == ActivationBase::Type::TANH) {
+      z = z.array().tanh().matrix();
+    }
+    return z;
+  }
+};
+
+/**
+ * @brief Sequential stack of `StaticLayer`s, for tiny models where latency matters
+ * @tparam Layers Layer types, each taking as many inputs as the previous one has outputs
+ *
+ * For instance `StaticNetwork<StaticLayer<4, 16, ActivationBase::Type::RELU>,
+ * StaticLayer<16, 3>>` is an iris-sized classifier. Every intermediate
+ * activation is a fixed-size vector on the stack, so single-sample inference
+ * inlines into straight-line code with no allocation.
+ *
+ * The parameters can be copied from a trained `Network` with the same layer
+ * shapes and activations, which is how such a model is normally obtained.
+ */
+template <typename... Layers>
+class StaticNetwork {
+  static_assert(sizeof...(Layers) > 0, "A StaticNetwork needs at least one layer");
+
+  using First = std::tuple_element_t<0, std::tuple<Layers...>>;
+  using Last = std::tuple_element_t<sizeof...(Layers) - 1, std::tuple<Layers...>>;
+
+public:
+  using Scalar = typename First::scalar_type;
+  using Input = typename First::Input;
+  using Output = typename Last::Output;
+
+  /**
+   * @brief Default constructor, all parameters zero
+   */
+  StaticNetwork() = default;
+
+  /**
+   * @brief Copy the parameters of a trained network
+   * @param network Network whose layers match `Layers` in shape and activation
+   *
+   * Throws `std::invalid_argument` if the networks do not match.
+   */
+  explicit StaticNetwork(const Network<Scalar>& network) {
+    if (network.layers().size() != sizeof...(Layers)) {
+      throw std::invalid_argument("StaticNetwork: expected " + std::to_string(sizeof...(Layers)) + " layers, got "
+                                  + std::to_string(network.layers().size()));
+    }
+    copyFrom(network, std::index_sequence_for<Layers...>{});
+  }
+
+  /**
+   * @brief Load the parameters from a model file written by `Network::save`
+   * @param path Path of the model file
+   */
+  static StaticNetwork load(const std::string& path) {
+    return StaticNetwork{Network<Scalar>::load(path)};
+  }
+
+  /**
+   * @brief Inference on a single sample
+   */
+  Output predict(const Input& input) const {
+    return apply<0>(input);
+  }
+
+  /**
+   * @brief Inference on a batch
+   * @param input Inputs, one sample per column
+   * @param output Preallocated matrix receiving the outputs, one sample per column
+   */
+  void predict(const Eigen::Ref<const Eigen::MatrixX<Scalar>>& input, Eigen::Ref<Eigen::MatrixX<Scalar>> output) const {
+    assert(input.rows() == First::inputSize && output.rows() == Last::outputSize && output.cols() == input.cols());
+    for (Eigen::Index j = 0; j < input.cols(); ++j) {
+      output.col(j).template head<Last::outputSize>() = predict(input.col(j));
+    }
+  }
+
+  /**
+   * @brief Access a layer
+   * @tparam I Position of the layer
+   */
+  template <std::size_t I>
+  auto& layer() {
+    return std::get<I>(m_layers);
+  }
+
+  /**
+   * @brief Access a layer
+   * @tparam I Position of the layer
+   */
+  template <std::size_t I>
+  const auto& layer() const {
+    return std::get<I>(m_layers);
+  }
+
+private:
+  template <std::size_t I, typename Vector>
+  auto apply(const Vector& x) const {
+    if constexpr (I + 1 == sizeof...(Layers)) {
+      return std::get<I>(m_layers)(x);
+    } else {
+      return apply<I + 1>(std::get<I>(m_layers)(x));
+    }
+  }
+
+  template <std::size_t... I>
+  void copyFrom(const Network<Scalar>& network, std::index_sequence<I...>) {
+    (copyLayer(*network.layers()[I], std::get<I>(m_layers), I), ...);
+  }
+
+  template <typename Static>
+  static void copyLayer(const Layer<Scalar>& source, Static& target, std::size_t index) {
+    if (source.inputSize() != Static::inputSize || source.outputSize() != Static::outputSize
+        || source.weights().cols() != Static::inputSize || source.weights().rows() != Static::outputSize
+        || source.activationType() != Static::activationType) {
+      throw std::invalid_argument("StaticNetwork: layer " + std::to_string(index) + " does not match the network");
+    }
+    target.weights = source.weights();
+    target.biases = source.biases();
+  }
+
+  /**
+   * @brief Layers, stored inline
+   */
+  std::tuple<Layers...> m_layers;
+};
+
+}  // namespace dmlfs
+
+#endif /* STATIC_NETWORK_H */
@@ -0,0 +1,255 @@
+#include "trainer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <numeric>
+
+#include <omp.h>
+
+namespace dmlfs {
+
+template <typename Scalar>
+Trainer<Scalar>::Trainer(Network<Scalar>& network,
+                         Optimizer<Scalar>& optimizer,
+                         LossFunction loss,
+                         LossDerivative lossDerivative,
+                         int batchSize,
+                         Shuffle shuffle,
+                         unsigned seed):
+    m_network{network},
+    m_optimizer{optimizer},
+    m_loss{std::move(loss)},
+    m_lossDerivative{std::move(lossDerivative)},
+    m_batchSize{batchSize},
+    m_shuffle{shuffle},
+    m_rng{seed}
+{
+  assert(batchSize > 0);
+}
+
+template <typename Scalar>
+Trainer<Scalar>::Trainer(Network<Scalar>& network,
+                         Optimizer<Scalar>& optimizer,
+                         FusedLoss loss,
+                         int batchSize,
+                         Shuffle shuffle,
+                         unsigned seed):
+    m_network{network},
+    m_optimizer{optimizer},
+    m_fusedLoss{std::move(loss)},
+    m_batchSize{batchSize},
+    m_shuffle{shuffle},
+    m_rng{seed}
+{
+  assert(batchSize > 0);
+}
+
+template <typename Scalar>
+Scalar Trainer<Scalar>::lossAndGradient(const Matrix& labels, const Matrix& output, Matrix& gradient) const {
+  if (m_fusedLoss) {
+    return m_fusedLoss(labels, output, gradient);
+  }
+  gradient = m_lossDerivative(labels, output);
+  return m_loss(labels, output);
+}
+
+template <typename Scalar>
+void Trainer<Scalar>::setNumThreads(int nThreads) {
+  assert(nThreads > 0);
+  m_nThreads = nThreads;
+}
+
+template <typename Scalar>
+void Trainer<Scalar>::setMode(Mode mode) {
+  m_mode = mode;
+}
+
+template <typename Scalar>
+Scalar Trainer<Scalar>::trainBatch(const Eigen::Ref<const Matrix>& features, const Matrix& labels) {
+  assert(features.cols() == labels.cols());
+  return step(features, labels);
+}
+
+template <typename Scalar>
+Scalar Trainer<Scalar>::step(const Eigen::Ref<const Matrix>& features, const Matrix& labels) {
+  if (m_nThreads > 1 && features.cols() > 1) {
+    return parallelStep(features, labels);
+  }
+
+  const Matrix& output = m_network.forward(features);
+  const Scalar loss = lossAndGradient(labels, output, m_batchGradient);
+  m_network.backward(m_batchGradient);
+  m_optimizer.update(m_network);
+  return loss;
+}
+
+template <typename Scalar>
+Scalar Trainer<Scalar>::parallelStep(const Eigen::Ref<const Matrix>& features, const Matrix& labels) {
+  const int maxThreads = static_cast<int>(std::min<Eigen::Index>(m_nThreads, features.cols()));
+  m_contexts.resize(maxThreads);
+  m_threadLabels.resize(maxThreads);
+  m_threadGradients.resize(maxThreads);
+  m_threadLosses.resize(maxThreads);
+
+  const Network<Scalar>& network = m_network;
+  int nThreads = 1;
+
+  #pragma omp parallel num_threads(maxThreads)
+  {
+    const int t = omp_get_thread_num();
+    const int nActive = omp_get_num_threads();
+    if (t == 0) {
+      nThreads = nActive;
+    }
+
+    const Eigen::Index first = features.cols() * t / nActive;
+    const Eigen::Index size = features.cols() * (t + 1) / nActive - first;
+
+    m_threadLabels[t] = labels.middleCols(first, size);
+    const Matrix& output = network.forward(features.middleCols(first, size), m_contexts[t]);
+    m_threadLosses[t] = lossAndGradient(m_threadLabels[t], output, m_threadGradients[t]) * static_cast<Scalar>(size);
+    network.backward(m_threadGradients[t], m_contexts[t]);
+
+    // Tree reduction: after the last round, thread 0 holds the sum of all gradients.
+    for (int stride = 1; stride < nActive; stride *= 2) {
+      #pragma omp barrier
+      if (t % (2 * stride) == 0 && t + stride < nActive) {
+        m_contexts[t].gradients() += m_contexts[t + stride].gradients();
+      }
+    }
+  }
+
+  m_optimizer.update(m_network, m_contexts.front());
+
+  Scalar loss = 0;
+  for (int t = 0; t < nThreads; ++t) {
+    loss += m_threadLosses[t];
+  }
+  return loss / static_cast<Scalar>(features.cols());
+}
+
+template <typename Scalar>
+Eigen::Ref<const typename Trainer<Scalar>::Matrix> Trainer<Scalar>::batch(Eigen::Index index,
+                                                                         const Eigen::Ref<const Matrix>& features,
+                                                                         const Eigen::Ref<const Matrix>& labels,
+                                                                         Matrix& featureBuffer,
+                                                                         Matrix& labelBuffer) const {
+  const Eigen::Index batch = m_shuffle == Shuffle::BATCHES ? m_order[index] : index;
+  const Eigen::Index first = batch * m_batchSize;
+  const Eigen::Index size = std::min<Eigen::Index>(m_batchSize, features.cols() - first);
+
+  labelBuffer.resize(labels.rows(), size);
+
+  if (m_shuffle == Shuffle::SAMPLES) {
+    featureBuffer.resize(features.rows(), size);
+    for (Eigen::Index j = 0; j < size; ++j) {
+      featureBuffer.col(j) = features.col(m_order[first + j]);
+      labelBuffer.col(j) = labels.col(m_order[first + j]);
+    }
+    return featureBuffer;
+  }
+
+  labelBuffer = labels.middleCols(first, size);
+  return features.middleCols(first, size);
+}
+
+template <typename Scalar>
+double Trainer<Scalar>::hogwildEpoch(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels, Eigen::Index nBatches, EpochStats& stats) {
+  m_contexts.resize(m_nThreads);
+  m_threadFeatures.resize(m_nThreads);
+  m_threadLabels.resize(m_nThreads);
+  m_threadGradients.resize(m_nThreads);
+
+  // Stateful optimizers must not allocate from inside the parallel region.
+  m_optimizer.prepare(m_network);
+
+  std::atomic<std::size_t> version{0};
+  std::size_t updates = 0;
+  std::size_t totalStaleness = 0;
+  std::size_t maxStaleness = 0;
+  double totalLoss = 0.0;
+
+  #pragma omp parallel num_threads(m_nThreads) reduction(+:updates, totalStaleness, totalLoss) reduction(max:maxStaleness)
+  {
+    const int t = omp_get_thread_num();
+    TrainingContext<Scalar>& context = m_contexts[t];
+    Matrix& batchLabels = m_threadLabels[t];
+
+    #pragma omp for schedule(dynamic)
+    for (Eigen::Index b = 0; b < nBatches; ++b) {
+      Eigen::Ref<const Matrix> batchFeatures = batch(b, features, labels, m_threadFeatures[t], batchLabels);
+
+      const std::size_t readVersion = version.load(std::memory_order_relaxed);
+      const Matrix& output = m_network.forward(batchFeatures, context);
+      const Scalar loss = lossAndGradient(batchLabels, output, m_threadGradients[t]);
+      m_network.backward(m_threadGradients[t], context);
+      m_optimizer.update(m_network, context);
+      const std::size_t staleness = version.fetch_add(1, std::memory_order_relaxed) - readVersion;
+
+      ++updates;
+      totalStaleness += staleness;
+      maxStaleness = std::max(maxStaleness, staleness);
+      totalLoss += loss;
+    }
+  }
+
+  stats.updates = updates;
+  stats.meanStaleness = updates > 0 ? static_cast<double>(totalStaleness) / static_cast<double>(updates) : 0.0;
+  stats.maxStaleness = maxStaleness;
+  return totalLoss;
+}
+
+template <typename Scalar>
+EpochStats Trainer<Scalar>::trainEpoch(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels) {
+  assert(features.cols() == labels.cols());
+
+  const auto start = std::chrono::steady_clock::now();
+
+  const Eigen::Index nSamples = features.cols();
+  const Eigen::Index nBatches = (nSamples + m_batchSize - 1) / m_batchSize;
+
+  if (m_shuffle != Shuffle::NONE) {
+    const Eigen::Index orderSize = m_shuffle == Shuffle::SAMPLES ? nSamples : nBatches;
+    if (static_cast<Eigen::Index>(m_order.size()) != orderSize) {
+      m_order.resize(orderSize);
+      std::iota(m_order.begin(), m_order.end(), 0);
+    }
+    std::shuffle(m_order.begin(), m_order.end(), m_rng);
+  }
+
+  EpochStats stats{};
+  double totalLoss = 0.0;
+  if (m_mode == Mode::HOGWILD) {
+    totalLoss = hogwildEpoch(features, labels, nBatches, stats);
+  } else {
+    for (Eigen::Index b = 0; b < nBatches; ++b) {
+      Eigen::Ref<const Matrix> batchFeatures = batch(b, features, labels, m_batchFeatures, m_batchLabels);
+      totalLoss += step(batchFeatures, m_batchLabels);
+      ++stats.updates;
+    }
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  stats.loss = totalLoss / static_cast<double>(nBatches);
+  stats.seconds = seconds;
+  stats.samplesPerSecond = seconds > 0.0 ? static_cast<double>(nSamples) / seconds : 0.0;
+  stats.updatesPerSecond = seconds > 0.0 ? static_cast<double>(stats.updates) / seconds : 0.0;
+  return stats;
+}
+
+template <typename Scalar>
+std::vector<EpochStats> Trainer<Scalar>::train(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels, int nEpochs) {
+  std::vector<EpochStats> stats;
+  stats.reserve(nEpochs);
+  for (int epoch = 0; epoch < nEpochs; ++epoch) {
+    stats.push_back(trainEpoch(features, labels));
+  }
+  return stats;
+}
+
+template class Trainer<float>;
+template class Trainer<double>;
+
+}  // namespace dmlfs
@@ -0,0 +1,296 @@
+#ifndef TRAINER_H_
+#define TRAINER_H_
+
+#include "network.h"
+#include "optimizer.h"
+
+#include "Eigen/Dense"
+
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Summary of one pass over the training set
+ */
+struct EpochStats {
+  /**
+   * @brief Loss averaged over the mini-batches of the epoch
+   */
+  double loss;
+
+  /**
+   * @brief Wall-clock duration of the epoch in seconds
+   */
+  double seconds;
+
+  /**
+   * @brief Training throughput
+   */
+  double samplesPerSecond;
+
+  /**
+   * @brief Number of optimizer updates applied during the epoch
+   */
+  std::size_t updates;
+
+  /**
+   * @brief Optimizer update rate
+   */
+  double updatesPerSecond;
+
+  /**
+   * @brief Average number of other updates applied while a gradient was being computed
+   *
+   * Always zero in synchronous mode.
+   */
+  double meanStaleness;
+
+  /**
+   * @brief Largest staleness observed during the epoch
+   */
+  std::size_t maxStaleness;
+};
+
+/**
+ * @brief Mini-batch training loop
+ * @tparam Scalar Floating point type of the network's parameters
+ *
+ * The dataset is laid out like the network's inputs: one column per sample,
+ * with `features` of size `inputSize x nSamples` and `labels` of size
+ * `outputSize x nSamples`.
+ *
+ * Batches are handed to the network as views into the dataset whenever their
+ * samples are contiguous. Only `Shuffle::SAMPLES` gathers the columns of each
+ * batch, into a buffer reused across batches, so the dataset itself is never
+ * copied or permuted.
+ */
+template <typename Scalar = double>
+class Trainer {
+public:
+  using Matrix = typename Network<Scalar>::Matrix;
+  using LossFunction = std::function<Scalar(const Matrix& y, const Matrix& yHat)>;
+  using LossDerivative = std::function<Matrix(const Matrix& y, const Matrix& yHat)>;
+
+  /**
+   * @brief Loss computing its value and its gradient together, e.g. `softmaxCrossEntropy`
+   *
+   * The gradient goes to a buffer owned by the trainer, so steps with the same
+   * batch size do not allocate.
+   */
+  using FusedLoss = std::function<Scalar(const Matrix& y, const Matrix& yHat, Matrix& gradient)>;
+
+  /**
+   * @brief Enum class to represent how samples are visited within an epoch
+   */
+  enum class Shuffle {
+    NONE,     ///< Contiguous batches in dataset order
+    BATCHES,  ///< Contiguous batches in a random order
+    SAMPLES   ///< Batches gathered from a random permutation of the samples
+  };
+
+  /**
+   * @brief Enum class to represent how updates from several threads are combined
+   */
+  enum class Mode {
+    SYNCHRONOUS,  ///< Split each mini-batch across threads and reduce the gradients
+    HOGWILD       ///< Each thread trains on its own mini-batches and updates the parameters without locks
+  };
+
+  /**
+   * @brief Constructor
+   * @param network Network to train
+   * @param optimizer Optimizer applied after each mini-batch
+   * @param loss Loss function, used for reporting
+   * @param lossDerivative Derivative of the loss with respect to the network's output
+   * @param batchSize Number of samples per mini-batch
+   * @param shuffle How samples are visited within an epoch
+   * @param seed Seed of the shuffling random number generator
+   */
+  Trainer(Network<Scalar>& network,
+          Optimizer<Scalar>& optimizer,
+          LossFunction loss,
+          LossDerivative lossDerivative,
+          int batchSize,
+          Shuffle shuffle = Shuffle::SAMPLES,
+          unsigned seed = std::random_device{}());
+
+  /**
+   * @brief Constructor taking a fused loss
+   * @param network Network to train
+   * @param optimizer Optimizer applied after each mini-batch
+   * @param loss Loss function returning the loss and writing its gradient
+   * @param batchSize Number of samples per mini-batch
+   * @param shuffle How samples are visited within an epoch
+   * @param seed Seed of the shuffling random number generator
+   */
+  Trainer(Network<Scalar>& network,
+          Optimizer<Scalar>& optimizer,
+          FusedLoss loss,
+          int batchSize,
+          Shuffle shuffle = Shuffle::SAMPLES,
+          unsigned seed = std::random_device{}());
+
+  /**
+   * @brief Enable data-parallel training
+   * @param nThreads Number of threads each mini-batch is split across
+   *
+   * With more than one thread, every mini-batch is split into contiguous
+   * column ranges, one per thread. Each thread runs forward and backward on
+   * its range with its own `TrainingContext`, then their flat gradients
+   * are summed with a tree reduction before a single optimizer step. Since
+   * the gradients are sums over samples, the result matches the
+   * single-threaded step up to floating point rounding.
+   */
+  void setNumThreads(int nThreads);
+
+  /**
+   * @brief Choose how the threads set by `setNumThreads` cooperate
+   * @param mode Synchronous or asynchronous training
+   *
+   * In `Mode::HOGWILD`, mini-batches are handed out dynamically to the
+   * threads. Each thread runs forward and backward with its own
+   * `TrainingContext`, then applies its gradients straight to the shared
+   * parameters through `Optimizer::update(Network&, const TrainingContext&)`.
+   * No locks are taken, so workers read parameters that other workers are
+   * updating. This is the intended Hogwild! behaviour, and it pays off for
+   * wide, sparse models where concurrent updates rarely touch the same
+   * coefficients. The staleness counters in `EpochStats` measure how many
+   * updates landed while each gradient was being computed.
+   */
+  void setMode(Mode mode);
+
+  /**
+   * @brief Run one pass over the dataset
+   * @param features Input features, one column per sample
+   * @param labels Targets, one column per sample
+   * @return Statistics of the epoch
+   *
+   * The dataset is only read through views, so a `MappedDataset` can be
+   * trained on without loading it into memory.
+   */
+  EpochStats trainEpoch(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels);
+
+  /**
+   * @brief Run several passes over the dataset
+   * @param features Input features, one column per sample
+   * @param labels Targets, one column per sample
+   * @param nEpochs Number of epochs
+   * @return Statistics of each epoch
+   */
+  std::vector<EpochStats> train(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels, int nEpochs);
+
+  /**
+   * @brief Train on a single mini-batch supplied by the caller
+   * @param features Input features of the mini-batch, one column per sample
+   * @param labels Targets of the mini-batch, one column per sample
+   * @return Loss of the mini-batch
+   *
+   * For datasets that produce their own batches, e.g. converting stored bytes
+   * on the fly, instead of exposing the whole dataset as a matrix. Honours
+   * `setNumThreads` like `trainEpoch`.
+   */
+  Scalar trainBatch(const Eigen::Ref<const Matrix>& features, const Matrix& labels);
+
+private:
+  /**
+   * @brief Compute the loss of a mini-batch and its gradient with respect to the output
+   * @param gradient Receives the gradient
+   * @return Loss of the mini-batch
+   */
+  Scalar lossAndGradient(const Matrix& labels, const Matrix& output, Matrix& gradient) const;
+
+  /**
+   * @brief Forward, backward and update on a single mini-batch
+   * @return Loss of the mini-batch
+   */
+  Scalar step(const Eigen::Ref<const Matrix>& features, const Matrix& labels);
+
+  /**
+   * @brief Data-parallel version of `step`
+   * @return Loss of the mini-batch
+   */
+  Scalar parallelStep(const Eigen::Ref<const Matrix>& features, const Matrix& labels);
+
+  /**
+   * @brief Lock-free asynchronous pass over the batches of an epoch
+   * @return Sum of the mini-batch losses
+   */
+  double hogwildEpoch(const Eigen::Ref<const Matrix>& features, const Eigen::Ref<const Matrix>& labels, Eigen::Index nBatches, EpochStats& stats);
+
+  /**
+   * @brief Select the samples of a mini-batch
+   * @param index Position of the mini-batch within the epoch
+   * @param featureBuffer Storage for gathered features, used with `Shuffle::SAMPLES`
+   * @param labelBuffer Receives the labels of the mini-batch
+   * @return View of the features of the mini-batch
+   */
+  Eigen::Ref<const Matrix> batch(Eigen::Index index,
+                                 const Eigen::Ref<const Matrix>& features,
+                                 const Eigen::Ref<const Matrix>& labels,
+                                 Matrix& featureBuffer,
+                                 Matrix& labelBuffer) const;
+
+  Network<Scalar>& m_network;
+  Optimizer<Scalar>& m_optimizer;
+  LossFunction m_loss;
+  LossDerivative m_lossDerivative;
+  FusedLoss m_fusedLoss;
+  int m_batchSize;
+  Shuffle m_shuffle;
+  std::mt19937 m_rng;
+  int m_nThreads = 1;
+  Mode m_mode = Mode::SYNCHRONOUS;
+
+  /**
+   * @brief Sample order for `Shuffle::SAMPLES`, batch order for `Shuffle::BATCHES`
+   */
+  std::vector<Eigen::Index> m_order;
+
+  /**
+   * @brief Reused storage for gathered features of a mini-batch
+   */
+  Matrix m_batchFeatures;
+
+  /**
+   * @brief Reused storage for the labels of a mini-batch
+   */
+  Matrix m_batchLabels;
+
+  /**
+   * @brief Reused storage for the gradient of the loss of a mini-batch
+   */
+  Matrix m_batchGradient;
+
+  /**
+   * @brief Training state of each thread in data-parallel mode
+   */
+  std::vector<TrainingContext<Scalar>> m_contexts;
+
+  /**
+   * @brief Labels of each thread's share of the mini-batch
+   */
+  std::vector<Matrix> m_threadLabels;
+
+  /**
+   * @brief Gradient of the loss of each thread's share of the mini-batch
+   */
+  std::vector<Matrix> m_threadGradients;
+
+  /**
+   * @brief Gathered features of each thread's mini-batch in Hogwild mode
+   */
+  std::vector<Matrix> m_threadFeatures;
+
+  /**
+   * @brief Loss of each thread's share of the mini-batch, weighted by its size
+   */
+  std::vector<Scalar> m_threadLosses;
+};
+
+}  // namespace dmlfs
+
+
+#endif // TRAINER_H_
@@ -0,0 +1,105 @@
+/**
+ * @file mnist_mlp.cpp
+ *
+ * @brief Train an MLP on MNIST with the native IDX loader, without libtorch.
+ *
+ * Usage: mnist_mlp [epochs] [batch_size]
+ *
+ * The IDX files are read from `MNIST_DATA_DIR`. Pixels stay as bytes in the
+ * mapped files and each mini-batch is normalized on the fly, so the inputs
+ * never take more memory than the raw files.
+ */
+
+#include "datautils/idx.h"
+#include "network/loss_functions.h"
+#include "network/trainer.h"
+
+#include "Eigen/Dense"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+using Scalar = float;
+using Matrix = Eigen::MatrixX<Scalar>;
+
+// Where to find the MNIST dataset.
+const std::string kDataRoot = MNIST_DATA_DIR;
+
+// Usual normalization constants of MNIST.
+constexpr Scalar kMean = 0.1307f;
+constexpr Scalar kStddev = 0.3081f;
+
+double accuracy(Network<Scalar>& network, const IdxDataset<Scalar>& dataset) {
+  constexpr Eigen::Index kBatchSize = 1000;
+  Matrix images;
+  Eigen::Index correct = 0;
+  for (Eigen::Index first = 0; first < dataset.size(); first += kBatchSize) {
+    const Eigen::Index count = std::min(kBatchSize, dataset.size() - first);
+    dataset.imageBatch(first, count, images);
+    auto output = network.predict(images);
+    for (Eigen::Index j = 0; j < count; ++j) {
+      Eigen::Index predicted;
+      output.col(j).maxCoeff(&predicted);
+      correct += predicted == dataset.label(first + j);
+    }
+  }
+  return static_cast<double>(correct) / static_cast<double>(dataset.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const int nEpochs = argc > 1 ? std::atoi(argv[1]) : 5;
+  const int batchSize = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  IdxDataset<Scalar> train(kDataRoot + "/train-images-idx3-ubyte", kDataRoot + "/train-labels-idx1-ubyte", 10, kMean, kStddev);
+  IdxDataset<Scalar> test(kDataRoot + "/t10k-images-idx3-ubyte", kDataRoot + "/t10k-labels-idx1-ubyte", 10, kMean, kStddev);
+
+  Network<Scalar> network;
+  network.addLayer(std::make_shared<Layer<Scalar>>(train.pixelCount(), 128, Initializer<>::Type::XAVIER, Activation<>::Type::RELU))
+         .addLayer(std::make_shared<Layer<Scalar>>(128, 64, Initializer<>::Type::XAVIER, Activation<>::Type::RELU))
+         .addLayer(std::make_shared<Layer<Scalar>>(64, 10, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+
+  Adam<Scalar> optimizer(1e-3f);
+  Trainer<Scalar> trainer(network, optimizer, softmaxCrossEntropy<Scalar>, batchSize);
+
+  std::vector<Eigen::Index> order(train.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::mt19937 rng{0};
+
+  Matrix images;
+  Matrix labels;
+  std::vector<Eigen::Index> indices;
+  for (int epoch = 1; epoch <= nEpochs; ++epoch) {
+    const auto start = std::chrono::steady_clock::now();
+    std::shuffle(order.begin(), order.end(), rng);
+
+    double loss = 0.0;
+    Eigen::Index nBatches = 0;
+    for (Eigen::Index first = 0; first < train.size(); first += batchSize) {
+      const Eigen::Index count = std::min<Eigen::Index>(batchSize, train.size() - first);
+      indices.assign(order.begin() + first, order.begin() + first + count);
+      train.imageBatch(indices, images);
+      train.labelBatch(indices, labels);
+      loss += trainer.trainBatch(images, labels);
+      ++nBatches;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Epoch %d: loss %.4f, test accuracy %.2f%%, %.1fs\n",
+                epoch, loss / nBatches, 100.0 * accuracy(network, test), seconds);
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+#include "network/batching_server.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace dmlfs;
+using namespace std::chrono_literals;
+
+namespace {
+
+const std::vector<int> kSizes = {8, 32, 4};
+const std::vector<ActivationBase::Type> kActivations = {Activation<>::Type::RELU, Activation<>::Type::NONE};
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Batched requests get the same outputs as direct inference", "[BatchingServer]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+  using Vector = Eigen::VectorX<TestType>;
+
+  const Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  const Matrix inputs = Matrix::Random(8, 200);
+  InferenceContext<TestType> context;
+  const Matrix expected = network.predict(inputs, context);
+
+  BatchingServer<TestType> server(network, 16, 200us, 2);
+
+  constexpr int nClients = 4;
+  std::vector<int> mismatches(nClients, 0);
+  std::vector<std::thread> clients;
+  for (int c = 0; c < nClients; ++c) {
+    clients.emplace_back([&, c]() {
+      std::vector<std::future<Vector>> outputs;
+      for (Eigen::Index j = c; j < inputs.cols(); j += nClients) {
+        outputs.push_back(server.submit(inputs.col(j)));
+      }
+      Eigen::Index j = c;
+      for (auto& output : outputs) {
+        if (!output.get().isApprox(expected.col(j))) {
+          ++mismatches[c];
+        }
+        j += nClients;
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+
+  for (int c = 0; c < nClients; ++c) {
+    REQUIRE(mismatches[c] == 0);
+  }
+  REQUIRE(server.requests() == 200);
+  REQUIRE(server.batches() < 200);
+}
+
+TEST_CASE("Full batches are run without waiting for the timeout", "[BatchingServer]") {
+  const Network<double> network = make_mlp<double>(kSizes, kActivations);
+  BatchingServer<double> server(network, 16, 10s);
+
+  std::vector<std::future<Eigen::VectorXd>> outputs;
+  for (int i = 0; i < 64; ++i) {
+    outputs.push_back(server.submit(Eigen::VectorXd::Random(8)));
+  }
+  for (auto& output : outputs) {
+    REQUIRE(output.wait_for(5s) == std::future_status::ready);
+  }
+  REQUIRE(server.batches() == 4);
+}
+
+TEST_CASE("A lone request is run once its wait expires", "[BatchingServer]") {
+  const Network<double> network = make_mlp<double>(kSizes, kActivations);
+  BatchingServer<double> server(network, 1024, 1ms);
+
+  const Eigen::VectorXd input = Eigen::VectorXd::Random(8);
+  auto output = server.submit(input);
+  REQUIRE(output.wait_for(5s) == std::future_status::ready);
+
+  InferenceContext<double> context;
+  REQUIRE(output.get().isApprox(network.predict(input, context).col(0)));
+  REQUIRE(server.batches() == 1);
+}
+
+TEST_CASE("Stopping the server answers the pending requests", "[BatchingServer]") {
+  const Network<double> network = make_mlp<double>(kSizes, kActivations);
+  std::vector<std::future<Eigen::VectorXd>> outputs;
+  {
+    BatchingServer<double> server(network, 1024, 10s);
+    for (int i = 0; i < 10; ++i) {
+      outputs.push_back(server.submit(Eigen::VectorXd::Random(8)));
+    }
+  }
+  for (auto& output : outputs) {
+    REQUIRE(output.wait_for(0s) == std::future_status::ready);
+    REQUIRE(output.get().size() == 4);
+  }
+}
+
+TEST_CASE("The batching server validates its arguments", "[BatchingServer]") {
+  const Network<double> empty;
+  REQUIRE_THROWS_AS(BatchingServer<double>(empty, 16, 1ms), std::invalid_argument);
+
+  const Network<double> network = make_mlp<double>(kSizes, kActivations);
+  REQUIRE_THROWS_AS(BatchingServer<double>(network, 0, 1ms), std::invalid_argument);
+  REQUIRE_THROWS_AS(BatchingServer<double>(network, 16, 1ms, 0), std::invalid_argument);
+
+  BatchingServer<double> server(network, 16, 1ms);
+  REQUIRE_THROWS_AS(server.submit(Eigen::VectorXd::Random(7)), std::invalid_argument);
+}
@@ -0,0 +1,183 @@
+#include "network/conv2d.h"
+#include "network/network.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+using namespace dmlfs;
+
+namespace {
+
+/**
+ * @brief Direct convolution on height, width, channel images, one per column
+ */
+template <typename Scalar>
+Eigen::MatrixX<Scalar> reference_conv(const Eigen::MatrixX<Scalar>& input, const Conv2D<Scalar>& layer,
+                                      int height, int width, int kernelSize, int stride, int padding) {
+  const int inChannels = layer.inChannels();
+  const int outChannels = layer.outChannels();
+  Eigen::MatrixX<Scalar> output(layer.outputSize(), input.cols());
+
+  for (Eigen::Index n = 0; n < input.cols(); ++n) {
+    for (int oy = 0; oy < layer.outputHeight(); ++oy) {
+      for (int ox = 0; ox < layer.outputWidth(); ++ox) {
+        for (int f = 0; f < outChannels; ++f) {
+          Scalar sum = layer.biases()(f, 0);
+          for (int ky = 0; ky < kernelSize; ++ky) {
+            for (int kx = 0; kx < kernelSize; ++kx) {
+              const int iy = oy * stride - padding + ky;
+              const int ix = ox * stride - padding + kx;
+              if (iy < 0 || iy >= height || ix < 0 || ix >= width) {
+                continue;
+              }
+              for (int c = 0; c < inChannels; ++c) {
+                sum += layer.weights()(f, (ky * kernelSize + kx) * inChannels + c)
+                       * input((iy * width + ix) * inChannels + c, n);
+              }
+            }
+          }
+          output((oy * layer.outputWidth() + ox) * outChannels + f, n) = sum;
+        }
+      }
+    }
+  }
+  return output;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Conv2D matches a direct convolution", "[Conv2D]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  struct Shape { int channels, height, width, filters, kernel, stride, padding; };
+  for (const Shape& s : {Shape{1, 6, 6, 2, 3, 1, 0}, Shape{3, 7, 5, 4, 3, 2, 1}, Shape{2, 4, 4, 3, 2, 1, 2}}) {
+    Conv2D<TestType> layer(s.channels, s.height, s.width, s.filters, s.kernel, s.stride, s.padding,
+                           Initializer<>::Type::XAVIER, Activation<>::Type::NONE);
+    layer.updateBiases(Matrix::Random(s.filters, 1));
+
+    REQUIRE(layer.outputHeight() == (s.height + 2 * s.padding - s.kernel) / s.stride + 1);
+    REQUIRE(layer.outputWidth() == (s.width + 2 * s.padding - s.kernel) / s.stride + 1);
+
+    Matrix input = Matrix::Random(layer.inputSize(), 5);
+    const Matrix expected = reference_conv<TestType>(input, layer, s.height, s.width, s.kernel, s.stride, s.padding);
+
+    REQUIRE(layer.forward(input).isApprox(expected));
+
+    Matrix output(layer.outputSize(), input.cols());
+    layer.predict(input, output);
+    REQUIRE(output.isApprox(expected));
+
+    // The patches go to the caller's scratch buffer, reused by later calls.
+    Matrix scratch;
+    output.setZero();
+    layer.predict(input, output, scratch);
+    REQUIRE(output.isApprox(expected));
+    const TestType* patches = scratch.data();
+    layer.predict(input, output, scratch);
+    REQUIRE(scratch.data() == patches);
+    REQUIRE(output.isApprox(expected));
+  }
+}
+
+TEST_CASE("Conv2D gradients match finite differences", "[Conv2D]") {
+  using Matrix = Eigen::MatrixXd;
+
+  Conv2D<double> layer(2, 5, 5, 3, 3, 2, 1, Initializer<>::Type::XAVIER, Activation<>::Type::TANH);
+  Matrix input = Matrix::Random(layer.inputSize(), 3);
+  Matrix dOutput = Matrix::Random(layer.outputSize(), 3);
+
+  // The loss is the dot product of the output with dOutput.
+  auto loss = [&](const Conv2D<double>& l, const Matrix& x) {
+    Matrix output(l.outputSize(), x.cols());
+    l.predict(x, output);
+    return output.cwiseProduct(dOutput).sum();
+  };
+
+  layer.forward(input);
+  const Matrix dInput = layer.backward(dOutput);
+  const double h = 1e-6;
+
+  for (Eigen::Index i = 0; i < input.size(); i += 7) {
+    Matrix plus = input, minus = input;
+    plus(i) += h;
+    minus(i) -= h;
+    REQUIRE(std::abs((loss(layer, plus) - loss(layer, minus)) / (2 * h) - dInput(i)) < 1e-6);
+  }
+
+  const Matrix weightsGrad = layer.weights_grad();
+  for (Eigen::Index i = 0; i < layer.weights().size(); i += 5) {
+    Matrix delta = Matrix::Zero(layer.weights().rows(), layer.weights().cols());
+    delta(i) = h;
+    layer.updateWeights(delta);
+    const double up = loss(layer, input);
+    layer.updateWeights(-2 * delta);
+    const double down = loss(layer, input);
+    layer.updateWeights(delta);
+    REQUIRE(std::abs((up - down) / (2 * h) - weightsGrad(i)) < 1e-6);
+  }
+
+  const Matrix biasesGrad = layer.biases_grad();
+  for (Eigen::Index f = 0; f < 3; ++f) {
+    Matrix delta = Matrix::Zero(3, 1);
+    delta(f) = h;
+    layer.updateBiases(delta);
+    const double up = loss(layer, input);
+    layer.updateBiases(-2 * delta);
+    const double down = loss(layer, input);
+    layer.updateBiases(delta);
+    REQUIRE(std::abs((up - down) / (2 * h) - biasesGrad(f)) < 1e-6);
+  }
+}
+
+TEST_CASE("Conv2D trains inside a network", "[Conv2D]") {
+  using Matrix = Eigen::MatrixXd;
+
+  Network<double> network;
+  network.addLayer(std::make_shared<Conv2D<double>>(1, 8, 8, 4, 3, 1, 1, Initializer<>::Type::XAVIER, Activation<>::Type::RELU))
+         .addLayer(std::make_shared<Layer<double>>(8 * 8 * 4, 2, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+
+  // Fixed initial parameters and noise, so that the outcome does not depend on the run.
+  std::mt19937 rng{7};
+  std::uniform_real_distribution<double> weight(-0.3, 0.3);
+  std::uniform_real_distribution<double> noise(-0.1, 0.1);
+  for (Eigen::Index i = 0; i < network.parameters().size(); ++i) {
+    network.parameters()(i) = weight(rng);
+  }
+
+  // Tell apart images whose left or right half is lit.
+  Matrix features = Matrix::NullaryExpr(64, 32, [&]() { return noise(rng); });
+  Matrix labels = Matrix::Zero(2, 32);
+  for (Eigen::Index n = 0; n < 32; ++n) {
+    const int side = static_cast<int>(n % 2);
+    for (int y = 0; y < 8; ++y) {
+      features.col(n).segment(y * 8 + side * 4, 4).array() += 1;
+    }
+    labels(side, n) = 1;
+  }
+
+  auto loss = [&]() {
+    return (network.predict(features) - labels).squaredNorm();
+  };
+
+  const double initial = loss();
+  for (int step = 0; step < 50; ++step) {
+    const Matrix& output = network.forward(features);
+    network.backward(2 * (output - labels) / features.cols());
+    network.parameters() -= 0.05 * network.gradients();
+  }
+
+  REQUIRE(loss() < 0.1 * initial);
+  REQUIRE_THROWS_AS(network.save("conv.dmlfs"), std::runtime_error);
+}
+
+TEST_CASE("Conv2D rejects invalid shapes", "[Conv2D]") {
+  REQUIRE_THROWS_AS(Conv2D<double>(1, 4, 4, 2, 5), std::invalid_argument);
+  REQUIRE_THROWS_AS(Conv2D<double>(1, 4, 4, 2, 3, 0), std::invalid_argument);
+  REQUIRE_NOTHROW(Conv2D<double>(1, 4, 4, 2, 5, 1, 1));
+}
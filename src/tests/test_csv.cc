@@ -0,0 +1,89 @@
+#include "datautils/csv.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+std::string write_file(const std::string& name, const std::string& content) {
+  const std::string path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream{path, std::ios::binary} << content;
+  return path;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Numeric CSV fast path fills features and labels column by column", "[CSV]", float, double) {
+  const std::string path = write_file("dmlfs_test_numeric.csv",
+                                      "x,label,y\r\n"
+                                      "1.5,0,-2\r\n"
+                                      "\r\n"
+                                      " 3, 1 ,+4e1\r\n"
+                                      "-0.25,1,0.5");
+
+  NumericCsv<TestType> csv = read_numeric_csv<TestType>(path, {1});
+
+  REQUIRE(csv.header == std::vector<std::string>{"x", "label", "y"});
+  REQUIRE(csv.features.rows() == 2);
+  REQUIRE(csv.features.cols() == 3);
+  REQUIRE(csv.labels.rows() == 1);
+
+  Eigen::MatrixX<TestType> features(2, 3);
+  features << 1.5, 3, -0.25,
+              -2, 40, 0.5;
+  Eigen::MatrixX<TestType> labels(1, 3);
+  labels << 0, 1, 1;
+  REQUIRE(csv.features == features);
+  REQUIRE(csv.labels == labels);
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Numeric CSV fast path agrees with read_csv on a large file", "[CSV]") {
+  const int nRows = 20000;
+  Eigen::MatrixXd expected = Eigen::MatrixXd::Random(4, nRows);
+
+  std::string content;
+  char buffer[128];
+  for (int j = 0; j < nRows; ++j) {
+    std::snprintf(buffer, sizeof(buffer), "%.17g,%.17g,%.17g,%.17g\n",
+                  expected(0, j), expected(1, j), expected(2, j), expected(3, j));
+    content += buffer;
+  }
+  const std::string path = write_file("dmlfs_test_large.csv", content);
+
+  NumericCsv<double> csv = read_numeric_csv<double>(path, {}, false);
+  REQUIRE(csv.features == expected);
+  REQUIRE(csv.labels.rows() == 0);
+
+  auto rows = read_csv(path);
+  REQUIRE(static_cast<Eigen::Index>(rows.size()) == csv.features.cols());
+  REQUIRE(std::stod(rows.back()[2]) == csv.features(2, nRows - 1));
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("Numeric CSV fast path rejects malformed rows", "[CSV]") {
+  const std::string badField = write_file("dmlfs_test_bad_field.csv", "a,b\n1,2\n3,x\n");
+  REQUIRE_THROWS_AS(read_numeric_csv<double>(badField), std::runtime_error);
+
+  const std::string shortRow = write_file("dmlfs_test_short_row.csv", "1,2,3\n4,5\n");
+  REQUIRE_THROWS_AS(read_numeric_csv<double>(shortRow, {}, false), std::runtime_error);
+
+  REQUIRE_THROWS_AS(read_numeric_csv<double>(badField, {7}), std::runtime_error);
+  REQUIRE_THROWS_AS(read_numeric_csv<double>("/nonexistent/file.csv"), std::runtime_error);
+
+  std::filesystem::remove(badField);
+  std::filesystem::remove(shortRow);
+}
@@ -1,3 +1,179 @@
+#include "datautils/categorical_encoder.h"
+#include "datautils/scaler.h"
+
 #include "Eigen/Dense"
 
 #include "catch2/catch_test_macros.hpp"
+
+#include <cmath>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+using Record = StructRepresentation<1, 2>;
+
+std::vector<Record> make_records(int n) {
+  std::vector<Record> records(n);
+  for (int i = 0; i < n; ++i) {
+    records[i].id = i;
+    records[i].continuous_features = {0.5 * i};
+    records[i].categorical_features = {(i % 5) * 100 - 200, i * 7919};
+  }
+  return records;
+}
+
+}  // namespace
+
+TEST_CASE("Vocabulary encoder numbers the values of each feature in order", "[Preprocessing]") {
+  std::vector<Record> records = make_records(5000);
+
+  CategoricalEncoder<2> encoder;
+  encoder.fit(records);
+
+  REQUIRE(encoder.categoryCount(0) == 5 + 1);
+  REQUIRE(encoder.categoryCount(1) == 5000 + 1);
+  REQUIRE(encoder.offsets() == std::vector<int>{0, 6});
+  REQUIRE(encoder.totalCategories() == 6 + 5001);
+
+  REQUIRE(encoder.encode(0, -200) == 0);
+  REQUIRE(encoder.encode(0, 200) == 4);
+  REQUIRE(encoder.encode(0, 12345) == 5);
+  REQUIRE(encoder.encode(1, 0) == 6);
+  REQUIRE(encoder.encode(1, 4999 * 7919) == 6 + 4999);
+  REQUIRE(encoder.encode(1, -1) == 6 + 5000);
+
+  SparseInput<double> input = encoder.transform(records);
+  REQUIRE(input.categoryCount == encoder.totalCategories());
+  REQUIRE(input.continuous(0, 10) == 5.0);
+  for (int i = 0; i < 5000; ++i) {
+    REQUIRE(input.categories(0, i) == i % 5);
+    REQUIRE(input.categories(1, i) == 6 + i);
+  }
+}
+
+TEST_CASE("Vocabulary encoder agrees with convert_to_sparse_input on dense categories", "[Preprocessing]") {
+  std::vector<Record> records(40);
+  for (int i = 0; i < 40; ++i) {
+    records[i].continuous_features = {1.0 * i};
+    records[i].categorical_features = {i % 3, i % 8};
+  }
+
+  CategoricalEncoder<2> encoder;
+  encoder.fit(records);
+  SparseInput<float> encoded = encoder.transform<float>(records);
+  SparseInput<float> reference = convert_to_sparse_input<float>(records);
+
+  // The encoder adds one column per feature for unseen values.
+  REQUIRE(encoded.categories.row(0) == reference.categories.row(0));
+  REQUIRE(encoded.categories.row(1) == (reference.categories.row(1).array() + 1).matrix());
+  REQUIRE(encoded.continuous == reference.continuous);
+}
+
+TEST_CASE("Hashing encoder bounds the dimension without fitting", "[Preprocessing]") {
+  std::vector<Record> records = make_records(20000);
+
+  CategoricalEncoder<2> encoder(CategoricalEncoder<2>::Mode::HASHING, 1024);
+  encoder.fit(records);
+
+  REQUIRE(encoder.totalCategories() == 2048);
+
+  SparseInput<double> input = encoder.transform(records);
+  std::set<int> buckets;
+  for (int i = 0; i < 20000; ++i) {
+    REQUIRE(input.categories(0, i) >= 0);
+    REQUIRE(input.categories(0, i) < 1024);
+    REQUIRE(input.categories(1, i) >= 1024);
+    REQUIRE(input.categories(1, i) < 2048);
+    REQUIRE(input.categories(1, i) == encoder.encode(1, records[i].categorical_features[1]));
+    buckets.insert(input.categories(1, i));
+  }
+  // 20000 distinct values should spread over nearly all buckets.
+  REQUIRE(buckets.size() > 1000);
+}
+
+TEST_CASE("Standard scaler streams Welford statistics and standardizes in place", "[Preprocessing]") {
+  Eigen::MatrixXf data = Eigen::MatrixXf::Random(6, 10000);
+  data.row(0).array() = data.row(0).array() * 50.0f + 1000.0f;
+  data.row(5).setConstant(3.0f);
+
+  StandardScaler<float> scaler;
+  scaler.fit(data, 777);
+
+  const Eigen::VectorXd mean = data.cast<double>().rowwise().mean();
+  const Eigen::VectorXd variance = (data.cast<double>().colwise() - mean).rowwise().squaredNorm() / data.cols();
+  REQUIRE(scaler.count() == 10000);
+  REQUIRE(scaler.mean().isApprox(mean, 1e-10));
+  REQUIRE(scaler.variance().isApprox(variance, 1e-10));
+
+  // Fitting in one go and batch by batch give the same statistics.
+  StandardScaler<float> streamed;
+  streamed.partialFit(data.leftCols(1234));
+  streamed.partialFit(data.rightCols(10000 - 1234));
+  REQUIRE(streamed.mean().isApprox(scaler.mean(), 1e-12));
+  REQUIRE(streamed.variance().isApprox(scaler.variance(), 1e-12));
+
+  Eigen::MatrixXf batch = data.middleCols(100, 64);
+  scaler.transform(batch);
+  for (Eigen::Index i = 0; i < 5; ++i) {
+    const Eigen::ArrayXd expected = (data.row(i).segment(100, 64).transpose().array().cast<double>() - mean(i)) / std::sqrt(variance(i));
+    REQUIRE(batch.row(i).transpose().cast<double>().isApprox(expected.matrix(), 1e-4));
+  }
+  REQUIRE(batch.row(5).isZero());
+}
+
+TEST_CASE("Min-max scaler maps each feature to the requested range", "[Preprocessing]") {
+  Eigen::MatrixXd data = Eigen::MatrixXd::Random(3, 500) * 10;
+  data.row(2).setConstant(-4);
+
+  MinMaxScaler<double> scaler(-1, 1);
+  scaler.fit(data, 64);
+
+  REQUIRE(scaler.min() == data.rowwise().minCoeff());
+  REQUIRE(scaler.max() == data.rowwise().maxCoeff());
+
+  scaler.transform(data);
+  for (Eigen::Index i = 0; i < 2; ++i) {
+    REQUIRE(std::abs(data.row(i).minCoeff() + 1) < 1e-12);
+    REQUIRE(std::abs(data.row(i).maxCoeff() - 1) < 1e-12);
+  }
+  REQUIRE((data.row(2).array() == -1).all());
+}
+
+TEST_CASE("Scalers refuse to transform before seeing any sample", "[Preprocessing]") {
+  Eigen::MatrixXd batch = Eigen::MatrixXd::Random(3, 8);
+  const Eigen::MatrixXd empty(3, 0);
+
+  StandardScaler<double> standard;
+  REQUIRE_THROWS_AS(standard.transform(batch), std::runtime_error);
+  standard.partialFit(empty);
+  REQUIRE_THROWS_AS(standard.transform(batch), std::runtime_error);
+
+  MinMaxScaler<double> minMax;
+  REQUIRE_THROWS_AS(minMax.transform(batch), std::runtime_error);
+  minMax.partialFit(empty);
+  REQUIRE(minMax.count() == 0);
+  REQUIRE_THROWS_AS(minMax.transform(batch), std::runtime_error);
+
+  // An empty first batch leaves no infinite bounds behind.
+  minMax.partialFit(batch);
+  minMax.partialFit(empty);
+  Eigen::MatrixXd scaled = batch;
+  minMax.transform(scaled);
+  REQUIRE(scaled.allFinite());
+  REQUIRE(scaled.minCoeff() == 0);
+  REQUIRE(std::abs(scaled.maxCoeff() - 1) < 1e-12);
+
+  standard.partialFit(batch);
+  standard.transform(batch);
+  REQUIRE(batch.allFinite());
+
+  // Refitting on nothing forgets the previous statistics.
+  standard.fit(empty);
+  REQUIRE_THROWS_AS(standard.transform(batch), std::runtime_error);
+  minMax.fit(empty);
+  REQUIRE_THROWS_AS(minMax.transform(batch), std::runtime_error);
+}
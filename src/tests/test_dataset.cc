@@ -0,0 +1,121 @@
+#include "datautils/dataset.h"
+#include "network/loss_functions.h"
+#include "network/trainer.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+using namespace dmlfs;
+
+namespace {
+
+std::string temp_path(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("A written dataset maps back as zero-copy views", "[Dataset]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  const std::string path = temp_path("dmlfs_test_dataset.bin");
+  Matrix features = Matrix::Random(5, 37);
+  Matrix labels = Matrix::Random(2, 37);
+  write_dataset<TestType>(path, features, labels);
+
+  MappedDataset<TestType> dataset(path);
+
+  REQUIRE(dataset.size() == 37);
+  REQUIRE(dataset.featureCount() == 5);
+  REQUIRE(dataset.labelCount() == 2);
+  REQUIRE(dataset.features() == features);
+  REQUIRE(dataset.labels() == labels);
+  REQUIRE(dataset.featureBatch(10, 8) == features.middleCols(10, 8));
+  REQUIRE(dataset.labelBatch(30, 7) == labels.middleCols(30, 7));
+  REQUIRE(dataset.featureBatch(10, 8).data() == dataset.features().data() + 10 * 5);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(dataset.features().data()) % 64 == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(dataset.labels().data()) % 64 == 0);
+
+  using Other = std::conditional_t<std::is_same_v<TestType, float>, double, float>;
+  REQUIRE_THROWS_AS(MappedDataset<Other>(path), std::runtime_error);
+
+  std::filesystem::resize_file(path, 200);
+  REQUIRE_THROWS_AS(MappedDataset<TestType>(path), std::runtime_error);
+
+  std::filesystem::remove(path);
+}
+
+TEMPLATE_TEST_CASE("Strided views are written as their own contiguous columns", "[Dataset]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  const std::string path = temp_path("dmlfs_test_dataset_view.bin");
+  Matrix all = Matrix::Random(9, 23);
+  write_dataset<TestType>(path, all.topRows(4), all.middleRows(6, 2));
+
+  MappedDataset<TestType> dataset(path);
+
+  REQUIRE(dataset.featureCount() == 4);
+  REQUIRE(dataset.labelCount() == 2);
+  REQUIRE(dataset.features() == all.topRows(4));
+  REQUIRE(dataset.labels() == all.middleRows(6, 2));
+
+  std::filesystem::remove(path);
+}
+
+TEST_CASE("A CSV converted to a dataset trains like the parsed CSV", "[Dataset]") {
+  using Matrix = Eigen::MatrixXd;
+
+  const std::string csvPath = temp_path("dmlfs_test_dataset.csv");
+  const std::string datasetPath = temp_path("dmlfs_test_dataset_from_csv.bin");
+  {
+    std::ofstream csv{csvPath};
+    csv << "x0,x1,x2,y0,y1\n";
+    Matrix values = Matrix::Random(3, 64);
+    for (Eigen::Index j = 0; j < values.cols(); ++j) {
+      csv << values(0, j) << ',' << values(1, j) << ',' << values(2, j) << ','
+          << values(0, j) - values(1, j) << ',' << values(2, j) << '\n';
+    }
+  }
+
+  convert_csv_to_dataset<double>(csvPath, datasetPath, {3, 4});
+  NumericCsv<double> parsed = read_numeric_csv<double>(csvPath, {3, 4});
+  MappedDataset<double> dataset(datasetPath);
+  REQUIRE(dataset.features() == parsed.features);
+  REQUIRE(dataset.labels() == parsed.labels);
+
+  Matrix w1 = Matrix::Random(6, 3) * 0.5;
+  Matrix w2 = Matrix::Random(2, 6) * 0.5;
+  auto make_network = [&]() {
+    Network<double> network;
+    network.addLayer(std::make_shared<Layer<double>>(w1, Matrix::Zero(6, 1), Activation<>::Type::TANH))
+           .addLayer(std::make_shared<Layer<double>>(w2, Matrix::Zero(2, 1), Activation<>::Type::NONE));
+    return network;
+  };
+
+  Network<double> fromCsv = make_network();
+  SGD<double> csvOptimizer(0.05);
+  Trainer<double> csvTrainer(fromCsv, csvOptimizer, meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                             16, Trainer<double>::Shuffle::BATCHES, 1);
+  csvTrainer.train(parsed.features, parsed.labels, 3);
+
+  Network<double> fromDataset = make_network();
+  SGD<double> datasetOptimizer(0.05);
+  Trainer<double> datasetTrainer(fromDataset, datasetOptimizer, meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                 16, Trainer<double>::Shuffle::BATCHES, 1);
+  datasetTrainer.train(dataset.features(), dataset.labels(), 3);
+
+  REQUIRE(fromDataset.parameters() == fromCsv.parameters());
+
+  std::filesystem::remove(csvPath);
+  std::filesystem::remove(datasetPath);
+}
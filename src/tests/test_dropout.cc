@@ -0,0 +1,49 @@
+#include "network/dropout.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace dmlfs;
+
+TEMPLATE_TEST_CASE("Dropout zeroes the requested fraction and rescales the rest", "[Dropout]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  Dropout<TestType> layer(100, TestType(0.3), 42);
+  Matrix input = Matrix::Ones(100, 1000);
+
+  const Matrix output = layer.forward(input);
+  const Eigen::Index kept = (output.array() != 0).count();
+  REQUIRE(std::abs(static_cast<double>(kept) / output.size() - 0.7) < 0.01);
+  REQUIRE(((output.array() == 0) || (output.array() - TestType(1 / 0.7)).abs() < TestType(1e-5)).all());
+
+  // The gradients are masked by the same bits.
+  const Matrix dInput = layer.backward(Matrix::Constant(100, 1000, 2));
+  REQUIRE(((dInput.array() == 0) == (output.array() == 0)).all());
+  REQUIRE(dInput.isApprox(2 * output));
+
+  // Every pass draws a new mask.
+  REQUIRE((layer.forward(input).array() != output.array()).any());
+
+  // Inference is the identity.
+  Matrix predicted(100, 1000);
+  layer.predict(input, predicted);
+  REQUIRE(predicted == input);
+}
+
+TEST_CASE("Dropout handles sizes that are not a multiple of 64 and a zero rate", "[Dropout]") {
+  Dropout<double> none(7, 0.0);
+  Eigen::MatrixXd input = Eigen::MatrixXd::Random(7, 5);
+  REQUIRE(none.forward(input) == input);
+
+  Dropout<double> layer(7, 0.5);
+  const Eigen::MatrixXd& output = layer.forward(input);
+  REQUIRE(((output.array() == 0) || (output.array() == 2 * input.array())).all());
+
+  REQUIRE_THROWS_AS(Dropout<double>(7, 1.0), std::invalid_argument);
+  REQUIRE_THROWS_AS(Dropout<double>(7, -0.1), std::invalid_argument);
+}
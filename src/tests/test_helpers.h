@@ -0,0 +1,59 @@
+/**
+ * @file test_helpers.h
+ *
+ * @brief Fixture factories shared by the tests.
+ */
+
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include "network/network.h"
+
+#include "Eigen/Dense"
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace dmlfs {
+
+/**
+ * @brief Two-layer network with the given weights and zero biases
+ * @param w1 Weights of the hidden layer, with a tanh activation
+ * @param w2 Weights of the output layer, without activation
+ */
+template <typename Scalar>
+Network<Scalar> make_network(const Eigen::MatrixX<Scalar>& w1, const Eigen::MatrixX<Scalar>& w2) {
+  using Matrix = Eigen::MatrixX<Scalar>;
+  Network<Scalar> network;
+  network.addLayer(std::make_shared<Layer<Scalar>>(w1, Matrix::Zero(w1.rows(), 1), Activation<>::Type::TANH))
+         .addLayer(std::make_shared<Layer<Scalar>>(w2, Matrix::Zero(w2.rows(), 1), Activation<>::Type::NONE));
+  return network;
+}
+
+/**
+ * @brief Multilayer perceptron of Xavier-initialized dense layers
+ * @param sizes Number of inputs, then the number of outputs of each layer
+ * @param activations Activation function of each layer
+ * @param biasScale Magnitude of the uniformly random biases, zero biases by default
+ */
+template <typename Scalar>
+Network<Scalar> make_mlp(const std::vector<int>& sizes,
+                         const std::vector<ActivationBase::Type>& activations,
+                         Scalar biasScale = 0) {
+  assert(sizes.size() == activations.size() + 1);
+  Network<Scalar> network;
+  for (std::size_t i = 0; i < activations.size(); ++i) {
+    network.addLayer(std::make_shared<Layer<Scalar>>(sizes[i], sizes[i + 1], Initializer<>::Type::XAVIER, activations[i]));
+  }
+  if (biasScale != 0) {
+    for (auto& layer : network.layers()) {
+      layer->updateBiases(Eigen::MatrixX<Scalar>::Random(layer->outputSize(), 1) * biasScale);
+    }
+  }
+  return network;
+}
+
+}  // namespace dmlfs
+
+#endif /* TEST_HELPERS_H */
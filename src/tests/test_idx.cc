@@ -0,0 +1,110 @@
+#include "datautils/idx.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+std::string write_idx(const std::string& name, const std::vector<std::uint32_t>& dims, const std::vector<std::uint8_t>& values) {
+  const std::string path = (std::filesystem::temp_directory_path() / name).string();
+  std::ofstream file{path, std::ios::binary};
+  file.put(0).put(0).put(0x08).put(static_cast<char>(dims.size()));
+  for (std::uint32_t dim : dims) {
+    file.put(static_cast<char>(dim >> 24)).put(static_cast<char>(dim >> 16)).put(static_cast<char>(dim >> 8)).put(static_cast<char>(dim));
+  }
+  file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size()));
+  return path;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("IDX dataset keeps bytes and normalizes per batch", "[IDX]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  // Five 2x3 images whose pixels encode their position.
+  std::vector<std::uint8_t> pixels;
+  for (int n = 0; n < 5; ++n) {
+    for (int p = 0; p < 6; ++p) {
+      pixels.push_back(static_cast<std::uint8_t>(50 * n + p));
+    }
+  }
+  const std::string images = write_idx("dmlfs_test_images.idx", {5, 2, 3}, pixels);
+  const std::string labels = write_idx("dmlfs_test_labels.idx", {5}, {3, 0, 2, 2, 1});
+
+  IdxDataset<TestType> dataset(images, labels, 4, TestType(0.5), TestType(0.25));
+
+  REQUIRE(dataset.size() == 5);
+  REQUIRE(dataset.pixelCount() == 6);
+  REQUIRE(dataset.pixels()(4, 3) == 154);
+
+  Matrix batch;
+  dataset.imageBatch(1, 3, batch);
+  REQUIRE(batch.rows() == 6);
+  REQUIRE(batch.cols() == 3);
+  for (Eigen::Index j = 0; j < 3; ++j) {
+    for (Eigen::Index i = 0; i < 6; ++i) {
+      const TestType expected = (TestType(dataset.pixels()(i, j + 1)) / 255 - TestType(0.5)) / TestType(0.25);
+      REQUIRE(std::abs(batch(i, j) - expected) < 1e-5);
+    }
+  }
+
+  Matrix gathered;
+  dataset.imageBatch(std::vector<Eigen::Index>{3, 1, 2}, gathered);
+  REQUIRE(gathered.col(0) == batch.col(2));
+  REQUIRE(gathered.col(1) == batch.col(0));
+
+  Matrix oneHot;
+  dataset.labelBatch(0, 5, oneHot);
+  Matrix expectedOneHot = Matrix::Zero(4, 5);
+  expectedOneHot(3, 0) = expectedOneHot(0, 1) = expectedOneHot(2, 2) = expectedOneHot(2, 3) = expectedOneHot(1, 4) = 1;
+  REQUIRE(oneHot == expectedOneHot);
+
+  dataset.labelBatch(std::vector<Eigen::Index>{4, 0}, oneHot);
+  REQUIRE(oneHot.col(0) == expectedOneHot.col(4));
+  REQUIRE(oneHot.col(1) == expectedOneHot.col(0));
+
+  std::filesystem::remove(images);
+  std::filesystem::remove(labels);
+}
+
+TEST_CASE("IDX dataset rejects mismatched or invalid files", "[IDX]") {
+  const std::string images = write_idx("dmlfs_test_bad_images.idx", {2, 1, 2}, {1, 2, 3, 4});
+  const std::string labels = write_idx("dmlfs_test_bad_labels.idx", {3}, {0, 1, 2});
+  const std::string outOfRange = write_idx("dmlfs_test_bad_classes.idx", {2}, {0, 12});
+  const std::string truncated = write_idx("dmlfs_test_truncated.idx", {4, 1, 2}, {1, 2, 3});
+
+  REQUIRE_THROWS_AS(IdxDataset<double>(images, labels), std::runtime_error);
+  REQUIRE_THROWS_AS(IdxDataset<double>(images, outOfRange), std::runtime_error);
+  REQUIRE_THROWS_AS(IdxFile(truncated), std::runtime_error);
+
+  for (const auto& path : {images, labels, outOfRange, truncated}) {
+    std::filesystem::remove(path);
+  }
+}
+
+TEST_CASE("IDX files reject headers whose dimensions overflow or are empty", "[IDX]") {
+  // 2^16 * 2^24 * 2^24 wraps a 64-bit product around to zero.
+  const std::string overflowing = write_idx("dmlfs_test_overflow.idx", {65536, 1u << 24, 1u << 24}, {1, 2, 3});
+  const std::string empty = write_idx("dmlfs_test_empty_images.idx", {2, 0, 3}, {});
+  const std::string labels = write_idx("dmlfs_test_empty_labels.idx", {2}, {0, 1});
+
+  REQUIRE_THROWS_AS(IdxFile(overflowing), std::runtime_error);
+  REQUIRE_NOTHROW(IdxFile(empty));
+  REQUIRE_THROWS_AS(IdxDataset<float>(empty, labels), std::runtime_error);
+
+  for (const auto& path : {overflowing, empty, labels}) {
+    std::filesystem::remove(path);
+  }
+}
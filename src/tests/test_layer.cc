@@ -5,6 +5,7 @@
 #include "Eigen/Dense"
 
 #include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 
 using namespace dmlfs;
@@ -13,7 +14,7 @@ using namespace Catch::Matchers;
 TEST_CASE("Layer initialization produces correct dimensions", "[Layer]") {
   int inputSize = 5;
   int outputSize = 3;
-  Layer layer(inputSize, outputSize, Initializer::Type::RANDOM);
+  Layer layer(inputSize, outputSize, Initializer<>::Type::RANDOM);
 
   SECTION("Weights and biases dimensions are correct") {
     REQUIRE(layer.weights().rows() == outputSize);
@@ -26,7 +27,7 @@ TEST_CASE("Layer initialization produces correct dimensions", "[Layer]") {
 TEST_CASE("Xavier initializer produces weights with correct standard deviation", "[Layer]") {
   int inputSize = 10;
   int outputSize = 5;
-  Layer layer(inputSize, outputSize, Initializer::Type::XAVIER);
+  Layer layer(inputSize, outputSize, Initializer<>::Type::XAVIER);
 
   double stdDev = std::sqrt(2.0 / (inputSize + outputSize));
   Eigen::MatrixXd weights = layer.weights();
@@ -41,7 +42,7 @@ TEST_CASE("Xavier initializer produces weights with correct standard deviation",
 
   inputSize = 100;
   outputSize = 50;
-  layer = Layer(inputSize, outputSize, Initializer::Type::XAVIER);
+  layer = Layer(inputSize, outputSize, Initializer<>::Type::XAVIER);
 
   stdDev = std::sqrt(2.0 / (inputSize + outputSize));
   weights = layer.weights();
@@ -63,7 +64,7 @@ TEST_CASE("Can Initialize layer with pre-defined weights and biases", "[Layer]")
              11.0, 12.0, 13.0, 14.0, 15.0;
   biases << 1.0, 2.0, 3.0;
 
-  Layer layer(weights, biases, Activation::Type::NONE);
+  Layer layer(weights, biases, Activation<>::Type::NONE);
 
   SECTION("Weights and biases are set correctly") {
     REQUIRE(layer.weights().isApprox(weights));
@@ -74,7 +75,7 @@ TEST_CASE("Can Initialize layer with pre-defined weights and biases", "[Layer]")
 TEST_CASE("Layer forward propagation has correct dimension and basic properties", "[Layer]") {
   int inputSize = 5;
   int outputSize = 3;
-  Layer layer(inputSize, outputSize, Initializer::Type::RANDOM);
+  Layer layer(inputSize, outputSize, Initializer<>::Type::RANDOM);
 
   Eigen::MatrixXd input = Eigen::MatrixXd::Random(inputSize, 1);
   Eigen::MatrixXd output = layer.forward(input);
@@ -100,7 +101,7 @@ TEST_CASE("Layer forward propagation has correct dimension and basic properties"
 TEST_CASE("Layer forward propagation with zero initializer produces zero output", "[Layer]") {
   int inputSize = 5;
   int outputSize = 3;
-  Layer layer(inputSize, outputSize, Initializer::Type::ZERO);
+  Layer layer(inputSize, outputSize, Initializer<>::Type::ZERO);
 
   Eigen::MatrixXd input = Eigen::MatrixXd::Random(inputSize, 1);
   Eigen::MatrixXd output = layer.forward(input);
@@ -111,7 +112,7 @@ TEST_CASE("Layer forward propagation with zero initializer produces zero output"
 TEST_CASE("Forward propagation with a layer with no activation function is equivalent to a linear transformation", "[Layer]") {
   int inputSize = 5;
   int outputSize = 3;
-  Layer layer(inputSize, outputSize, Initializer::Type::RANDOM, Activation::Type::NONE);
+  Layer layer(inputSize, outputSize, Initializer<>::Type::RANDOM, Activation<>::Type::NONE);
 
   Eigen::MatrixXd input = Eigen::MatrixXd::Random(inputSize, 1);
   Eigen::MatrixXd output = layer.forward(input);
@@ -121,6 +122,63 @@ TEST_CASE("Forward propagation with a layer with no activation function is equiv
   REQUIRE(output.isApprox(expectedOutput));
 }
 
+TEMPLATE_TEST_CASE("Layer forward and backward propagation agree across scalar types", "[Layer]", float, double) {
+  using Matrix = typename Layer<TestType>::Matrix;
+
+  Eigen::MatrixXd weights(2, 3);
+  weights << 0.5, -0.5, 0.25,
+             1.0, 0.0, -0.75;
+  Eigen::MatrixXd biases(2, 1);
+  biases << 0.1,
+            -0.1;
+  Eigen::MatrixXd input(3, 2);
+  input << 1.0, 0.5,
+           -1.0, 0.25,
+           0.5, -2.0;
+  Eigen::MatrixXd dOutput(2, 2);
+  dOutput << 0.5, -0.25,
+             -0.5, 1.0;
+
+  Layer<double> reference(weights, biases, Activation<>::Type::TANH);
+  Layer<TestType> layer(weights.cast<TestType>(), biases.cast<TestType>(), Activation<>::Type::TANH);
+
+  Matrix output = layer.forward(input.cast<TestType>());
+  Matrix dInput = layer.backward(dOutput.cast<TestType>());
+
+  Eigen::MatrixXd expectedOutput = reference.forward(input);
+  Eigen::MatrixXd expectedDInput = reference.backward(dOutput);
+
+  const double tolerance = std::is_same_v<TestType, float> ? 1e-5 : 1e-12;
+  REQUIRE(output.template cast<double>().isApprox(expectedOutput, tolerance));
+  REQUIRE(dInput.template cast<double>().isApprox(expectedDInput, tolerance));
+  REQUIRE(layer.weights_grad().template cast<double>().isApprox(reference.weights_grad(), tolerance));
+  REQUIRE(layer.biases_grad().template cast<double>().isApprox(reference.biases_grad(), tolerance));
+}
+
+TEMPLATE_TEST_CASE("Fused activation kernels agree with the Activation functors", "[Layer]", float, double) {
+  using Matrix = typename Layer<TestType>::Matrix;
+  using Type = typename Activation<TestType>::Type;
+
+  Matrix z = Matrix::Random(4, 3);
+  Matrix biases = Matrix::Random(4, 1);
+  Matrix dOutput = Matrix::Random(4, 3);
+  Matrix preActivation = z.colwise() + biases.col(0);
+
+  for (Type type : {Type::NONE, Type::RELU, Type::SIGMOID, Type::TANH}) {
+    std::unique_ptr<Activation<TestType>> activation;
+    Activation<TestType>::set(type, activation);
+
+    Matrix activated = z;
+    FusedActivation<TestType>::forward(type, activated, biases);
+    Matrix dZ(4, 3);
+    FusedActivation<TestType>::backward(type, activated, dOutput, dZ);
+
+    Matrix expectedDZ = dOutput.array() * activation->derivative(preActivation).array();
+    REQUIRE(activated.isApprox((*activation)(preActivation)));
+    REQUIRE(dZ.isApprox(expectedDZ));
+  }
+}
+
 TEST_CASE("Backward propagation updates weights and biases correctly in simple case", "[Layer]") {
   int inputSize = 2;
   int outputSize = 1;
@@ -130,7 +188,7 @@ TEST_CASE("Backward propagation updates weights and biases correctly in simple c
   Eigen::MatrixXd biases(2, 1);
   biases << 0.1,
             -0.1;
-  Layer layer(weights, biases, Activation::Type::RELU);
+  Layer layer(weights, biases, Activation<>::Type::RELU);
 
   Eigen::MatrixXd input(2, 1);
   input << 1.0,
@@ -0,0 +1,80 @@
+#include "network/loss_functions.h"
+#include "network/trainer.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cmath>
+#include <memory>
+
+using namespace dmlfs;
+
+TEMPLATE_TEST_CASE("Fused softmax cross entropy matches softmax followed by cross entropy", "[Loss]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  const Matrix logits = Matrix::Random(7, 20) * 3;
+  Matrix y = Matrix::Zero(7, 20);
+  for (Eigen::Index j = 0; j < y.cols(); ++j) {
+    y((j * 3) % 7, j) = 1;
+  }
+
+  Matrix probabilities = logits;
+  softmax<TestType>(probabilities);
+  REQUIRE(probabilities.colwise().sum().isOnes(TestType(1e-5)));
+  const Matrix expected = (logits.array().exp().rowwise() / logits.array().exp().colwise().sum()).matrix();
+  REQUIRE(probabilities.isApprox(expected, TestType(1e-5)));
+
+  Matrix gradient;
+  const TestType loss = softmaxCrossEntropy<TestType>(y, logits, gradient);
+  REQUIRE(std::abs(loss - crossEntropy<TestType>(y, probabilities)) < TestType(1e-5));
+  REQUIRE(gradient.isApprox(probabilities - y, TestType(1e-5)));
+}
+
+TEST_CASE("Fused softmax cross entropy is stable for large logits", "[Loss]") {
+  Eigen::MatrixXf logits(3, 2);
+  logits << 1000, -1000,
+            0,    -1000,
+            -1000, -1000;
+  Eigen::MatrixXf y(3, 2);
+  y << 1, 0,
+       0, 1,
+       0, 0;
+
+  Eigen::MatrixXf gradient;
+  const float loss = softmaxCrossEntropy<float>(y, logits, gradient);
+
+  // First sample: certain and right. Second sample: uniform over 3 classes.
+  REQUIRE(std::isfinite(loss));
+  REQUIRE(std::abs(loss - std::log(3.0f) / 2) < 1e-5f);
+  REQUIRE(gradient.allFinite());
+  REQUIRE(gradient.col(0).isZero(1e-6f));
+  REQUIRE(std::abs(gradient(1, 1) - (1.0f / 3 - 1)) < 1e-5f);
+}
+
+TEST_CASE("The trainer accepts a fused loss", "[Loss]") {
+  using Matrix = Eigen::MatrixXd;
+  using Shuffle = Trainer<double>::Shuffle;
+
+  // Three linearly separable classes.
+  Matrix features = Matrix::Random(2, 300);
+  Matrix labels = Matrix::Zero(3, 300);
+  for (Eigen::Index j = 0; j < features.cols(); ++j) {
+    const int c = static_cast<int>(j % 3);
+    features(c % 2, j) += c == 2 ? -3 : 3;
+    labels(c, j) = 1;
+  }
+
+  for (int nThreads : {1, 3}) {
+    Network<double> network;
+    network.addLayer(std::make_shared<Layer<double>>(2, 8, Initializer<>::Type::XAVIER, Activation<>::Type::TANH))
+           .addLayer(std::make_shared<Layer<double>>(8, 3, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+    SGD<double> optimizer(0.01);
+    Trainer<double> trainer(network, optimizer, softmaxCrossEntropy<double>, 32, Shuffle::SAMPLES, 1);
+    trainer.setNumThreads(nThreads);
+
+    const std::vector<EpochStats> stats = trainer.train(features, labels, 20);
+    REQUIRE(stats.back().loss < 0.1 * stats.front().loss);
+  }
+}
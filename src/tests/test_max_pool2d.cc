@@ -0,0 +1,106 @@
+#include "network/conv2d.h"
+#include "network/dropout.h"
+#include "network/max_pool2d.h"
+#include "network/network.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace dmlfs;
+
+TEMPLATE_TEST_CASE("MaxPool2D takes the maximum of each window and routes gradients to it", "[MaxPool2D]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  const int channels = 3, height = 5, width = 6, kernel = 2;
+  MaxPool2D<TestType> layer(channels, height, width, kernel);
+  REQUIRE(layer.outputHeight() == 2);
+  REQUIRE(layer.outputWidth() == 3);
+  REQUIRE(layer.parameterCount() == 0);
+
+  Matrix input = Matrix::Random(layer.inputSize(), 4);
+  Matrix expected(layer.outputSize(), 4);
+  Matrix expectedGrad = Matrix::Zero(layer.inputSize(), 4);
+  Matrix dOutput = Matrix::Random(layer.outputSize(), 4);
+
+  for (Eigen::Index n = 0; n < input.cols(); ++n) {
+    for (int oy = 0; oy < 2; ++oy) {
+      for (int ox = 0; ox < 3; ++ox) {
+        for (int c = 0; c < channels; ++c) {
+          Eigen::Index best = -1;
+          for (int ky = 0; ky < kernel; ++ky) {
+            for (int kx = 0; kx < kernel; ++kx) {
+              const Eigen::Index i = ((oy * kernel + ky) * width + ox * kernel + kx) * channels + c;
+              if (best < 0 || input(i, n) > input(best, n)) {
+                best = i;
+              }
+            }
+          }
+          const Eigen::Index o = (oy * 3 + ox) * channels + c;
+          expected(o, n) = input(best, n);
+          expectedGrad(best, n) += dOutput(o, n);
+        }
+      }
+    }
+  }
+
+  REQUIRE(layer.forward(input) == expected);
+  REQUIRE(layer.backward(dOutput) == expectedGrad);
+
+  Matrix output(layer.outputSize(), 4);
+  layer.predict(input, output);
+  REQUIRE(output == expected);
+}
+
+TEST_CASE("MaxPool2D supports overlapping windows", "[MaxPool2D]") {
+  using Matrix = Eigen::MatrixXd;
+
+  // A single peak is the maximum of every 3x3 window covering it.
+  MaxPool2D<double> layer(1, 5, 5, 3, 1);
+  Matrix input = Matrix::Zero(25, 1);
+  input(12) = 1;
+
+  REQUIRE(layer.forward(input).isOnes());
+  const Matrix& dInput = layer.backward(Matrix::Ones(9, 1));
+  REQUIRE(dInput(12) == 9);
+  REQUIRE(dInput.sum() == 9);
+
+  REQUIRE_THROWS_AS(MaxPool2D<double>(1, 4, 4, 5), std::invalid_argument);
+  REQUIRE_THROWS_AS(MaxPool2D<double>(1, 32, 32, 17), std::invalid_argument);
+}
+
+TEST_CASE("The mnist_conv architecture trains natively", "[MaxPool2D]") {
+  using Matrix = Eigen::MatrixXf;
+  using Init = Initializer<>::Type;
+  using Act = Activation<>::Type;
+
+  // ReLU commutes with max pooling, so it can be fused into the convolutions.
+  Network<float> network;
+  network.addLayer(std::make_shared<Conv2D<float>>(1, 28, 28, 10, 5, 1, 0, Init::XAVIER, Act::RELU))
+         .addLayer(std::make_shared<MaxPool2D<float>>(10, 24, 24, 2))
+         .addLayer(std::make_shared<Conv2D<float>>(10, 12, 12, 20, 5, 1, 0, Init::XAVIER, Act::RELU))
+         .addLayer(std::make_shared<Dropout<float>>(8 * 8 * 20, 0.5f, 1))
+         .addLayer(std::make_shared<MaxPool2D<float>>(20, 8, 8, 2))
+         .addLayer(std::make_shared<Layer<float>>(320, 50, Init::XAVIER, Act::RELU))
+         .addLayer(std::make_shared<Dropout<float>>(50, 0.5f, 2))
+         .addLayer(std::make_shared<Layer<float>>(50, 10, Init::XAVIER, Act::NONE));
+
+  REQUIRE(network.parameters().size() >= 10 * 26 + 20 * 251 + 50 * 321 + 10 * 51);
+
+  Matrix features = Matrix::Random(784, 8);
+  Matrix labels = Matrix::Random(10, 8);
+
+  const Matrix& output = network.forward(features);
+  REQUIRE(output.rows() == 10);
+  const Matrix& dInput = network.backward(output - labels);
+  REQUIRE(dInput.rows() == 784);
+  REQUIRE(network.gradients().allFinite());
+
+  // Inference skips the dropout, so it is deterministic.
+  const Matrix first = network.predict(features);
+  REQUIRE(network.predict(features) == first);
+}
@@ -0,0 +1,268 @@
+#define DMLFS_ALLOCATION_COUNTER_IMPLEMENTATION
+#include "AllocationCounter.h"
+
+#include "network/network.h"
+#include "network/optimizer.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+const std::vector<int> kSizes = {8, 32, 16, 4};
+const std::vector<ActivationBase::Type> kActivations = {Activation<>::Type::RELU, Activation<>::Type::TANH, Activation<>::Type::SIGMOID};
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Network forward matches chaining the layers by hand", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  Matrix input = Matrix::Random(8, 5);
+
+  Matrix expected = input;
+  for (auto& layer : network.layers()) {
+    expected = Matrix(layer->forward(expected));
+  }
+
+  Matrix output = network.forward(input);
+
+  REQUIRE(output.rows() == 4);
+  REQUIRE(output.cols() == 5);
+  REQUIRE(output.isApprox(expected));
+}
+
+TEMPLATE_TEST_CASE("Steady-state training step makes no heap allocations", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  SGD<TestType> optimizer(0.1);
+
+  Matrix input = Matrix::Random(8, 16);
+  Matrix target = Matrix::Random(4, 16);
+  Matrix dLoss(4, 16);
+
+  auto step = [&]() {
+    const Matrix& output = network.forward(input);
+    dLoss.noalias() = output - target;
+    network.backward(dLoss);
+    optimizer.update(network);
+  };
+
+  // The first step sizes the workspaces.
+  step();
+
+  SECTION("The counter sees a known allocation") {
+    std::size_t allocations;
+    {
+      AllocationCounter counter;
+      int* volatile known = new int(0);
+      delete known;
+      allocations = counter.count();
+    }
+
+    REQUIRE(allocations > 0);
+  }
+
+  SECTION("Further steps do not allocate") {
+    std::size_t allocations;
+    {
+      AllocationCounter counter;
+      for (int i = 0; i < 5; ++i) {
+        step();
+      }
+      allocations = counter.count();
+    }
+
+    REQUIRE(allocations == 0);
+  }
+}
+
+TEMPLATE_TEST_CASE("Network predict matches forward without allocating", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  Matrix input = Matrix::Random(8, 12);
+
+  Matrix expected = network.forward(input);
+  Matrix predicted = network.predict(input);
+
+  REQUIRE(predicted.rows() == 4);
+  REQUIRE(predicted.cols() == 12);
+  REQUIRE(predicted.isApprox(expected));
+
+  SECTION("Predict accepts a block of columns as input") {
+    Matrix blockPrediction = network.predict(input.middleCols(3, 4));
+    REQUIRE(blockPrediction.isApprox(expected.middleCols(3, 4)));
+  }
+
+  SECTION("Repeated predictions do not allocate") {
+    std::size_t allocations;
+    {
+      AllocationCounter counter;
+      for (int i = 0; i < 5; ++i) {
+        network.predict(input);
+      }
+      allocations = counter.count();
+    }
+    REQUIRE(allocations == 0);
+  }
+}
+
+TEMPLATE_TEST_CASE("Concurrent predictions share one network", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  const Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  constexpr int nThreads = 4;
+
+  std::vector<Matrix> inputs;
+  std::vector<Matrix> expected;
+  for (int t = 0; t < nThreads; ++t) {
+    inputs.push_back(Matrix::Random(8, 7 + t));
+    InferenceContext<TestType> context;
+    expected.push_back(network.predict(inputs.back(), context));
+  }
+
+  std::vector<int> mismatches(nThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      InferenceContext<TestType> context;
+      for (int i = 0; i < 200; ++i) {
+        if (!network.predict(inputs[t], context).isApprox(expected[t])) {
+          ++mismatches[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < nThreads; ++t) {
+    REQUIRE(mismatches[t] == 0);
+  }
+}
+
+TEMPLATE_TEST_CASE("Layers view the network's flat parameter and gradient arenas", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  Layer<TestType> standalone(4, 3, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+  Matrix weights = standalone.weights();
+
+  Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  network.addLayer(std::make_shared<Layer<TestType>>(standalone));
+
+  const auto& parameters = network.parameters();
+  const auto& gradients = network.gradients();
+
+  SECTION("Each layer's parameters live in its span of the arena") {
+    for (std::size_t i = 0; i < network.layers().size(); ++i) {
+      const auto& layer = network.layers()[i];
+      const Eigen::Index offset = network.offsets()[i];
+      REQUIRE(layer->weights().data() == parameters.data() + offset);
+      REQUIRE(layer->biases().data() == parameters.data() + offset + layer->weights().size());
+      REQUIRE(layer->weights_grad().data() == gradients.data() + offset);
+      REQUIRE((offset * sizeof(TestType)) % 64 == 0);
+    }
+    REQUIRE(network.layers().back()->weights().isApprox(weights));
+  }
+
+  SECTION("A gradient step on the arena updates every layer") {
+    Matrix input = Matrix::Random(8, 6);
+    const Matrix& output = network.forward(input);
+    network.backward(output);
+
+    std::vector<Matrix> expected;
+    for (const auto& layer : network.layers()) {
+      expected.push_back(layer->weights() - TestType(0.1) * layer->weights_grad());
+    }
+
+    SGD<TestType> optimizer(0.1);
+    optimizer.update(network);
+
+    for (std::size_t i = 0; i < network.layers().size(); ++i) {
+      REQUIRE(network.layers()[i]->weights().isApprox(expected[i]));
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("A saved network loads back as a view of the model file", "[Network]", float, double) {
+  using Matrix = typename Network<TestType>::Matrix;
+
+  const std::string path = (std::filesystem::temp_directory_path() / "dmlfs_test_model.bin").string();
+  Network<TestType> network = make_mlp<TestType>(kSizes, kActivations);
+  network.save(path);
+
+  Matrix input = Matrix::Random(8, 5);
+  Matrix expected = network.predict(input);
+
+  SECTION("The loaded network has the same layers and predictions") {
+    Network<TestType> loaded = Network<TestType>::load(path);
+
+    REQUIRE(loaded.layers().size() == network.layers().size());
+    REQUIRE(loaded.parameters() == network.parameters());
+    for (std::size_t i = 0; i < loaded.layers().size(); ++i) {
+      const auto& layer = loaded.layers()[i];
+      REQUIRE(layer->activationType() == network.layers()[i]->activationType());
+      REQUIRE(layer->weights().data() == loaded.parameters().data() + loaded.offsets()[i]);
+      REQUIRE((reinterpret_cast<std::uintptr_t>(layer->weights().data()) % 64) == 0);
+    }
+    REQUIRE(Matrix(loaded.predict(input)).isApprox(expected));
+  }
+
+  SECTION("Training a loaded network leaves the file untouched") {
+    Network<TestType> loaded = Network<TestType>::load(path);
+    SGD<TestType> optimizer(0.1);
+    const Matrix& output = loaded.forward(input);
+    loaded.backward(output);
+    optimizer.update(loaded);
+    REQUIRE(loaded.parameters() != network.parameters());
+
+    Network<TestType> reloaded = Network<TestType>::load(path);
+    REQUIRE(reloaded.parameters() == network.parameters());
+  }
+
+  SECTION("Loading with the wrong scalar type or a corrupt file throws") {
+    using Other = std::conditional_t<std::is_same_v<TestType, float>, double, float>;
+    REQUIRE_THROWS_AS(Network<Other>::load(path), std::runtime_error);
+
+    std::filesystem::resize_file(path, 100);
+    REQUIRE_THROWS_AS(Network<TestType>::load(path), std::runtime_error);
+  }
+
+  SECTION("Loading rejects layer records with oversized or misaligned layers") {
+    // The layer table follows the 64-byte header, 32 bytes per layer:
+    // input size, output size and arena offset, then the activation.
+    auto patch = [&](std::streamoff position, std::uint64_t value) {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(position);
+      file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    // 2^63 outputs of 2 coefficients each would wrap around to an empty layer.
+    patch(64 + 8, std::uint64_t{1} << 63);
+    REQUIRE_THROWS_AS(Network<TestType>::load(path), std::runtime_error);
+
+    network.save(path);
+    patch(64 + 32 + 16, static_cast<std::uint64_t>(network.offsets()[1]) + 1);
+    REQUIRE_THROWS_AS(Network<TestType>::load(path), std::runtime_error);
+  }
+
+  std::filesystem::remove(path);
+}
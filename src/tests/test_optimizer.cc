@@ -0,0 +1,114 @@
+#include "network/optimizer.h"
+#include "network/trainer.h"
+#include "network/loss_functions.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <cmath>
+
+using namespace dmlfs;
+
+TEMPLATE_TEST_CASE("Fused optimizers match their textbook update rules", "[Optimizer]", float, double) {
+  using Vector = Eigen::VectorX<TestType>;
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  Network<TestType> network = make_network<TestType>(Matrix::Random(5, 3), Matrix::Random(2, 5));
+  const Vector initial = network.parameters();
+  const TestType lr = 0.01;
+  const TestType tolerance = std::is_same_v<TestType, float> ? 1e-5 : 1e-12;
+
+  std::vector<Vector> gradients;
+  for (int t = 0; t < 3; ++t) {
+    gradients.push_back(Vector::Random(initial.size()));
+  }
+
+  SECTION("Momentum") {
+    Momentum<TestType> optimizer(lr, 0.9);
+    Vector expected = initial;
+    Vector velocity = Vector::Zero(initial.size());
+    for (const Vector& g : gradients) {
+      network.gradients() = g;
+      optimizer.update(network);
+
+      velocity = TestType(0.9) * velocity + g;
+      expected -= lr * velocity;
+    }
+    REQUIRE(network.parameters().isApprox(expected, tolerance));
+  }
+
+  SECTION("Adam and AdamW") {
+    for (TestType weightDecay : {TestType(0), TestType(0.1)}) {
+      network.parameters() = initial;
+      AdamW<TestType> optimizer(lr, weightDecay);
+
+      Vector expected = initial;
+      Vector m = Vector::Zero(initial.size());
+      Vector v = Vector::Zero(initial.size());
+      for (std::size_t t = 1; t <= gradients.size(); ++t) {
+        const Vector& g = gradients[t - 1];
+        network.gradients() = g;
+        optimizer.update(network);
+
+        m = TestType(0.9) * m + TestType(0.1) * g;
+        v = TestType(0.999) * v + TestType(0.001) * g.cwiseProduct(g);
+        Vector mHat = m / (1 - std::pow(TestType(0.9), TestType(t)));
+        Vector vHat = v / (1 - std::pow(TestType(0.999), TestType(t)));
+        expected = expected - lr * weightDecay * expected
+                   - lr * mHat.cwiseQuotient((vHat.cwiseSqrt().array() + TestType(1e-8)).matrix());
+      }
+      REQUIRE(network.parameters().isApprox(expected, tolerance));
+    }
+  }
+}
+
+TEST_CASE("Adam reaches a lower loss than SGD in the same number of epochs", "[Optimizer]") {
+  using Matrix = Eigen::MatrixXd;
+  using Shuffle = Trainer<double>::Shuffle;
+
+  Matrix w1 = Matrix::Random(6, 3) * 0.5;
+  Matrix w2 = Matrix::Random(2, 6) * 0.5;
+  Matrix features = Matrix::Random(3, 200);
+  Matrix target = Matrix::Random(2, 3);
+  Matrix labels = target * features;
+
+  Network<double> sgdNetwork = make_network<double>(w1, w2);
+  SGD<double> sgd(0.01);
+  Trainer<double> sgdTrainer(sgdNetwork, sgd,
+                             meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                             16, Shuffle::SAMPLES, 3);
+  const double sgdLoss = sgdTrainer.train(features, labels, 10).back().loss;
+
+  Network<double> adamNetwork = make_network<double>(w1, w2);
+  Adam<double> adam(0.01);
+  Trainer<double> adamTrainer(adamNetwork, adam,
+                              meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                              16, Shuffle::SAMPLES, 3);
+  const double adamLoss = adamTrainer.train(features, labels, 10).back().loss;
+
+  REQUIRE(adamLoss < sgdLoss);
+}
+
+TEST_CASE("Stateful optimizers support Hogwild training", "[Optimizer]") {
+  using Matrix = Eigen::MatrixXd;
+  using Shuffle = Trainer<double>::Shuffle;
+
+  Matrix features = Matrix::Random(3, 400);
+  Matrix target = Matrix::Random(2, 3);
+  Matrix labels = target * features;
+
+  Network<double> network = make_network<double>(Matrix::Random(6, 3) * 0.5, Matrix::Random(2, 6) * 0.5);
+  Momentum<double> optimizer(0.005, 0.9);
+  Trainer<double> trainer(network, optimizer,
+                          meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                          16, Shuffle::SAMPLES, 5);
+  trainer.setMode(Trainer<double>::Mode::HOGWILD);
+  trainer.setNumThreads(4);
+
+  std::vector<EpochStats> stats = trainer.train(features, labels, 20);
+
+  REQUIRE(stats.back().loss < 0.5 * stats.front().loss);
+}
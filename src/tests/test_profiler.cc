@@ -0,0 +1,197 @@
+#include "network/optimizer.h"
+#include "network/profiler.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+/**
+ * @brief Enables the profiler for the duration of a test, starting from no events
+ */
+struct Recording {
+  Recording() {
+    Profiler::instance().clear();
+    Profiler::instance().enable();
+  }
+  ~Recording() {
+    Profiler::instance().enable(false);
+    Profiler::instance().clear();
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Profile scopes only record while the profiler is enabled", "[Profiler]") {
+  Profiler::instance().clear();
+  {
+    ProfileScope scope("work", 10, 20);
+  }
+  REQUIRE(Profiler::instance().events().empty());
+
+  Recording recording;
+  {
+    ProfileScope scope("work", 10, 20);
+  }
+  const auto events = Profiler::instance().events();
+  REQUIRE(events.size() == 1);
+  REQUIRE(std::string{events[0].phase} == "work");
+  REQUIRE(events[0].layer == -1);
+  REQUIRE(events[0].flops == 10);
+  REQUIRE(events[0].bytes == 20);
+  REQUIRE(events[0].duration >= 0);
+}
+
+TEST_CASE("Layer scopes derive their cost from the layer's shape", "[Profiler]") {
+  Recording recording;
+  const Layer<float> layer(4, 3, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+  {
+    ProfileScope scope(false, 2, layer, 5);
+  }
+  {
+    ProfileScope scope(true, 2, layer, 5);
+  }
+
+  const auto events = Profiler::instance().events();
+  REQUIRE(events.size() == 2);
+  REQUIRE(std::string{events[0].phase} == "forward");
+  REQUIRE(std::string{events[1].phase} == "backward");
+  REQUIRE(events[0].layer == 2);
+  REQUIRE(events[0].inputSize == 4);
+  REQUIRE(events[0].outputSize == 3);
+  REQUIRE(events[0].batchSize == 5);
+  // 12 weights applied to 5 samples, plus the bias and activation of 15 outputs.
+  REQUIRE(events[0].flops == 2 * 12 * 5 + 2 * 15);
+  REQUIRE(events[1].flops == 4 * 12 * 5 + 2 * 15);
+  REQUIRE(events[0].bytes == sizeof(float) * (15 + 20 + 15));
+  REQUIRE(events[1].bytes == sizeof(float) * (2 * 15 + 2 * (20 + 15)));
+}
+
+TEST_CASE("Training steps are recorded per layer when the hooks are compiled in", "[Profiler]") {
+  Network<double> network;
+  network.addLayer(std::make_shared<Layer<double>>(8, 16, Initializer<>::Type::XAVIER, Activation<>::Type::RELU))
+         .addLayer(std::make_shared<Layer<double>>(16, 4, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+  SGD<double> optimizer(0.01);
+  TrainingContext<double> context;
+  const Eigen::MatrixXd input = Eigen::MatrixXd::Random(8, 32);
+
+  Recording recording;
+  const auto& output = network.forward(input, context);
+  network.backward(Eigen::MatrixXd::Ones(output.rows(), output.cols()), context);
+  optimizer.update(network, context);
+
+  const auto events = Profiler::instance().events();
+  if constexpr (!kProfilingCompiledIn) {
+    REQUIRE(events.empty());
+    return;
+  }
+
+  REQUIRE(events.size() == 5);
+  const std::pair<std::string, int> expected[] = {{"forward", 0}, {"forward", 1}, {"backward", 1}, {"backward", 0}, {"SGD::update", -1}};
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    REQUIRE(events[i].phase == expected[i].first);
+    REQUIRE(events[i].layer == expected[i].second);
+    REQUIRE(events[i].batchSize == (events[i].layer < 0 ? 0 : 32));
+    if (i > 0) {
+      REQUIRE(events[i].start >= events[i - 1].start + events[i - 1].duration);
+    }
+  }
+  REQUIRE(events[4].flops == 2.0 * network.parameters().size());
+}
+
+TEST_CASE("Optimizer updates are recorded under the concrete optimizer's name", "[Profiler]") {
+  Network<double> network;
+  network.addLayer(std::make_shared<Layer<double>>(8, 4, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+  Adam<double> adam(0.01);
+  AdamW<double> adamw(0.01);
+  REQUIRE(std::string{adam.updatePhase()} == "Adam::update");
+  REQUIRE(std::string{adamw.updatePhase()} == "AdamW::update");
+
+  Recording recording;
+  adam.update(network);
+  adamw.update(network);
+
+  const auto events = Profiler::instance().events();
+  if constexpr (!kProfilingCompiledIn) {
+    REQUIRE(events.empty());
+    return;
+  }
+
+  REQUIRE(events.size() == 2);
+  REQUIRE(std::string{events[0].phase} == "Adam::update");
+  REQUIRE(std::string{events[1].phase} == "AdamW::update");
+}
+
+TEST_CASE("Events from each thread are kept apart", "[Profiler]") {
+  Recording recording;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 100; ++i) {
+        ProfileScope scope("work", 1, 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const auto events = Profiler::instance().events();
+  REQUIRE(events.size() == 400);
+  std::set<int> ids;
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    ids.insert(events[i].thread);
+    if (i > 0) {
+      REQUIRE(events[i].start >= events[i - 1].start);
+    }
+  }
+  REQUIRE(ids.size() == 4);
+}
+
+TEST_CASE("Profiles export as a Chrome trace and as a summary table", "[Profiler]") {
+  Recording recording;
+  const Layer<double> layer(784, 128, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+  for (int i = 0; i < 3; ++i) {
+    ProfileScope scope(false, 0, layer, 64);
+  }
+  {
+    ProfileScope scope("SGD::update", 1e5, 1e6);
+  }
+
+  const auto path = std::filesystem::temp_directory_path() / "dmlfs_profile.json";
+  Profiler::instance().writeChromeTrace(path.string());
+  std::stringstream trace;
+  trace << std::ifstream{path}.rdbuf();
+  std::filesystem::remove(path);
+
+  REQUIRE(trace.str().find("\"traceEvents\"") != std::string::npos);
+  REQUIRE(trace.str().find("\"name\": \"layer 0 forward\", \"cat\": \"forward\", \"ph\": \"X\"") != std::string::npos);
+  REQUIRE(trace.str().find("\"name\": \"SGD::update\"") != std::string::npos);
+  REQUIRE(trace.str().find("\"inputs\": 784, \"outputs\": 128, \"batch\": 64") != std::string::npos);
+
+  const std::string summary = Profiler::instance().summary();
+  REQUIRE(summary.find("GFLOP/s") != std::string::npos);
+  std::istringstream lines{summary};
+  std::string line;
+  std::getline(lines, line);
+  std::getline(lines, line);
+  REQUIRE(line.find("layer 0 forward") == 0);
+  REQUIRE(line.find("784->128") != std::string::npos);
+  REQUIRE(line.find(" 3 ") != std::string::npos);
+  std::getline(lines, line);
+  REQUIRE(line.find("SGD::update") == 0);
+
+  REQUIRE_THROWS_AS(Profiler::instance().writeChromeTrace("/nonexistent/dir/trace.json"), std::runtime_error);
+}
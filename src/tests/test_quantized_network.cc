@@ -0,0 +1,89 @@
+#include "network/conv2d.h"
+#include "network/quantized_network.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace dmlfs;
+
+TEMPLATE_TEST_CASE("Quantized inference stays close to floating point inference", "[Quantized]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  for (auto hidden : {Activation<>::Type::RELU, Activation<>::Type::TANH, Activation<>::Type::NONE}) {
+    Network<TestType> network = make_mlp<TestType>({64, 128, 64, 10}, {hidden, hidden, Activation<>::Type::NONE}, TestType(0.1));
+    const Matrix calibration = Matrix::Random(64, 256);
+    QuantizedNetwork<TestType> quantized(network, calibration);
+
+    REQUIRE(quantized.layers().size() == 3);
+    REQUIRE(quantized.layers()[0].unsignedInput == false);
+    REQUIRE(quantized.layers()[1].unsignedInput == (hidden == Activation<>::Type::RELU));
+
+    const Matrix input = Matrix::Random(64, 37);
+    const Matrix expected = network.predict(input);
+    const Matrix& output = quantized.predict(input);
+
+    REQUIRE(output.rows() == 10);
+    REQUIRE(output.cols() == 37);
+    REQUIRE((output - expected).norm() < TestType(0.05) * expected.norm());
+
+    int agreements = 0;
+    for (Eigen::Index j = 0; j < input.cols(); ++j) {
+      Eigen::Index a, b;
+      output.col(j).maxCoeff(&a);
+      expected.col(j).maxCoeff(&b);
+      agreements += a == b;
+    }
+    REQUIRE(agreements >= 33);
+  }
+}
+
+TEST_CASE("Quantized inference gives the same outputs whatever the blocking of samples and rows", "[Quantized]") {
+  // Sizes that are not multiples of the kernels' blocks of inputs, rows and samples.
+  for (auto hidden : {Activation<>::Type::RELU, Activation<>::Type::TANH}) {
+    Network<float> network = make_mlp<float>({77, 33, 7}, {hidden, Activation<>::Type::NONE}, 0.1f);
+    QuantizedNetwork<float> quantized(network, Eigen::MatrixXf::Random(77, 64));
+
+    const Eigen::MatrixXf input = Eigen::MatrixXf::Random(77, 7);
+    const Eigen::MatrixXf batch = quantized.predict(input);
+    REQUIRE((batch - network.predict(input)).norm() < 0.05f * network.predict(input).norm());
+
+    // The integer dot products are exact, so each sample alone gives the same outputs.
+    for (Eigen::Index j = 0; j < input.cols(); ++j) {
+      REQUIRE(quantized.predict(input.col(j)) == batch.col(j));
+    }
+  }
+}
+
+TEST_CASE("Quantized weights take one byte each", "[Quantized]") {
+  Network<double> network = make_mlp<double>({64, 128, 64, 10}, {Activation<>::Type::RELU, Activation<>::Type::RELU, Activation<>::Type::NONE}, 0.1);
+  QuantizedNetwork<double> quantized(network, Eigen::MatrixXd::Random(64, 16));
+
+  const std::size_t weights = 64 * 128 + 128 * 64 + 64 * 10;
+  REQUIRE(quantized.parameterBytes() < weights + 2 * (128 + 64 + 10) * sizeof(double) + 1);
+
+  for (const auto& layer : quantized.layers()) {
+    for (Eigen::Index o = 0; o < layer.outputSize; ++o) {
+      // Symmetric per-row quantization maps the largest weight of each row to +-127.
+      int largest = 0;
+      for (Eigen::Index k = 0; k < layer.inputSize; ++k) {
+        largest = std::max(largest, std::abs(static_cast<int>(layer.weights[o * layer.inputSize + k])));
+      }
+      REQUIRE(largest == 127);
+    }
+  }
+}
+
+TEST_CASE("Quantization rejects networks with non-dense layers", "[Quantized]") {
+  Network<float> network;
+  network.addLayer(std::make_shared<Conv2D<float>>(1, 6, 6, 2, 3))
+         .addLayer(std::make_shared<Layer<float>>(32, 2));
+
+  REQUIRE_THROWS_AS(QuantizedNetwork<float>(network, Eigen::MatrixXf::Random(36, 4)), std::invalid_argument);
+  REQUIRE_THROWS_AS(QuantizedNetwork<float>(Network<float>{}, Eigen::MatrixXf::Random(36, 4)), std::invalid_argument);
+}
@@ -0,0 +1,196 @@
+#include "datautils/matrix_representation.h"
+#include "network/layer.h"
+#include "network/network.h"
+#include "network/optimizer.h"
+#include "network/sparse_input_layer.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+std::vector<StructRepresentation<2, 3>> make_records(int n) {
+  // Every category of each feature appears at least once, as convert_to_matrix assumes.
+  std::mt19937 rng{1};
+  std::vector<StructRepresentation<2, 3>> records(n);
+  for (int i = 0; i < n; ++i) {
+    records[i].id = i;
+    records[i].continuous_features = {std::uniform_real_distribution<>(-1, 1)(rng), std::uniform_real_distribution<>(-1, 1)(rng)};
+    records[i].categorical_features = {i % 4, i % 7, static_cast<int>(rng() % 2)};
+  }
+  records[0].categorical_features[2] = 0;
+  records[1].categorical_features[2] = 1;
+  return records;
+}
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("Sparse input layer matches a dense layer on one-hot inputs", "[SparseInputLayer]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  std::vector<StructRepresentation<2, 3>> records = make_records(20);
+  Matrix dense = convert_to_matrix(records).template cast<TestType>();
+  SparseInput<TestType> sparse = convert_to_sparse_input<TestType>(records);
+
+  REQUIRE(sparse.categoryCount == 4 + 7 + 2);
+  REQUIRE(dense.rows() == 2 + sparse.categoryCount);
+
+  SparseInputLayer<TestType> layer(2, sparse.categoryCount, 5, Initializer<>::Type::XAVIER, Activation<>::Type::TANH);
+  Matrix weights(5, dense.rows());
+  weights << layer.weights(), layer.embeddings();
+  Layer<TestType> reference(weights, layer.biases(), Activation<>::Type::TANH);
+
+  // Use the first 5 samples only, so that some categories go untouched.
+  const Matrix& output = layer.forward(sparse.continuous.leftCols(5), sparse.categories.leftCols(5));
+  const Matrix& expected = reference.forward(dense.leftCols(5));
+  REQUIRE(output.isApprox(expected));
+
+  Matrix dOutput = Matrix::Random(5, 5);
+  layer.backward(dOutput);
+  reference.backward(dOutput);
+
+  REQUIRE(layer.weights_grad().isApprox(reference.weights_grad().leftCols(2)));
+  REQUIRE(layer.biases_grad().isApprox(reference.biases_grad()));
+
+  std::vector<bool> touched(sparse.categoryCount, false);
+  for (std::size_t i = 0; i < layer.touched().size(); ++i) {
+    const int category = layer.touched()[i];
+    touched[category] = true;
+    REQUIRE(layer.embeddings_grad().col(i).isApprox(reference.weights_grad().col(2 + category)));
+  }
+  for (int category = 0; category < sparse.categoryCount; ++category) {
+    if (!touched[category]) {
+      REQUIRE(reference.weights_grad().col(2 + category).isZero());
+    }
+  }
+  REQUIRE(layer.touched().size() < static_cast<std::size_t>(sparse.categoryCount));
+
+  Matrix before = layer.embeddings();
+  layer.update(TestType(0.1));
+  for (int category = 0; category < sparse.categoryCount; ++category) {
+    const Matrix expectedColumn = before.col(category) - TestType(0.1) * reference.weights_grad().col(2 + category);
+    REQUIRE(layer.embeddings().col(category).isApprox(expectedColumn));
+    if (!touched[category]) {
+      REQUIRE(layer.embeddings().col(category) == before.col(category));
+    }
+  }
+}
+
+TEST_CASE("Sparse input layer feeds a network and receives its input gradient", "[SparseInputLayer]") {
+  using Matrix = Eigen::MatrixXd;
+
+  SparseInput<double> sparse = convert_to_sparse_input(make_records(16));
+  SparseInputLayer<double> embedding(2, sparse.categoryCount, 6, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+
+  Network<double> network;
+  network.addLayer(std::make_shared<Layer<double>>(6, 3, Initializer<>::Type::XAVIER, Activation<>::Type::NONE));
+
+  const Matrix& hidden = embedding.forward(sparse.continuous, sparse.categories);
+  const Matrix& output = network.forward(hidden);
+  const Matrix& dHidden = network.backward(output);
+
+  REQUIRE(dHidden.isApprox(network.layers().front()->weights().transpose() * output));
+  embedding.backward(dHidden);
+  REQUIRE(embedding.weights_grad().rows() == 6);
+}
+
+TEST_CASE("Sparse inputs reject categories outside the one-hot range", "[SparseInputLayer]") {
+  auto records = make_records(16);
+  records[3].categorical_features[1] = 9;
+  REQUIRE_THROWS_AS(convert_to_sparse_input(records), std::invalid_argument);
+  records[3].categorical_features[1] = -1;
+  REQUIRE_THROWS_AS(convert_to_sparse_input(records), std::invalid_argument);
+
+  const SparseInput<double> sparse = convert_to_sparse_input(make_records(16));
+  SparseInputLayer<double> embedding(2, sparse.categoryCount, 6, Initializer<>::Type::XAVIER, Activation<>::Type::RELU);
+  Eigen::MatrixXi categories = sparse.categories;
+  categories(0, 5) = sparse.categoryCount;
+  REQUIRE_THROWS_AS(embedding.forward(sparse.continuous, categories), std::invalid_argument);
+}
+
+TEST_CASE("Sparse input layer workspaces keep concurrent passes apart", "[SparseInputLayer]") {
+  using Matrix = Eigen::MatrixXd;
+
+  const SparseInput<double> sparse = convert_to_sparse_input(make_records(16));
+  SparseInputLayer<double> layer(2, sparse.categoryCount, 4, Initializer<>::Type::XAVIER, Activation<>::Type::TANH);
+  const Matrix dOutput = Matrix::Random(4, 8);
+
+  // Interleave two passes, each with its own workspace.
+  SparseInputLayer<double>::Workspace first;
+  SparseInputLayer<double>::Workspace second;
+  layer.forward(sparse.continuous.leftCols(8), sparse.categories.leftCols(8), first);
+  layer.forward(sparse.continuous.rightCols(8), sparse.categories.rightCols(8), second);
+  layer.backward(dOutput, first);
+  layer.backward(dOutput, second);
+
+  // They match the layer's own workspace, which they leave untouched.
+  REQUIRE(layer.touched().empty());
+  layer.forward(sparse.continuous.leftCols(8), sparse.categories.leftCols(8));
+  REQUIRE(layer.workspace().output == first.output);
+  layer.backward(dOutput);
+  REQUIRE(layer.weights_grad() == first.weights_grad);
+  REQUIRE(layer.touched() == first.touched);
+  REQUIRE(layer.embeddings_grad() == first.touchedGradients());
+
+  layer.forward(sparse.continuous.rightCols(8), sparse.categories.rightCols(8));
+  layer.backward(dOutput);
+  REQUIRE(layer.biases_grad() == second.biases_grad);
+  REQUIRE(layer.touched() == second.touched);
+  REQUIRE(layer.embeddings_grad() == second.touchedGradients());
+}
+
+TEST_CASE("Adam only updates the touched embeddings of a sparse input layer", "[SparseInputLayer]") {
+  using Matrix = Eigen::MatrixXd;
+
+  std::vector<StructRepresentation<2, 3>> records = make_records(20);
+  const Matrix dense = convert_to_matrix(records);
+  const SparseInput<double> sparse = convert_to_sparse_input(records);
+
+  SparseInputLayer<double> layer(2, sparse.categoryCount, 5, Initializer<>::Type::XAVIER, Activation<>::Type::TANH);
+  Matrix weights(5, dense.rows());
+  weights << layer.weights(), layer.embeddings();
+  Network<double> network;
+  network.addLayer(std::make_shared<Layer<double>>(weights, layer.biases(), Activation<>::Type::TANH));
+
+  // On a first step, untouched parameters have zero moments, so dense Adam leaves them as is too.
+  Adam<double> sparseAdam(0.01);
+  Adam<double> denseAdam(0.01);
+  const Matrix dOutput = Matrix::Random(5, 5);
+  layer.forward(sparse.continuous.leftCols(5), sparse.categories.leftCols(5));
+  layer.backward(dOutput);
+  sparseAdam.update(layer, layer.workspace());
+  network.forward(dense.leftCols(5));
+  network.backward(dOutput);
+  denseAdam.update(network);
+
+  const Layer<double>& reference = *network.layers().front();
+  REQUIRE(layer.weights().isApprox(reference.weights().leftCols(2)));
+  REQUIRE(layer.biases().isApprox(reference.biases()));
+  REQUIRE(layer.embeddings().isApprox(reference.weights().rightCols(sparse.categoryCount)));
+
+  // Later steps neither move nor decay the embeddings of the categories they do not see,
+  // even those whose moments are still nonzero from the first step.
+  const Matrix before = layer.embeddings();
+  layer.forward(sparse.continuous.col(5), sparse.categories.col(5));
+  layer.backward(Matrix::Random(5, 1));
+  sparseAdam.update(layer, layer.workspace());
+  AdamW<double> adamW(0.01, 0.1);
+  adamW.update(layer, layer.workspace());
+
+  std::vector<bool> seen(sparse.categoryCount, false);
+  for (int category : layer.touched()) {
+    seen[category] = true;
+  }
+  for (int category = 0; category < sparse.categoryCount; ++category) {
+    REQUIRE((layer.embeddings().col(category) == before.col(category)) == !seen[category]);
+  }
+}
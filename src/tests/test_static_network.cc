@@ -0,0 +1,79 @@
+#include "network/static_network.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace dmlfs;
+
+namespace {
+
+template <typename Scalar>
+using Iris = StaticNetwork<StaticLayer<4, 16, Activation<>::Type::RELU, Scalar>,
+                           StaticLayer<16, 8, Activation<>::Type::TANH, Scalar>,
+                           StaticLayer<8, 3, Activation<>::Type::SIGMOID, Scalar>>;
+
+const std::vector<int> kIrisSizes = {4, 16, 8, 3};
+const std::vector<ActivationBase::Type> kIrisActivations = {Activation<>::Type::RELU, Activation<>::Type::TANH, Activation<>::Type::SIGMOID};
+
+}  // namespace
+
+TEMPLATE_TEST_CASE("A static network computes the same outputs as the dynamic one", "[StaticNetwork]", float, double) {
+  using Matrix = Eigen::MatrixX<TestType>;
+
+  Network<TestType> network = make_mlp<TestType>(kIrisSizes, kIrisActivations, TestType(0.1));
+  const Iris<TestType> fixed(network);
+
+  const Matrix input = Matrix::Random(4, 25);
+  const Matrix expected = network.predict(input);
+
+  for (Eigen::Index j = 0; j < input.cols(); ++j) {
+    const Eigen::Vector4<TestType> sample = input.col(j);
+    const Eigen::Vector3<TestType> output = fixed.predict(sample);
+    REQUIRE(output.isApprox(expected.col(j), TestType(1e-5)));
+  }
+
+  Matrix batch(3, input.cols());
+  fixed.predict(input, batch);
+  REQUIRE(batch.isApprox(expected, TestType(1e-5)));
+}
+
+TEST_CASE("A static network can be loaded from a model file", "[StaticNetwork]") {
+  Network<double> network = make_mlp<double>(kIrisSizes, kIrisActivations, 0.1);
+  const auto path = std::filesystem::temp_directory_path() / "dmlfs_static_network.model";
+  network.save(path.string());
+
+  const auto fixed = Iris<double>::load(path.string());
+  std::filesystem::remove(path);
+
+  REQUIRE(fixed.layer<0>().weights == network.layers()[0]->weights());
+  REQUIRE(fixed.layer<2>().biases == network.layers()[2]->biases());
+
+  const Eigen::Vector4d sample = Eigen::Vector4d::Random();
+  REQUIRE(fixed.predict(sample).isApprox(network.predict(sample).col(0)));
+}
+
+TEST_CASE("A static network rejects networks of another shape", "[StaticNetwork]") {
+  Network<double> shallow;
+  shallow.addLayer(std::make_shared<Layer<double>>(4, 3, Initializer<>::Type::XAVIER, Activation<>::Type::SIGMOID));
+  REQUIRE_THROWS_AS(Iris<double>(shallow), std::invalid_argument);
+
+  Network<double> wider;
+  wider.addLayer(std::make_shared<Layer<double>>(4, 32, Initializer<>::Type::XAVIER, Activation<>::Type::RELU))
+       .addLayer(std::make_shared<Layer<double>>(32, 8, Initializer<>::Type::XAVIER, Activation<>::Type::TANH))
+       .addLayer(std::make_shared<Layer<double>>(8, 3, Initializer<>::Type::XAVIER, Activation<>::Type::SIGMOID));
+  REQUIRE_THROWS_AS(Iris<double>(wider), std::invalid_argument);
+
+  Network<double> otherActivation;
+  otherActivation.addLayer(std::make_shared<Layer<double>>(4, 16, Initializer<>::Type::XAVIER, Activation<>::Type::TANH))
+                 .addLayer(std::make_shared<Layer<double>>(16, 8, Initializer<>::Type::XAVIER, Activation<>::Type::TANH))
+                 .addLayer(std::make_shared<Layer<double>>(8, 3, Initializer<>::Type::XAVIER, Activation<>::Type::SIGMOID));
+  REQUIRE_THROWS_AS(Iris<double>(otherActivation), std::invalid_argument);
+}
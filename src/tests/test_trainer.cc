@@ -0,0 +1,156 @@
+#include "network/trainer.h"
+#include "network/loss_functions.h"
+#include "tests/test_helpers.h"
+
+#include "Eigen/Dense"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/catch_template_test_macros.hpp"
+
+using namespace dmlfs;
+
+TEST_CASE("A full-batch epoch without shuffling is a single optimizer step", "[Trainer]") {
+  using Matrix = Eigen::MatrixXd;
+
+  Matrix w1 = Matrix::Random(6, 3);
+  Matrix w2 = Matrix::Random(2, 6);
+  Matrix features = Matrix::Random(3, 20);
+  Matrix labels = Matrix::Random(2, 20);
+
+  Network<double> reference = make_network<double>(w1, w2);
+  SGD<double> referenceOptimizer(0.05);
+  const Matrix& output = reference.forward(features);
+  reference.backward(meanSquaredErrorDerivative<double>(labels, output));
+  referenceOptimizer.update(reference);
+
+  Network<double> network = make_network<double>(w1, w2);
+  SGD<double> optimizer(0.05);
+  Trainer<double> trainer(network, optimizer,
+                          meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                          20, Trainer<double>::Shuffle::NONE);
+  trainer.trainEpoch(features, labels);
+
+  for (std::size_t i = 0; i < network.layers().size(); ++i) {
+    REQUIRE(network.layers()[i]->weights().isApprox(reference.layers()[i]->weights()));
+    REQUIRE(network.layers()[i]->biases().isApprox(reference.layers()[i]->biases()));
+  }
+}
+
+TEMPLATE_TEST_CASE("Mini-batch training reduces the loss in every shuffle mode", "[Trainer]", float, double) {
+  using Matrix = typename Trainer<TestType>::Matrix;
+  using Shuffle = typename Trainer<TestType>::Shuffle;
+
+  Matrix features = Matrix::Random(3, 200);
+  Matrix target = Matrix::Random(2, 3);
+  Matrix labels = target * features;
+
+  for (Shuffle shuffle : {Shuffle::NONE, Shuffle::BATCHES, Shuffle::SAMPLES}) {
+    Network<TestType> network = make_network<TestType>(Matrix::Random(6, 3) * TestType(0.5), Matrix::Random(2, 6) * TestType(0.5));
+    SGD<TestType> optimizer(0.01);
+    Trainer<TestType> trainer(network, optimizer,
+                              meanSquaredError<TestType>, meanSquaredErrorDerivative<TestType>,
+                              16, shuffle, 42);
+
+    std::vector<EpochStats> stats = trainer.train(features, labels, 30);
+
+    REQUIRE(stats.size() == 30);
+    REQUIRE(stats.back().loss < 0.5 * stats.front().loss);
+    REQUIRE(stats.back().samplesPerSecond > 0.0);
+  }
+}
+
+TEST_CASE("Data-parallel training matches single-threaded training", "[Trainer]") {
+  using Matrix = Eigen::MatrixXd;
+
+  Matrix w1 = Matrix::Random(6, 3);
+  Matrix w2 = Matrix::Random(2, 6);
+  Matrix features = Matrix::Random(3, 100);
+  Matrix labels = Matrix::Random(2, 100);
+
+  Network<double> serial = make_network<double>(w1, w2);
+  SGD<double> serialOptimizer(0.01);
+  Trainer<double> serialTrainer(serial, serialOptimizer,
+                                meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                32, Trainer<double>::Shuffle::NONE);
+  std::vector<EpochStats> serialStats = serialTrainer.train(features, labels, 3);
+
+  for (int nThreads : {2, 3, 4}) {
+    Network<double> parallel = make_network<double>(w1, w2);
+    SGD<double> parallelOptimizer(0.01);
+    Trainer<double> parallelTrainer(parallel, parallelOptimizer,
+                                    meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                    32, Trainer<double>::Shuffle::NONE);
+    parallelTrainer.setNumThreads(nThreads);
+    std::vector<EpochStats> parallelStats = parallelTrainer.train(features, labels, 3);
+
+    for (std::size_t i = 0; i < parallel.layers().size(); ++i) {
+      REQUIRE(parallel.layers()[i]->weights().isApprox(serial.layers()[i]->weights(), 1e-10));
+      REQUIRE(parallel.layers()[i]->biases().isApprox(serial.layers()[i]->biases(), 1e-10));
+    }
+    REQUIRE(std::abs(parallelStats.back().loss - serialStats.back().loss) < 1e-10);
+  }
+}
+
+TEST_CASE("Hogwild training converges like synchronous training", "[Trainer]") {
+  using Matrix = Eigen::MatrixXd;
+  using Shuffle = Trainer<double>::Shuffle;
+  using Mode = Trainer<double>::Mode;
+
+  Matrix w1 = Matrix::Random(6, 3) * 0.5;
+  Matrix w2 = Matrix::Random(2, 6) * 0.5;
+  Matrix features = Matrix::Random(3, 400);
+  Matrix target = Matrix::Random(2, 3);
+  Matrix labels = target * features;
+
+  Network<double> synchronous = make_network<double>(w1, w2);
+  SGD<double> synchronousOptimizer(0.01);
+  Trainer<double> synchronousTrainer(synchronous, synchronousOptimizer,
+                                     meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                     16, Shuffle::SAMPLES, 7);
+  std::vector<EpochStats> synchronousStats = synchronousTrainer.train(features, labels, 30);
+
+  Network<double> hogwild = make_network<double>(w1, w2);
+  SGD<double> hogwildOptimizer(0.01);
+  Trainer<double> hogwildTrainer(hogwild, hogwildOptimizer,
+                                 meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                 16, Shuffle::SAMPLES, 7);
+  hogwildTrainer.setNumThreads(4);
+  hogwildTrainer.setMode(Mode::HOGWILD);
+  std::vector<EpochStats> hogwildStats = hogwildTrainer.train(features, labels, 30);
+
+  SECTION("Every mini-batch produces exactly one update") {
+    for (const EpochStats& stats : hogwildStats) {
+      REQUIRE(stats.updates == 25);
+      REQUIRE(stats.updatesPerSecond > 0.0);
+      REQUIRE(stats.maxStaleness < 25);
+      REQUIRE(stats.meanStaleness <= static_cast<double>(stats.maxStaleness));
+    }
+  }
+
+  SECTION("A single Hogwild worker never sees stale parameters") {
+    Network<double> single = make_network<double>(w1, w2);
+    SGD<double> singleOptimizer(0.01);
+    Trainer<double> singleTrainer(single, singleOptimizer,
+                                  meanSquaredError<double>, meanSquaredErrorDerivative<double>,
+                                  16, Shuffle::SAMPLES, 7);
+    singleTrainer.setNumThreads(1);
+    singleTrainer.setMode(Mode::HOGWILD);
+    for (const EpochStats& stats : singleTrainer.train(features, labels, 3)) {
+      REQUIRE(stats.updates == 25);
+      REQUIRE(stats.meanStaleness == 0.0);
+      REQUIRE(stats.maxStaleness == 0);
+    }
+  }
+
+  SECTION("Synchronous training never sees stale parameters") {
+    for (const EpochStats& stats : synchronousStats) {
+      REQUIRE(stats.meanStaleness == 0.0);
+      REQUIRE(stats.maxStaleness == 0);
+    }
+  }
+
+  SECTION("The loss reaches the same order of magnitude") {
+    REQUIRE(hogwildStats.back().loss < 0.5 * hogwildStats.front().loss);
+    REQUIRE(hogwildStats.back().loss < 2.0 * synchronousStats.back().loss + 1e-3);
+  }
+}